@@ -0,0 +1,104 @@
+/*
+  Benchmark: time per frame of cgif_addframe vs. cgif_addframe_rect on 1080p frames (e.g. a UI compositor that knows the changed area).
+  A small box moves over a static screen: cgif_addframe has to search the full frame for the change,
+  cgif_addframe_rect only the patch (or nothing with CGIF_FRAME_ATTR_EXACT_RECT).
+*/
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "cgif.h"
+
+#define WIDTH      1920
+#define HEIGHT     1080
+#define NUM_FRAMES 200
+#define BOX        64 // size of the moving box
+#define STEP       4  // movement per frame
+
+static int writeFn(void* pContext, const uint8_t* pData, const size_t numBytes) {
+  (void)pContext;
+  (void)pData;
+  (void)numBytes;
+  return 0;
+}
+
+/* draw the box of frame f (color 1 + f % 2 to the right of its old position) */
+static void drawBox(uint8_t* pImageData, int f) {
+  for(int y = 500; y < 500 + BOX; ++y) {
+    memset(pImageData + y * WIDTH + 100 + f * STEP, 1 + f % 2, BOX);
+  }
+}
+
+/* add all frames: full frames (mode 0), patches around the box (mode 1) or exact patches (mode 2) */
+static int run(const char* name, int mode, uint8_t* pImageData, uint8_t* pPatch) {
+  CGIF*            pGIF;
+  CGIF_Config      gConfig;
+  CGIF_FrameConfig fConfig;
+  uint8_t          aPalette[3 * 3] = { 0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0xFF };
+  clock_t          t;
+
+  memset(pImageData, 0, WIDTH * HEIGHT);
+  memset(&gConfig, 0, sizeof(gConfig));
+  gConfig.width                   = WIDTH;
+  gConfig.height                  = HEIGHT;
+  gConfig.pGlobalPalette          = aPalette;
+  gConfig.numGlobalPaletteEntries = 3;
+  gConfig.attrFlags               = CGIF_ATTR_IS_ANIMATED;
+  gConfig.pWriteFn                = writeFn;
+  pGIF = cgif_newgif(&gConfig);
+  if(pGIF == NULL) {
+    return 1;
+  }
+  t = clock();
+  for(int f = 0; f < NUM_FRAMES; ++f) {
+    const uint16_t left = 100 + ((f > 0) ? (f - 1) * STEP : 0); // patch: old and new position of the box
+    const uint16_t width = BOX + ((f > 0) ? STEP : 0);
+    int            r;
+
+    drawBox(pImageData, f);
+    memset(&fConfig, 0, sizeof(fConfig));
+    fConfig.delay    = 4;
+    fConfig.genFlags = CGIF_FRAME_GEN_USE_TRANSPARENCY | CGIF_FRAME_GEN_USE_DIFF_WINDOW;
+    if(mode == 0 || f == 0) {
+      fConfig.pImageData = pImageData;
+      r = cgif_addframe(pGIF, &fConfig);
+    } else {
+      for(int y = 0; y < BOX; ++y) {
+        memcpy(pPatch + y * width, pImageData + (500 + y) * WIDTH + left, width);
+      }
+      fConfig.pImageData = pPatch;
+      fConfig.attrFlags  = (mode == 2) ? CGIF_FRAME_ATTR_EXACT_RECT : 0;
+      r = cgif_addframe_rect(pGIF, &fConfig, left, 500, width, BOX);
+    }
+    if(r != CGIF_OK) {
+      cgif_close(pGIF);
+      return 1;
+    }
+  }
+  if(cgif_close(pGIF) != CGIF_OK) {
+    return 1;
+  }
+  t = clock() - t;
+  printf("%-12s %8.3f ms/frame\n", name, (double)t * 1000.0 / CLOCKS_PER_SEC / NUM_FRAMES);
+  return 0;
+}
+
+int main(void) {
+  uint8_t* pImageData = malloc(WIDTH * HEIGHT);
+  uint8_t* pPatch     = malloc((BOX + STEP) * BOX);
+  int      r;
+
+  if(pImageData == NULL || pPatch == NULL) {
+    free(pImageData);
+    free(pPatch);
+    return 1;
+  }
+  r  = run("full frame", 0, pImageData, pPatch);
+  r |= run("patch", 1, pImageData, pPatch);
+  r |= run("exact patch", 2, pImageData, pPatch);
+  free(pImageData);
+  free(pPatch);
+  return r;
+}
@@ -0,0 +1,127 @@
+/*
+  Benchmark: latency of cgif_addframe with and without CGIF_GEN_ASYNC_ENCODING (e.g. for screen capture).
+  A slow output (waiting per written frame) stands in for a slow disk or network, frames are captured every CAPTURE_MS.
+  In async mode, cgif_addframe only copies the frame: its latency does not depend on the encoding time.
+*/
+#if !defined(_WIN32)
+#define _POSIX_C_SOURCE 199309L // clock_gettime
+#endif
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "cgif.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+#endif
+
+#define WIDTH           640
+#define HEIGHT          480
+#define NUM_FRAMES      100
+#define WRITE_DELAY_MS  2   // time spent per written frame (output)
+#define CAPTURE_MS      5   // time between two captured frames
+
+/* wall-clock time (ms) */
+static double now(void) {
+#if defined(_WIN32)
+  return (double)clock() * 1000.0 / CLOCKS_PER_SEC; // wall-clock time on Windows
+#else
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+#endif
+}
+
+/* wait without using the CPU (I/O, capture device) */
+static void sleepMs(int ms) {
+#if defined(_WIN32)
+  Sleep(ms);
+#else
+  struct timespec ts = { ms / 1000, (ms % 1000) * 1000000L };
+  nanosleep(&ts, NULL);
+#endif
+}
+
+static int writeFn(void* pContext, const uint8_t* pData, const size_t numBytes) {
+  (void)pContext;
+  (void)pData;
+  (void)numBytes;
+  return 0;
+}
+
+static void frameStatsFn(void* pContext, const CGIF_FrameStats* pStats) {
+  (void)pContext;
+  (void)pStats;
+  sleepMs(WRITE_DELAY_MS); // slow output
+}
+
+/* add all frames and measure the time spent in cgif_addframe */
+static int run(const char* name, uint32_t genFlags, uint8_t* pImageData) {
+  CGIF*            pGIF;
+  CGIF_Config      gConfig;
+  CGIF_FrameConfig fConfig;
+  uint8_t          aPalette[4 * 3] = { 0x00, 0x00, 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0xFF };
+  double           tMax = 0, tSum = 0, tTotal;
+  double           tStart = now();
+
+  memset(&gConfig, 0, sizeof(gConfig));
+  gConfig.width                   = WIDTH;
+  gConfig.height                  = HEIGHT;
+  gConfig.pGlobalPalette          = aPalette;
+  gConfig.numGlobalPaletteEntries = 4;
+  gConfig.attrFlags               = CGIF_ATTR_IS_ANIMATED;
+  gConfig.genFlags                = genFlags;
+  gConfig.pWriteFn                = writeFn;
+  gConfig.pFrameStatsFn           = frameStatsFn;
+  pGIF = cgif_newgif(&gConfig);
+  if(pGIF == NULL) {
+    return 1;
+  }
+  for(int f = 0; f < NUM_FRAMES; ++f) {
+    double t0, t;
+    sleepMs(CAPTURE_MS); // capture the next frame
+    // a few changing blocks per frame
+    for(int i = 0; i < 8; ++i) {
+      const int left = (f * 37 + i * 71) % (WIDTH - 32), top = (f * 13 + i * 53) % (HEIGHT - 32);
+      for(int y = top; y < top + 32; ++y) {
+        memset(pImageData + y * WIDTH + left, (f + i) % 4, 32);
+      }
+    }
+    memset(&fConfig, 0, sizeof(fConfig));
+    fConfig.pImageData = pImageData;
+    fConfig.delay      = 4;
+    fConfig.genFlags   = CGIF_FRAME_GEN_USE_TRANSPARENCY | CGIF_FRAME_GEN_USE_DIFF_WINDOW;
+    t0 = now();
+    if(cgif_addframe(pGIF, &fConfig) != CGIF_OK) {
+      cgif_close(pGIF);
+      return 1;
+    }
+    t     = now() - t0;
+    tSum += t;
+    tMax  = (t > tMax) ? t : tMax;
+  }
+  if(cgif_close(pGIF) != CGIF_OK) {
+    return 1;
+  }
+  tTotal = now() - tStart;
+  printf("%-6s cgif_addframe: %8.3f ms/frame (max %8.3f ms), total incl. cgif_close: %8.1f ms\n", name, tSum / NUM_FRAMES, tMax, tTotal);
+  return 0;
+}
+
+int main(void) {
+  uint8_t* pImageData = malloc(WIDTH * HEIGHT);
+  int      r;
+
+  if(pImageData == NULL) {
+    return 1;
+  }
+  memset(pImageData, 0, WIDTH * HEIGHT);
+  r  = run("sync", 0, pImageData);
+  memset(pImageData, 0, WIDTH * HEIGHT);
+  r |= run("async", CGIF_GEN_ASYNC_ENCODING, pImageData);
+  free(pImageData);
+  return r;
+}
@@ -0,0 +1,94 @@
+/*
+  Benchmark: throughput of the diff area detection (CGIF_FRAME_GEN_USE_DIFF_WINDOW) on 1080p frames.
+  The throughput is compared with a plain memcmp() over both frames (memory bandwidth bound).
+*/
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "cgif.h"
+#include "cgif_raw.h"
+
+/* compile the sources directly to benchmark the (static) diff area detection */
+#include "../src/cgif_raw.c"
+/* avoid duplicate static function name */
+#define calcNextPower2Ex cgif_calcNextPower2Ex
+#include "../src/cgif.c"
+#undef calcNextPower2Ex
+
+#define WIDTH    1920
+#define HEIGHT   1080
+#define NUM_REPS 200
+
+typedef struct {
+  const char* name;
+  uint16_t    left, top, width, height; // changed area
+} Scenario;
+
+static const Scenario aScenario[] = {
+  { "center_pixel", WIDTH / 2, HEIGHT / 2,  1,   1   }, // every row has to be scanned completely
+  { "small_box",    900,       500,         64,  64  },
+  { "wide_band",    0,         400,         WIDTH, 200 },
+  { "two_corners",  0,         0,           WIDTH, HEIGHT }, // only the corner pixels differ
+};
+
+int main(void) {
+  CGIF             gif;
+  CGIF_FrameConfig cur, bef;
+  DimResult        res;
+  uint8_t          aPalette[2 * 3] = { 0x00, 0x00, 0x00, 0xFF, 0xFF, 0xFF };
+  uint8_t*         pCurData = malloc(WIDTH * HEIGHT);
+  uint8_t*         pBefData = malloc(WIDTH * HEIGHT);
+  const double     numBytes = 2.0 * WIDTH * HEIGHT * NUM_REPS; // both frames are read
+  volatile int     sink = 0;
+  clock_t          t0;
+  double           tMemcmp;
+
+  if(pCurData == NULL || pBefData == NULL) {
+    return 1;
+  }
+  memset(&gif, 0, sizeof(gif));
+  gif.config.width                   = WIDTH;
+  gif.config.height                  = HEIGHT;
+  gif.config.pGlobalPalette          = aPalette;
+  gif.config.numGlobalPaletteEntries = 2;
+  memset(&cur, 0, sizeof(cur));
+  memset(&bef, 0, sizeof(bef));
+  cur.pImageData = pCurData;
+  bef.pImageData = pBefData;
+  memset(pBefData, 0, WIDTH * HEIGHT);
+
+  // reference: memcmp over the full frames
+  memset(pCurData, 0, WIDTH * HEIGHT);
+  pCurData[WIDTH * HEIGHT - 1] = 1;
+  t0 = clock();
+  for(int i = 0; i < NUM_REPS; ++i) {
+    sink += memcmp(pCurData, pBefData, WIDTH * HEIGHT);
+  }
+  tMemcmp = (double)(clock() - t0) / CLOCKS_PER_SEC;
+  printf("%-14s %10.2f GB/s\n", "memcmp", numBytes / tMemcmp / 1e9);
+
+  for(size_t s = 0; s < sizeof(aScenario) / sizeof(aScenario[0]); ++s) {
+    const Scenario* pS = &aScenario[s];
+    double          t;
+
+    memset(pCurData, 0, WIDTH * HEIGHT);
+    pCurData[MULU16(pS->top, WIDTH) + pS->left] = 1;
+    pCurData[MULU16(pS->top + pS->height - 1, WIDTH) + pS->left + pS->width - 1] = 1;
+    t0 = clock();
+    for(int i = 0; i < NUM_REPS; ++i) {
+      sink += getDiffArea(&gif, &cur, &bef, &res, NULL);
+    }
+    t = (double)(clock() - t0) / CLOCKS_PER_SEC;
+    if(res.left != pS->left || res.top != pS->top || res.width != pS->width || res.height != pS->height) {
+      fprintf(stderr, "%s: wrong diff area\n", pS->name);
+      return 2;
+    }
+    printf("%-14s %10.2f GB/s %8.3f ms/frame\n", pS->name, numBytes / t / 1e9, 1000.0 * t / NUM_REPS);
+  }
+  free(pCurData);
+  free(pBefData);
+  return (sink == -1) ? 3 : 0;
+}
@@ -0,0 +1,140 @@
+/*
+  Benchmark: error of cgif_estimate_size() against the real size of the LZW-encoded image data.
+  The corpus mirrors the image patterns used in tests/ (noise, stripes, gradients, snake, ...) at different sizes.
+*/
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "cgif.h"
+
+typedef struct {
+  const char* name;
+  uint16_t    width;
+  uint16_t    height;
+  uint16_t    numColors;
+  int         pattern;
+} CorpusEntry;
+
+enum {
+  PATTERN_NOISE,
+  PATTERN_STRIPES_H,
+  PATTERN_STRIPES_V,
+  PATTERN_GRADIENT,
+  PATTERN_SNAKE,
+  PATTERN_RANDOM_WALK,
+  PATTERN_BLOCKS,
+};
+
+static const CorpusEntry aCorpus[] = {
+  { "noise2_100",          100,  100,   2, PATTERN_NOISE       },
+  { "noise6_100",          100,  100,   6, PATTERN_NOISE       },
+  { "noise256_100",        100,  100, 256, PATTERN_NOISE       },
+  { "noise256_1000",      1000, 1000, 256, PATTERN_NOISE       },
+  { "stripes_h_1000",     1000, 1000,   4, PATTERN_STRIPES_H   },
+  { "stripes_v_1000",     1000, 1000,  16, PATTERN_STRIPES_V   },
+  { "gradient_256",        256,  256, 256, PATTERN_GRADIENT    },
+  { "gradient_1920",      1920, 1080, 256, PATTERN_GRADIENT    },
+  { "snake_1000",         1000, 1000,   3, PATTERN_SNAKE       },
+  { "random_walk_640",     640,  480,  64, PATTERN_RANDOM_WALK },
+  { "random_walk_1920",   1920, 1080, 256, PATTERN_RANDOM_WALK },
+  { "blocks_1920",        1920, 1080,  32, PATTERN_BLOCKS      },
+};
+
+static uint32_t nextRand(uint32_t* pSeed) {
+  *pSeed = *pSeed * 1103515245 + 12345;
+  return (*pSeed >> 16) & 0x7FFF;
+}
+
+static void fillImage(uint8_t* pImageData, const CorpusEntry* pEntry) {
+  const uint16_t w = pEntry->width;
+  const uint16_t h = pEntry->height;
+  uint32_t       seed = 1;
+  int            v = 0;
+
+  for(uint32_t y = 0; y < h; ++y) {
+    for(uint32_t x = 0; x < w; ++x) {
+      uint8_t* p = &pImageData[y * w + x];
+      switch(pEntry->pattern) {
+      case PATTERN_NOISE:       *p = nextRand(&seed) % pEntry->numColors; break;
+      case PATTERN_STRIPES_H:   *p = (y / 7) % pEntry->numColors; break;
+      case PATTERN_STRIPES_V:   *p = (x / 3) % pEntry->numColors; break;
+      case PATTERN_GRADIENT:    *p = ((x + y) * pEntry->numColors / (w + h)) % pEntry->numColors; break;
+      case PATTERN_SNAKE:       *p = (((y / 10) % 2) ? (x / 25) : ((w - x) / 25)) % pEntry->numColors; break;
+      case PATTERN_RANDOM_WALK:
+        v += (int)(nextRand(&seed) % 3) - 1;
+        v  = (v < 0) ? 0 : (v >= pEntry->numColors) ? pEntry->numColors - 1 : v;
+        *p = v;
+        break;
+      case PATTERN_BLOCKS:      *p = ((x / 64) * 7 + (y / 64) * 3) % pEntry->numColors; break;
+      }
+    }
+  }
+}
+
+static int writeFn(void* pContext, const uint8_t* pData, const size_t numBytes) {
+  (void)pContext;
+  (void)pData;
+  (void)numBytes;
+  return 0;
+}
+
+static void frameStatsFn(void* pContext, const CGIF_FrameStats* pStats) {
+  *(uint32_t*)pContext = pStats->sizeRasterData;
+}
+
+int main(void) {
+  CGIF_Config      gConfig;
+  CGIF_FrameConfig fConfig;
+  uint8_t          aPalette[256 * 3];
+  double           sumAbsErr = 0, maxAbsErr = 0;
+  const int        numEntries = sizeof(aCorpus) / sizeof(aCorpus[0]);
+
+  memset(aPalette, 0, sizeof(aPalette));
+  printf("%-20s %10s %10s %10s %8s %10s %10s\n", "image", "pixels", "real", "estimate", "error", "t_real", "t_est");
+  for(int i = 0; i < numEntries; ++i) {
+    const CorpusEntry* pEntry = &aCorpus[i];
+    uint8_t*           pImageData = malloc((size_t)pEntry->width * pEntry->height);
+    uint32_t           realSize = 0, estSize = 0;
+    clock_t            t0, t1, t2;
+
+    if(pImageData == NULL) {
+      return 1;
+    }
+    fillImage(pImageData, pEntry);
+    // real size: encode a single frame GIF and get the raster size via the per-frame statistics
+    memset(&gConfig, 0, sizeof(CGIF_Config));
+    memset(&fConfig, 0, sizeof(CGIF_FrameConfig));
+    gConfig.width                   = pEntry->width;
+    gConfig.height                  = pEntry->height;
+    gConfig.pGlobalPalette          = aPalette;
+    gConfig.numGlobalPaletteEntries = pEntry->numColors;
+    gConfig.pWriteFn                = writeFn;
+    gConfig.pFrameStatsFn           = frameStatsFn;
+    gConfig.pContext                = &realSize;
+    fConfig.pImageData              = pImageData;
+    t0 = clock();
+    CGIF* pGIF = cgif_newgif(&gConfig);
+    if(pGIF == NULL || cgif_addframe(pGIF, &fConfig) != CGIF_OK || cgif_close(pGIF) != CGIF_OK) {
+      free(pImageData);
+      return 2;
+    }
+    t1 = clock();
+    if(cgif_estimate_size(pImageData, pEntry->width, pEntry->height, pEntry->numColors, &estSize) != CGIF_OK) {
+      free(pImageData);
+      return 3;
+    }
+    t2 = clock();
+    free(pImageData);
+    const double err = 100.0 * ((double)estSize - realSize) / realSize;
+    const double absErr = (err < 0) ? -err : err;
+    sumAbsErr += absErr;
+    maxAbsErr  = (absErr > maxAbsErr) ? absErr : maxAbsErr;
+    printf("%-20s %10lu %10lu %10lu %7.2f%% %8.2fms %8.2fms\n", pEntry->name, (unsigned long)pEntry->width * pEntry->height, (unsigned long)realSize, (unsigned long)estSize, err,
+           1000.0 * (t1 - t0) / CLOCKS_PER_SEC, 1000.0 * (t2 - t1) / CLOCKS_PER_SEC);
+  }
+  printf("mean absolute error: %.2f%%, max absolute error: %.2f%%\n", sumAbsErr / numEntries, maxAbsErr);
+  return 0;
+}
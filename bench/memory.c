@@ -0,0 +1,177 @@
+/*
+  Benchmark: peak heap memory of an encode (4K indexed frames, 1080p RGB frames with alpha channel).
+  Compares the default settings with the lean mode (CGIF_GEN_LOW_MEMORY).
+*/
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "cgif.h"
+#include "cgif_raw.h"
+
+#define WIDTH      3840
+#define HEIGHT     2160
+#define RGB_WIDTH  1920
+#define RGB_HEIGHT 1080
+#define NUM_FRAMES 8
+
+/* allocator that keeps track of the heap memory in use (size stored in front of each block) */
+#define ALLOC_HEADER (sizeof(size_t) > 16 ? sizeof(size_t) : 16) // keep the alignment of malloc
+static size_t sizeInUse;
+static size_t sizePeak;
+
+static void* bench_malloc(size_t size) {
+  uint8_t* p = malloc(size + ALLOC_HEADER);
+  if(p == NULL) {
+    return NULL;
+  }
+  memcpy(p, &size, sizeof(size_t));
+  sizeInUse += size;
+  sizePeak   = (sizeInUse > sizePeak) ? sizeInUse : sizePeak;
+  return p + ALLOC_HEADER;
+}
+
+static void bench_free(void* ptr) {
+  size_t size;
+  if(ptr) {
+    memcpy(&size, (uint8_t*)ptr - ALLOC_HEADER, sizeof(size_t));
+    sizeInUse -= size;
+    free((uint8_t*)ptr - ALLOC_HEADER);
+  }
+}
+
+static void* bench_realloc(void* ptr, size_t size) {
+  void*  pNew = bench_malloc(size);
+  size_t sizeOld;
+  if(pNew && ptr) {
+    memcpy(&sizeOld, (uint8_t*)ptr - ALLOC_HEADER, sizeof(size_t));
+    memcpy(pNew, ptr, (sizeOld < size) ? sizeOld : size);
+    bench_free(ptr);
+  }
+  return pNew;
+}
+
+/* compile the sources directly to count their allocations */
+#define malloc(s)     bench_malloc(s)
+#define realloc(p, s) bench_realloc(p, s)
+#define free(p)       bench_free(p)
+#include "../src/cgif_raw.c"
+/* avoid duplicate static function name */
+#define calcNextPower2Ex cgif_calcNextPower2Ex
+#include "../src/cgif.c"
+#undef calcNextPower2Ex
+#include "../src/cgif_rgb.c"
+#undef free
+#undef realloc
+#undef malloc
+
+static int writeFn(void* pContext, const uint8_t* pData, const size_t numBytes) {
+  (void)pContext;
+  (void)pData;
+  (void)numBytes;
+  return 0;
+}
+
+/* indexed API: a square moving over a gradient */
+static int runIndexed(const char* name, uint32_t genFlags, uint8_t* pImageData) {
+  CGIF*            pGIF;
+  CGIF_Config      gConfig;
+  CGIF_FrameConfig fConfig;
+  uint8_t          aPalette[256 * 3];
+  int              r = 0;
+
+  for(int i = 0; i < 256; ++i) {
+    aPalette[i * 3]     = i;
+    aPalette[i * 3 + 1] = 255 - i;
+    aPalette[i * 3 + 2] = i / 2;
+  }
+  sizeInUse = 0;
+  sizePeak  = 0;
+  memset(&gConfig, 0, sizeof(gConfig));
+  gConfig.width                   = WIDTH;
+  gConfig.height                  = HEIGHT;
+  gConfig.pGlobalPalette          = aPalette;
+  gConfig.numGlobalPaletteEntries = 256;
+  gConfig.attrFlags               = CGIF_ATTR_IS_ANIMATED;
+  gConfig.genFlags                = genFlags;
+  gConfig.pWriteFn                = writeFn;
+  pGIF = cgif_newgif(&gConfig);
+  if(pGIF == NULL) {
+    return 1;
+  }
+  for(int f = 0; f < NUM_FRAMES && !r; ++f) {
+    for(int y = 0; y < HEIGHT; ++y) {
+      for(int x = 0; x < WIDTH; ++x) {
+        pImageData[y * WIDTH + x] = (x >= 100 * f && x < 100 * f + 200 && y >= 1000 && y < 1200) ? 255 : (x + y) / 32 % 255;
+      }
+    }
+    memset(&fConfig, 0, sizeof(fConfig));
+    fConfig.pImageData = pImageData;
+    fConfig.delay      = 4;
+    fConfig.genFlags   = CGIF_FRAME_GEN_USE_TRANSPARENCY | CGIF_FRAME_GEN_USE_DIFF_WINDOW;
+    r = (cgif_addframe(pGIF, &fConfig) != CGIF_OK);
+  }
+  r |= (cgif_close(pGIF) != CGIF_OK);
+  printf("%-24s peak heap: %7.1f MB (%4.1f bytes/pixel)\n", name, sizePeak / 1e6, (double)sizePeak / (WIDTH * HEIGHT));
+  return r;
+}
+
+/* RGB API: RGBA frames (transparent border), a square moving over a gradient with more than 256 colors */
+static int runRGB(const char* name, uint32_t genFlags, uint8_t* pImageData) {
+  CGIFrgb*            pGIF;
+  CGIFrgb_Config      gConfig;
+  CGIFrgb_FrameConfig fConfig;
+  int                 r = 0;
+
+  sizeInUse = 0;
+  sizePeak  = 0;
+  memset(&gConfig, 0, sizeof(gConfig));
+  gConfig.width    = RGB_WIDTH;
+  gConfig.height   = RGB_HEIGHT;
+  gConfig.genFlags = genFlags;
+  gConfig.pWriteFn = writeFn;
+  pGIF = cgif_rgb_newgif(&gConfig);
+  if(pGIF == NULL) {
+    return 1;
+  }
+  for(int f = 0; f < NUM_FRAMES && !r; ++f) {
+    for(int y = 0; y < RGB_HEIGHT; ++y) {
+      for(int x = 0; x < RGB_WIDTH; ++x) {
+        uint8_t* p = pImageData + (y * RGB_WIDTH + x) * 4;
+        const int isSquare = (x >= 50 * f && x < 50 * f + 100 && y >= 500 && y < 600);
+        p[0] = (isSquare) ? 255 : x / 8;
+        p[1] = (isSquare) ? 0 : y / 8;
+        p[2] = (isSquare) ? 0 : (x + y) / 16;
+        p[3] = (x < 10) ? 0 : 255;
+      }
+    }
+    memset(&fConfig, 0, sizeof(fConfig));
+    fConfig.pImageData = pImageData;
+    fConfig.fmtChan    = CGIF_CHAN_FMT_RGBA;
+    fConfig.delay      = 4;
+    r = (cgif_rgb_addframe(pGIF, &fConfig) != CGIF_OK);
+  }
+  r |= (cgif_rgb_close(pGIF) != CGIF_OK);
+  printf("%-24s peak heap: %7.1f MB (%4.1f bytes/pixel)\n", name, sizePeak / 1e6, (double)sizePeak / (RGB_WIDTH * RGB_HEIGHT));
+  return r;
+}
+
+int main(void) {
+  uint8_t* pImageData = malloc(WIDTH * HEIGHT);
+  uint8_t* pRGB       = malloc(RGB_WIDTH * RGB_HEIGHT * 4);
+  int      r;
+
+  if(pImageData == NULL || pRGB == NULL) {
+    free(pImageData);
+    free(pRGB);
+    return 1;
+  }
+  r  = runIndexed("indexed 4K", 0, pImageData);
+  r |= runIndexed("indexed 4K, low memory", CGIF_GEN_LOW_MEMORY, pImageData);
+  r |= runRGB("rgba 1080p", 0, pRGB);
+  r |= runRGB("rgba 1080p, low memory", CGIF_GEN_LOW_MEMORY, pRGB);
+  free(pImageData);
+  free(pRGB);
+  return r;
+}
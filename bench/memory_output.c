@@ -0,0 +1,151 @@
+/*
+  Benchmark: GIFs encoded to memory (e.g. for an HTTP response), many small animations.
+  Compares the memory output of cgif (CGIF_GEN_MEMORY_OUTPUT + cgif_take_output) with a growable buffer
+  filled by pWriteFn and copied out at the end.
+*/
+#if !defined(_WIN32)
+#define _POSIX_C_SOURCE 199309L // clock_gettime
+#endif
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "cgif.h"
+
+#define WIDTH      64
+#define HEIGHT     64
+#define NUM_FRAMES 8
+#define NUM_GIFS   2000
+
+typedef struct {
+  uint8_t* pData;
+  size_t   sizeData;
+  size_t   capData;
+} ByteBuffer;
+
+/* wall-clock time (ms) */
+static double now(void) {
+#if defined(_WIN32)
+  return (double)clock() * 1000.0 / CLOCKS_PER_SEC; // wall-clock time on Windows
+#else
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+#endif
+}
+
+/* growable buffer (doubles whenever it is full) */
+static int writeFn(void* pContext, const uint8_t* pData, const size_t numBytes) {
+  ByteBuffer* pBuf = (ByteBuffer*)pContext;
+  if(pBuf->sizeData + numBytes > pBuf->capData) {
+    size_t   capNew = (pBuf->capData) ? pBuf->capData : 4096;
+    uint8_t* pNew;
+    while(capNew < pBuf->sizeData + numBytes) {
+      capNew *= 2;
+    }
+    pNew = realloc(pBuf->pData, capNew);
+    if(pNew == NULL) {
+      return -1;
+    }
+    pBuf->pData   = pNew;
+    pBuf->capData = capNew;
+  }
+  memcpy(pBuf->pData + pBuf->sizeData, pData, numBytes);
+  pBuf->sizeData += numBytes;
+  return 0;
+}
+
+/* encode one animation (a square moving over a gradient) to memory. returns the GIF or NULL on error */
+static uint8_t* encodeGIF(int isMemoryOutput, const uint8_t* aImages, size_t* pSize) {
+  CGIF*            pGIF;
+  CGIF_Config      gConfig;
+  CGIF_FrameConfig fConfig;
+  ByteBuffer       buf = {NULL, 0, 0};
+  uint8_t          aPalette[16 * 3];
+  uint8_t*         pData = NULL;
+
+  for(int i = 0; i < 16; ++i) {
+    aPalette[i * 3]     = i * 16;
+    aPalette[i * 3 + 1] = 255 - i * 16;
+    aPalette[i * 3 + 2] = i * 8;
+  }
+  memset(&gConfig, 0, sizeof(gConfig));
+  gConfig.width                   = WIDTH;
+  gConfig.height                  = HEIGHT;
+  gConfig.pGlobalPalette          = aPalette;
+  gConfig.numGlobalPaletteEntries = 16;
+  gConfig.attrFlags               = CGIF_ATTR_IS_ANIMATED;
+  gConfig.genFlags                = (isMemoryOutput) ? CGIF_GEN_MEMORY_OUTPUT : 0;
+  gConfig.pWriteFn                = (isMemoryOutput) ? NULL : writeFn;
+  gConfig.pContext                = &buf;
+  pGIF = cgif_newgif(&gConfig);
+  if(pGIF == NULL) {
+    return NULL;
+  }
+  for(int f = 0; f < NUM_FRAMES; ++f) {
+    memset(&fConfig, 0, sizeof(fConfig));
+    fConfig.pImageData = (uint8_t*)aImages + f * WIDTH * HEIGHT;
+    fConfig.delay      = 4;
+    fConfig.genFlags   = CGIF_FRAME_GEN_USE_TRANSPARENCY | CGIF_FRAME_GEN_USE_DIFF_WINDOW;
+    cgif_addframe(pGIF, &fConfig);
+  }
+  if(isMemoryOutput) {
+    cgif_take_output(pGIF, &pData, pSize);
+    if(cgif_close(pGIF) != CGIF_OK) {
+      free(pData);
+      return NULL;
+    }
+    return pData;
+  }
+  // callback: the result is copied out of the buffer (e.g. into a response body of its exact size)
+  if(cgif_close(pGIF) == CGIF_OK) {
+    pData = malloc(buf.sizeData);
+    if(pData) {
+      memcpy(pData, buf.pData, buf.sizeData);
+      *pSize = buf.sizeData;
+    }
+  }
+  free(buf.pData);
+  return pData;
+}
+
+static int run(const char* name, int isMemoryOutput, const uint8_t* aImages) {
+  size_t   sizeTotal = 0;
+  size_t   size;
+  uint8_t* pData;
+  double   t = now();
+
+  for(int i = 0; i < NUM_GIFS; ++i) {
+    pData = encodeGIF(isMemoryOutput, aImages, &size);
+    if(pData == NULL) {
+      return 1;
+    }
+    sizeTotal += size;
+    free(pData);
+  }
+  t = now() - t;
+  printf("%-20s %8.2f ms (%6.1f us per GIF, %d bytes)\n", name, t, t * 1000.0 / NUM_GIFS, (int)(sizeTotal / NUM_GIFS));
+  return 0;
+}
+
+int main(void) {
+  uint8_t* aImages = malloc(NUM_FRAMES * WIDTH * HEIGHT);
+  int      r;
+
+  if(aImages == NULL) {
+    return 1;
+  }
+  for(int f = 0; f < NUM_FRAMES; ++f) {
+    for(int y = 0; y < HEIGHT; ++y) {
+      for(int x = 0; x < WIDTH; ++x) {
+        aImages[(f * HEIGHT + y) * WIDTH + x] = (x >= 6 * f && x < 6 * f + 12 && y >= 20 && y < 32) ? 15 : (x + y) / 9 % 15;
+      }
+    }
+  }
+  r  = run("pWriteFn + copy", 0, aImages);
+  r |= run("memory output", 1, aImages);
+  free(aImages);
+  return r;
+}
@@ -0,0 +1,122 @@
+/*
+  Benchmark: write calls per frame and encoding time of path-based output (CGIF_Config.path).
+  Compares stdio (CGIF_GEN_NO_OUTPUT_BUFFER) with the output buffer of cgif (default and small sizes), written by the encoding thread
+  or by a writer thread (CGIF_GEN_ASYNC_OUTPUT: the time of the write calls overlaps with encoding).
+  The write calls are counted by the kernel (syscw of /proc/self/io, Linux only).
+*/
+#if !defined(_WIN32)
+#define _POSIX_C_SOURCE 199309L // clock_gettime
+#endif
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "cgif.h"
+
+#define WIDTH      640
+#define HEIGHT     360
+#define NUM_FRAMES 200
+#define OUT_PATH   "bench_output_buffer.gif"
+
+/* wall-clock time (ms) */
+static double now(void) {
+#if defined(_WIN32)
+  return (double)clock() * 1000.0 / CLOCKS_PER_SEC; // wall-clock time on Windows
+#else
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+#endif
+}
+
+/* number of write system calls of the process so far (-1 if unknown) */
+static long countWriteCalls(void) {
+  FILE* pFile = fopen("/proc/self/io", "r");
+  char  aLine[64];
+  long  n = -1;
+
+  if(pFile == NULL) {
+    return -1;
+  }
+  while(fgets(aLine, sizeof(aLine), pFile)) {
+    if(sscanf(aLine, "syscw: %ld", &n) == 1) {
+      break;
+    }
+  }
+  fclose(pFile);
+  return n;
+}
+
+/* a square moving over a gradient, with noise in every 10th frame (scene change) */
+static int run(const char* name, uint32_t sizeOutputBuffer, uint32_t genFlags, uint8_t* pImageData) {
+  CGIF*            pGIF;
+  CGIF_Config      gConfig;
+  CGIF_FrameConfig fConfig;
+  uint8_t          aPalette[256 * 3];
+  uint32_t         seed = 1;
+  long             numCalls;
+  double           t;
+  int              r = 0;
+
+  for(int i = 0; i < 256; ++i) {
+    aPalette[i * 3]     = i;
+    aPalette[i * 3 + 1] = 255 - i;
+    aPalette[i * 3 + 2] = i / 2;
+  }
+  memset(&gConfig, 0, sizeof(gConfig));
+  gConfig.width                   = WIDTH;
+  gConfig.height                  = HEIGHT;
+  gConfig.pGlobalPalette          = aPalette;
+  gConfig.numGlobalPaletteEntries = 256;
+  gConfig.attrFlags               = CGIF_ATTR_IS_ANIMATED;
+  gConfig.genFlags                = genFlags;
+  gConfig.sizeOutputBuffer        = sizeOutputBuffer;
+  gConfig.path                    = OUT_PATH;
+  numCalls = countWriteCalls();
+  t        = now();
+  pGIF     = cgif_newgif(&gConfig);
+  if(pGIF == NULL) {
+    return 1;
+  }
+  for(int f = 0; f < NUM_FRAMES && !r; ++f) {
+    for(int y = 0; y < HEIGHT; ++y) {
+      for(int x = 0; x < WIDTH; ++x) {
+        seed = seed * 1103515245 + 12345;
+        pImageData[y * WIDTH + x] = (x >= 3 * f && x < 3 * f + 40 && y >= 150 && y < 190) ? 255 : (x + y) / 8 % 200 + ((f % 10 == 0) ? (seed >> 16) % 8 : 0);
+      }
+    }
+    memset(&fConfig, 0, sizeof(fConfig));
+    fConfig.pImageData = pImageData;
+    fConfig.delay      = 4;
+    fConfig.genFlags   = CGIF_FRAME_GEN_USE_TRANSPARENCY | CGIF_FRAME_GEN_USE_DIFF_WINDOW;
+    r = (cgif_addframe(pGIF, &fConfig) != CGIF_OK);
+  }
+  r |= (cgif_close(pGIF) != CGIF_OK);
+  t = now() - t;
+  if(numCalls >= 0) {
+    printf("%-28s %7.2f write calls/frame, %8.2f ms\n", name, (double)(countWriteCalls() - numCalls) / NUM_FRAMES, t);
+  } else {
+    printf("%-28s (write calls unknown), %8.2f ms\n", name, t);
+  }
+  return r;
+}
+
+int main(void) {
+  uint8_t* pImageData = malloc(WIDTH * HEIGHT);
+  int      r;
+
+  if(pImageData == NULL) {
+    return 1;
+  }
+  r  = run("stdio", 0, CGIF_GEN_NO_OUTPUT_BUFFER, pImageData);
+  r |= run("output buffer 16 KB", 16 * 1024, 0, pImageData);
+  r |= run("output buffer 256 KB", 0, 0, pImageData);
+  r |= run("output buffer 256 KB, hints", 0, CGIF_GEN_OUTPUT_HINTS, pImageData);
+  r |= run("writer thread 16 KB", 16 * 1024, CGIF_GEN_ASYNC_OUTPUT, pImageData);
+  r |= run("writer thread 256 KB", 0, CGIF_GEN_ASYNC_OUTPUT, pImageData);
+  remove(OUT_PATH);
+  free(pImageData);
+  return r;
+}
@@ -0,0 +1,104 @@
+/*
+  Benchmark: time per frame of 4K frames with a tiny change (e.g. a cursor moving over a static screen).
+  Compares the full frames (default), hashes their tiles (CGIF_GEN_TILE_HASH) and passes the dirty tiles (cgif_addframe_tiles, no hashing).
+*/
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "cgif.h"
+
+#define WIDTH       3840
+#define HEIGHT      2160
+#define NUM_FRAMES  60
+#define CURSOR      16 // size of the cursor
+#define STEP        5  // movement per frame
+#define NUM_TILES_X ((WIDTH + CGIF_TILE_SIZE - 1) / CGIF_TILE_SIZE)
+#define NUM_TILES   (NUM_TILES_X * ((HEIGHT + CGIF_TILE_SIZE - 1) / CGIF_TILE_SIZE))
+
+static int writeFn(void* pContext, const uint8_t* pData, const size_t numBytes) {
+  (void)pContext;
+  (void)pData;
+  (void)numBytes;
+  return 0;
+}
+
+/* move the cursor to the position of frame f: erase it at the old position (color 0), draw it at the new one (color 1) and mark the tiles of both dirty */
+static void drawCursor(uint8_t* pImageData, uint8_t* aDirty, int f) {
+  for(int i = 0; i < 2; ++i) {
+    const int left = 1000 + (f - 1 + i) * STEP;
+    if(f == 0 && i == 0) {
+      continue;
+    }
+    for(int y = 1000; y < 1000 + CURSOR; ++y) {
+      memset(pImageData + y * WIDTH + left, i, CURSOR);
+      aDirty[(y / CGIF_TILE_SIZE) * NUM_TILES_X + left / CGIF_TILE_SIZE]                = 1;
+      aDirty[(y / CGIF_TILE_SIZE) * NUM_TILES_X + (left + CURSOR - 1) / CGIF_TILE_SIZE] = 1;
+    }
+  }
+}
+
+/* add all frames: compare full frames (mode 0), hash the tiles (mode 1) or pass the dirty tiles (mode 2) */
+static int run(const char* name, int mode, uint8_t* pImageData, uint8_t* aDirty) {
+  CGIF*            pGIF;
+  CGIF_Config      gConfig;
+  CGIF_FrameConfig fConfig;
+  uint8_t          aPalette[2 * 3] = { 0xFF, 0xFF, 0xFF, 0x00, 0x00, 0x00 };
+  clock_t          t;
+
+  memset(pImageData, 0, WIDTH * HEIGHT); // static background
+  memset(&gConfig, 0, sizeof(gConfig));
+  gConfig.width                   = WIDTH;
+  gConfig.height                  = HEIGHT;
+  gConfig.pGlobalPalette          = aPalette;
+  gConfig.numGlobalPaletteEntries = 2;
+  gConfig.attrFlags               = CGIF_ATTR_IS_ANIMATED;
+  gConfig.genFlags                = (mode == 1) ? CGIF_GEN_TILE_HASH : 0;
+  gConfig.pWriteFn                = writeFn;
+  pGIF = cgif_newgif(&gConfig);
+  if(pGIF == NULL) {
+    return 1;
+  }
+  t = clock();
+  for(int f = 0; f < NUM_FRAMES; ++f) {
+    int r;
+
+    memset(aDirty, 0, NUM_TILES);
+    drawCursor(pImageData, aDirty, f);
+    memset(&fConfig, 0, sizeof(fConfig));
+    fConfig.pImageData = pImageData;
+    fConfig.delay      = 4;
+    fConfig.genFlags   = CGIF_FRAME_GEN_USE_TRANSPARENCY | CGIF_FRAME_GEN_USE_DIFF_WINDOW;
+    r = (mode == 2) ? cgif_addframe_tiles(pGIF, &fConfig, aDirty) : cgif_addframe(pGIF, &fConfig);
+    if(r != CGIF_OK) {
+      cgif_close(pGIF);
+      return 1;
+    }
+  }
+  if(cgif_close(pGIF) != CGIF_OK) {
+    return 1;
+  }
+  t = clock() - t;
+  printf("%-12s %8.3f ms/frame\n", name, (double)t * 1000.0 / CLOCKS_PER_SEC / NUM_FRAMES);
+  return 0;
+}
+
+int main(void) {
+  uint8_t* pImageData = malloc(WIDTH * HEIGHT);
+  uint8_t* aDirty     = malloc(NUM_TILES);
+  int      r;
+
+  if(pImageData == NULL || aDirty == NULL) {
+    free(pImageData);
+    free(aDirty);
+    return 1;
+  }
+  r  = run("full frame", 0, pImageData, aDirty);
+  r |= run("tile hash", 1, pImageData, aDirty);
+  r |= run("dirty tiles", 2, pImageData, aDirty);
+  free(pImageData);
+  free(aDirty);
+  return r;
+}
@@ -15,14 +15,40 @@ extern "C" {
 #define CGIF_ATTR_NO_LOOP                (1uL << 4)       // don't loop a GIF animation: only play it one time.
 
 #define CGIF_GEN_KEEP_IDENT_FRAMES       (1uL << 0)       // keep frames that are identical to previous frame (default is to drop them)
+#define CGIF_GEN_SPECULATIVE_ENCODING    (1uL << 1)       // encode each frame with and without its size optimizations (in parallel, if possible) and keep the smallest variant
+#define CGIF_GEN_REUSE_FRAMES            (1uL << 2)       // detect repeats of recent frames (64-bit content hash) and reuse their encoding instead of encoding them again.
+                                                          // full frames without alpha channel / user-provided transparency only. a hash hit is confirmed by comparing the pixels of both frames of the pair:
+                                                          // keeps a copy of the frames of the last 8 encoded frame pairs (up to 16 x width x height bytes, shared between pairs)
+#define CGIF_GEN_OPTIM_DISPOSAL          (1uL << 3)       // choose the disposal method of each frame by looking at the next one (restore the canvas after transient overlays, if smaller)
+#define CGIF_GEN_ASYNC_ENCODING          (1uL << 4)       // cgif_addframe only hands the frame over to an encoder thread (waits only if it falls behind). errors are returned by the next call or cgif_close.
+                                                          // callbacks (pWriteFn, pFrameStatsFn, pReleaseFn) are called from the encoder thread. falls back to synchronous encoding without threads
+#define CGIF_GEN_HOIST_GLOBAL_TABLE      (1uL << 5)       // with CGIF_ATTR_NO_GLOBAL_TABLE: build a global color table from the colors of the first frames (frame queue, see sizeFrameQueue)
+                                                          // and remap the frames with a local color table to it, if all their colors are in there and the result is estimated to be smaller
+#define CGIF_GEN_TILE_HASH               (1uL << 6)       // detect changes by a 64-bit hash per tile (CGIF_TILE_SIZE x CGIF_TILE_SIZE pixels): a tile with a different hash differs without a comparison (large frames with small changes).
+                                                          // frames with the global color table only (no alpha channel / user-provided transparency). tiles with equal hashes are still compared (no miss on a hash collision)
+#define CGIF_GEN_LOW_MEMORY              (1uL << 7)       // keep only the frame written last (canvas) and the pending frame in memory: frame queue of 2 (sizeFrameQueue is ignored) and no RGB copy of the frame before (cgif_rgb).
+                                                          // lower optimization ceiling: no lookahead (CGIF_GEN_OPTIM_DISPOSAL and the hoisting of CGIF_GEN_HOIST_GLOBAL_TABLE only see one frame). cgif_rgb compares the quantized colors instead of the input
+#define CGIF_GEN_PERCEPTUAL_TOLERANCE    (1uL << 8)       // colorTolerance is a perceptual distance (weighted by the sensitivity of the eye per channel) instead of the maximum difference per channel
+#define CGIF_GEN_RATE_KEEP_LATEST        (1uL << 9)       // minDelay: a frame that comes too early replaces the frame before (latest content is shown) instead of being dropped
+#define CGIF_GEN_OUTPUT_HINTS            (1uL << 10)      // path: tell the OS that the file is written sequentially and is not read back (posix_fadvise, if available), keeps large GIFs out of the page cache
+#define CGIF_GEN_ASYNC_OUTPUT            (1uL << 11)      // path: write the output buffers on a writer thread (3 buffers of sizeOutputBuffer), so that encoding overlaps with slow I/O.
+                                                          // write errors are returned by a later call or cgif_close. falls back to synchronous writing without threads or output buffer
+#define CGIF_GEN_MEMORY_OUTPUT           (1uL << 12)      // collect the GIF in memory instead of writing it to path / pWriteFn (both must not be set). cgif_take_output hands it over without a copy
+#define CGIF_GEN_NO_OUTPUT_BUFFER        (1uL << 13)      // path: write each piece of output data through stdio (no output buffer of cgif, sizeOutputBuffer is ignored)
 
 #define CGIF_FRAME_ATTR_USE_LOCAL_TABLE  (1uL << 0)       // use a local color table for a frame (local color table is not used by default)
 #define CGIF_FRAME_ATTR_HAS_ALPHA        (1uL << 1)       // alpha channel index provided by user (transIndex field)
 #define CGIF_FRAME_ATTR_HAS_SET_TRANS    (1uL << 2)       // transparency setting provided by user (transIndex field)
 #define CGIF_FRAME_ATTR_INTERLACED       (1uL << 3)       // encode frame interlaced (default is not interlaced)
+#define CGIF_FRAME_ATTR_EXACT_RECT       (1uL << 4)       // cgif_addframe_rect: the patch is exactly the area that changed (no search for the changed area within the patch)
 // flags to decrease GIF-size
 #define CGIF_FRAME_GEN_USE_TRANSPARENCY  (1uL << 0)       // use transparency optimization (setting pixels identical to previous frame transparent)
 #define CGIF_FRAME_GEN_USE_DIFF_WINDOW   (1uL << 1)       // do encoding just for the sub-window that has changed from previous frame
+#define CGIF_FRAME_GEN_USE_DIFF_RECTS    (1uL << 2)       // split the changed sub-window into several rectangles (written as GIF frames with delay 0), if estimated to be smaller. requires CGIF_FRAME_GEN_USE_DIFF_WINDOW
+#define CGIF_FRAME_GEN_USE_LOSSY_TRANSPARENCY (1uL << 3)  // if the color table has no free index left for transparency: merge the least-used color into its nearest color (lossy). requires CGIF_FRAME_GEN_USE_TRANSPARENCY
+#define CGIF_FRAME_GEN_USE_FLEX_TRANSPARENCY  (1uL << 4)  // write each unchanged pixel either transparent or in its own color, whichever continues the current LZW string. requires CGIF_FRAME_GEN_USE_TRANSPARENCY
+
+#define CGIF_TILE_SIZE                   (64)             // width and height of a tile (see CGIF_GEN_TILE_HASH and cgif_addframe_tiles)
 
 #define CGIF_INFINITE_LOOP               (0x0000uL)       // for animated GIF: 0 specifies infinite loop
 
@@ -52,13 +78,26 @@ typedef struct st_frameconfig          CGIF_FrameConfig;  // local configuration
 typedef struct st_cgif_rgb_config      CGIFrgb_Config;
 typedef struct st_cgif_rgb             CGIFrgb;
 typedef struct st_cgif_rgb_frameconfig CGIFrgb_FrameConfig;
+typedef struct st_cgif_framestats      CGIF_FrameStats;   // statistics of a written frame
 
-typedef int cgif_write_fn(void* pContext, const uint8_t* pData, const size_t numBytes); // callback function for stream-based output
+typedef int  cgif_write_fn     (void* pContext, const uint8_t* pData, const size_t numBytes); // callback function for stream-based output
+typedef void cgif_framestats_fn(void* pContext, const CGIF_FrameStats* pStats);               // callback function for per-frame statistics
+typedef void cgif_release_fn   (void* pContext, uint8_t* pImageData, uint8_t* pLocalPalette);  // callback function releasing the buffers of a borrowed frame
 
 // prototypes
 CGIF* cgif_newgif     (CGIF_Config* pConfig);                  // creates a new GIF (returns pointer to new GIF or NULL on error)
 int   cgif_addframe   (CGIF* pGIF, CGIF_FrameConfig* pConfig); // adds the next frame to an existing GIF (returns 0 on success)
+int   cgif_addframe_borrow(CGIF* pGIF, CGIF_FrameConfig* pConfig, cgif_release_fn* pReleaseFn, void* pReleaseContext); // same as cgif_addframe, but without copying pImageData and pLocalPalette:
+                                                             // pReleaseFn is called exactly once per call (also on error), as soon as cgif does not need the buffers anymore (at the latest in cgif_close)
+int   cgif_addframe_rect(CGIF* pGIF, CGIF_FrameConfig* pConfig, uint16_t left, uint16_t top, uint16_t width, uint16_t height); // same as cgif_addframe, but pImageData only holds the patch (width x height) at left/top:
+                                                             // the rest of the frame is taken from the frame before. global color table only (no alpha channel / user-provided transparency)
+int   cgif_addframe_tiles(CGIF* pGIF, CGIF_FrameConfig* pConfig, const uint8_t* pDirtyTiles); // same as cgif_addframe, but pDirtyTiles marks the tiles (CGIF_TILE_SIZE x CGIF_TILE_SIZE pixels, one byte per tile, row by row) that might differ from the frame before:
+                                                             // tiles not marked (0) must be unchanged, they are not hashed (nor compared without CGIF_GEN_TILE_HASH). ignored for frames with a local color table / alpha channel / user-provided transparency
 int   cgif_close      (CGIF* pGIF);                          // close file and free allocated memory (returns 0 on success)
+int   cgif_take_output(CGIF* pGIF, uint8_t** ppData, size_t* pSize); // CGIF_GEN_MEMORY_OUTPUT: write the remaining frames and hand the GIF over (returns 0 on success, the caller frees *ppData with free()).
+                                                             // no more frames can be added, cgif_close must still be called (returns the same result)
+
+cgif_result cgif_estimate_size(const uint8_t* pImageData, uint16_t width, uint16_t height, uint16_t numColors, uint32_t* pSize); // estimate size of the LZW-encoded image data (bytes)
 
 CGIFrgb*    cgif_rgb_newgif    (const CGIFrgb_Config* pConfig);
 cgif_result cgif_rgb_addframe  (CGIFrgb* pGIF, const CGIFrgb_FrameConfig* pConfig);
@@ -76,7 +115,14 @@ struct st_gifconfig {
   uint16_t    numGlobalPaletteEntries;                   // size of the global color table
   uint16_t    numLoops;                                  // number of repetitons of an animated GIF (set to INFINITE_LOOP for infinite loop)
   cgif_write_fn *pWriteFn;                               // callback function for chunks of output data, mutually exclusive with path
-  void*       pContext;                                  // opaque pointer passed as the first parameter to pWriteFn
+  void*       pContext;                                  // opaque pointer passed as the first parameter to pWriteFn (and pFrameStatsFn)
+  cgif_framestats_fn *pFrameStatsFn;                     // optional callback function, called with the statistics of each written frame
+  uint16_t    sizeFrameQueue;                            // number of frames kept in memory for optimizations (2 to 16, 0: default of 3), including the frame written last
+  uint16_t    colorTolerance;                            // colors of the global color table that differ by up to this amount are treated as equal (0: exact, default), see README.md
+  uint16_t    minDelay;                                  // frame rate cap: minimum delay of a written frame (units of 0.01 s, 0: none), see README.md
+  uint32_t    sizeOutputBuffer;                          // path: size of the buffer collecting the output data before it is written (bytes, 0: default of 256 KB).
+                                                         // the file is written in chunks of this size (large pieces of data directly), see CGIF_GEN_NO_OUTPUT_BUFFER
+  uint32_t    sizeOutputHint;                            // CGIF_GEN_MEMORY_OUTPUT: expected size of the GIF, e.g. from cgif_estimate_size (bytes, 0: size of one frame), the buffer doubles whenever it is full
 };
 
 // CGIF_FrameConfig type (parameters passed by user)
@@ -91,6 +137,19 @@ struct st_frameconfig {
   uint8_t   transIndex;                                // introduced with V0.2.0
 };
 
+// CGIF_FrameStats type (passed to pFrameStatsFn)
+struct st_cgif_framestats {
+  uint32_t  frameIndex;                                // index of the frame within the GIF (starting at 0)
+  uint32_t  sizeRasterData;                            // size of the LZW-encoded image data (bytes)
+  uint32_t  genFlags;                                  // size optimizations (CGIF_FRAME_GEN_*) used for the written variant of the frame
+  uint16_t  width;                                     // width of the written frame
+  uint16_t  height;                                    // height of the written frame
+  uint16_t  top;                                       // top offset of the written frame
+  uint16_t  left;                                      // left offset of the written frame
+  uint16_t  delay;                                     // delay of the written frame (units of 0.01 s)
+  uint8_t   numVariants;                               // number of encoded variants (more than one with CGIF_GEN_SPECULATIVE_ENCODING, 0 if the encoding of a recent frame was reused)
+};
+
 struct st_cgif_rgb_config {
   cgif_write_fn* pWriteFn;
   void*          pContext;
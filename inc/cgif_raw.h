@@ -16,6 +16,7 @@ extern "C" {
 // flags to set the GIF attributes
 #define CGIF_RAW_ATTR_IS_ANIMATED     (1uL << 0) // make an animated GIF (default is non-animated GIF)
 #define CGIF_RAW_ATTR_NO_LOOP         (1uL << 1) // don't loop a GIF animation: only play it one time.
+#define CGIF_RAW_ATTR_MEMORY_OUTPUT   (1uL << 2) // collect the output data in memory instead of calling pWriteFn (each encoded frame is copied into it, see cgif_raw_takeoutput)
 
 // flags to set the Frame attributes
 #define CGIF_RAW_FRAME_ATTR_HAS_TRANS  (1uL << 0) // provided transIndex should be set
@@ -32,13 +33,30 @@ typedef struct {
   uint16_t       height;       // effective height of each frame in the GIF
   uint16_t       sizeGCT;      // size of the global color table (GCT)
   uint16_t       numLoops;     // number of repetitons of an animated GIF (set to INFINITE_LOOP resp. 0 for infinite loop, use CGIF_ATTR_NO_LOOP if you don't want any repetition)
+  uint32_t       sizeOutputHint; // CGIF_RAW_ATTR_MEMORY_OUTPUT: expected size of the GIF (bytes, 0: headers + width x height, up to 16 MB), the buffer doubles whenever it is full
 } CGIFRaw_Config;
 
+#define CGIF_RAW_PIXEL_ID_ANY (0xFFFFFFFFuL) // pixel ID matching every pixel of the frame before (see CGIFRaw_PixelSrc)
+
+// CGIFRaw_PixelSrc type: image data of a frame read from a larger image while encoding (no copy of the image data).
+// the frame is the area top/left/width/height of the image. pixels equal to the frame before are replaced by transIndex.
+// note: internal sections, subject to change.
+typedef struct {
+  const uint8_t*  pImageData;    // image (stride x at least top + height rows)
+  const uint8_t*  pBefImageData; // image of the frame before, same layout (NULL: no pixels are replaced)
+  const uint32_t* pIDCur;        // pixel ID per color index of pImageData: pixels with the same ID are equal (CGIF_RAW_PIXEL_ID_ANY: equal to every pixel)
+  const uint32_t* pIDBef;        // pixel ID per color index of pBefImageData
+  const uint8_t*  pMap;          // color index mapping applied to the remaining pixels (NULL: none)
+  uint16_t        stride;        // width of the image
+  uint8_t         isFlexTrans;   // 1: a replaced pixel may keep its own color instead, if that gives longer LZW strings (flexible transparency), 0 otherwise
+} CGIFRaw_PixelSrc;
+
 // CGIFRaw_FrameConfig type
 // note: internal sections, subject to chage.
 typedef struct {
   uint8_t*  pLCT;              // local color table of the frame (LCT)
   uint8_t*  pImageData;        // image data to be encoded (indices to CT)
+  const CGIFRaw_PixelSrc* pSrc; // image data given as pixel source instead (NULL: pImageData is used)
   uint32_t  attrFlags;         // fixed attributes of the GIF frame
   uint16_t  width;             // width of frame
   uint16_t  height;            // height of frame
@@ -55,12 +73,30 @@ typedef struct {
 typedef struct {
   CGIFRaw_Config config;    // configutation parameters of the GIF (see above)
   cgif_result    curResult; // current result status of GIFRaw stream
+  uint8_t*       pOutput;   // CGIF_RAW_ATTR_MEMORY_OUTPUT: output data (NULL once handed over)
+  size_t         sizeOutput; // CGIF_RAW_ATTR_MEMORY_OUTPUT: number of bytes in pOutput
+  size_t         capOutput; // CGIF_RAW_ATTR_MEMORY_OUTPUT: number of bytes pOutput can hold
+  int            isFinished; // the trailer is written (cgif_raw_takeoutput): no more frames
 } CGIFRaw;
 
+// CGIFRaw_EncFrame type (LZW-encoded frame that is not written yet)
+// note: internal sections, subject to change.
+typedef struct {
+  uint8_t*  pRasterData;       // LZW raster data (incl. sub-block structure)
+  uint32_t  sizeRasterData;    // size of the raster data (bytes)
+  uint8_t   initCodeLen;       // initial LZW code length
+} CGIFRaw_EncFrame;
+
 // prototypes
-CGIFRaw*    cgif_raw_newgif   (const CGIFRaw_Config* pConfig);
-cgif_result cgif_raw_addframe (CGIFRaw* pGIF, const CGIFRaw_FrameConfig* pConfig);
-cgif_result cgif_raw_close    (CGIFRaw* pGIF);
+CGIFRaw*    cgif_raw_newgif      (const CGIFRaw_Config* pConfig);
+cgif_result cgif_raw_addframe    (CGIFRaw* pGIF, const CGIFRaw_FrameConfig* pConfig);
+cgif_result cgif_raw_encodeframe (const CGIFRaw* pGIF, const CGIFRaw_FrameConfig* pConfig, CGIFRaw_EncFrame* pEncFrame); // LZW-encode frame without writing it (thread-safe)
+cgif_result cgif_raw_writeframe  (CGIFRaw* pGIF, const CGIFRaw_FrameConfig* pConfig, CGIFRaw_EncFrame* pEncFrame);       // write encoded frame (frees pEncFrame's raster data)
+void        cgif_raw_freeframe   (CGIFRaw_EncFrame* pEncFrame);                                                           // free encoded frame without writing it
+cgif_result cgif_raw_estimateframe(const CGIFRaw* pGIF, const CGIFRaw_FrameConfig* pConfig, uint32_t* pSize);            // estimate size of the LZW raster data (thread-safe)
+cgif_result cgif_raw_estimatesize (const uint8_t* pImageData, uint16_t width, uint16_t height, uint16_t numColors, uint32_t* pSize);
+cgif_result cgif_raw_takeoutput  (CGIFRaw* pGIF, uint8_t** ppData, size_t* pSize);                                       // CGIF_RAW_ATTR_MEMORY_OUTPUT: write the trailer and hand the output data over (free() it), call cgif_raw_close afterwards
+cgif_result cgif_raw_close       (CGIFRaw* pGIF);
 
 #ifdef __cplusplus
 }
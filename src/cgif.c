@@ -1,3 +1,8 @@
+// fileno and posix_fadvise (see CGIF_GEN_OUTPUT_HINTS)
+#if defined(CGIF_HAVE_FADVISE) && !defined(_POSIX_C_SOURCE)
+  #define _POSIX_C_SOURCE 200112L
+#endif
+
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
@@ -6,35 +11,224 @@
 #include "cgif.h"
 #include "cgif_raw.h"
 
+#ifdef CGIF_HAVE_PTHREAD
+#include <pthread.h>
+#endif
+#ifdef CGIF_HAVE_FADVISE
+#include <fcntl.h>
+#endif
+
+// background encoder thread (see CGIF_GEN_ASYNC_ENCODING): the rings between the threads use the atomics of GCC / clang
+#if defined(CGIF_HAVE_PTHREAD) && defined(__GNUC__)
+  #define CGIF_ASYNC
+  #define ATOMIC_LOAD(p)     __atomic_load_n((p), __ATOMIC_ACQUIRE)
+  #define ATOMIC_STORE(p, v) __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+#endif
+
+// vectorized comparison of image rows (see findFirstDiff / findLastDiff)
+#if defined(__AVX2__)
+  #define CGIF_DIFF_AVX2
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+  #define CGIF_DIFF_SSE2
+  #include <immintrin.h>
+#elif defined(__ARM_NEON) && defined(__GNUC__) && !defined(__ARM_BIG_ENDIAN)
+  #define CGIF_DIFF_NEON
+  #include <arm_neon.h>
+#endif
+#if defined(CGIF_DIFF_SSE2) && defined(_MSC_VER) && !defined(__clang__)
+  #include <intrin.h>
+#endif
+
 #define MULU16(a, b) (((uint32_t)a) * ((uint32_t)b)) // helper macro to correctly multiply two U16's without default signed int promotion
-#define SIZE_FRAME_QUEUE (3)
+#define SIZE_FRAME_QUEUE (3)   // default number of frames in the frame queue (see CGIF_Config.sizeFrameQueue)
+#define MAX_FRAME_QUEUE (16)   // maximum number of frames in the frame queue
+#define SIZE_FRAME_POOL (MAX_FRAME_QUEUE + 1) // maximum number of recycled frame slots (see getFrameSlot)
+#define MAX_NUM_CANDIDATES (3) // maximum number of encoded variants per frame (see CGIF_GEN_SPECULATIVE_ENCODING)
+#define MAX_NUM_RECTS (8)      // maximum number of rectangles (GIF frames) per frame (see CGIF_FRAME_GEN_USE_DIFF_RECTS)
+#define MIN_RECT_SPLIT_GAIN (256) // minimum number of unchanged pixels to be dropped by splitting a rectangle
+#define SIZE_FRAME_OVERHEAD (19)  // bytes per GIF frame in addition to raster data + LCT: graphic control extension (8), image descriptor (10), LZW minimum code size (1)
+#define SIZE_FRAME_CACHE (8)      // number of recently encoded frames kept for reuse (see CGIF_GEN_REUSE_FRAMES)
+#define SIZE_OUTPUT_BUFFER (256 * 1024) // default size of the output buffer of path-based output (see CGIF_Config.sizeOutputBuffer)
+#define NUM_OUTPUT_BUFFERS (3)    // output buffers with a writer thread: one is filled while the others are written (see CGIF_GEN_ASYNC_OUTPUT)
+#define SIZE_ASYNC_RING (4)       // number of frames handed over to the encoder thread, but not yet in the frame queue (see CGIF_GEN_ASYNC_ENCODING)
+#define NUM_ASYNC_BUFFERS (SIZE_ASYNC_RING + MAX_FRAME_QUEUE) // maximum number of image buffers of copied frames in async mode: ring + frame queue
+#define TILE_SIZE CGIF_TILE_SIZE  // width and height of a tile (see CGIF_GEN_TILE_HASH)
+
+// dimension result type
+typedef struct {
+  uint16_t width;
+  uint16_t height;
+  uint16_t top;
+  uint16_t left;
+} DimResult;
 
 // CGIF_Frame type
 // note: internal sections, subject to change in future versions
-typedef struct {
+typedef struct st_frame {
   CGIF_FrameConfig config;
+  cgif_release_fn* pReleaseFn;      // release callback of a borrowed frame (see cgif_addframe_borrow)
+  void*            pReleaseContext; // opaque pointer passed as the first parameter to pReleaseFn
+  uint8_t*         pSlotImageData;  // image buffer owned by the frame slot (width x height, reused for every copied frame)
+  uint8_t*         pSlotLCT;        // LCT buffer owned by the frame slot (reused for every copied frame)
+  uint16_t         sizeSlotLCT;     // number of entries pSlotLCT can hold
+  uint64_t         hash;            // content hash with the color table resolved (see CGIF_GEN_REUSE_FRAMES)
+  uint8_t          hasHash;         // hash is set (frame without alpha channel / user-provided transparency)
+  const struct st_frame* pRectBase;  // frame the patch of cgif_addframe_rect was applied to (NULL: full frame)
+  DimResult        rect;            // area of the patch (see cgif_addframe_rect)
+  uint64_t*        pTileTags;       // tag per tile: content hash (even) or unique tag of a tile marked dirty (odd). equal tags: equal tiles, for content hashes only with the frame of tagsBaseID (see CGIF_GEN_TILE_HASH)
+  uint64_t         tagsID;          // number of the tile tags of the frame (see tagsBaseID)
+  uint64_t         tagsBaseID;      // tagsID of the frame the tile tags were set against: equal content hashes with that frame are equal tiles (compared once)
+  uint8_t          hasTileTags;     // pTileTags is set (frame with the global color table, without alpha channel / user-provided transparency)
+  uint8_t          isBorrowed;      // image data and LCT are borrowed from the user (no deep copy)
+  uint8_t          isAlphaCanvas;   // the canvas the next frame is drawn on might hold transparent pixels (alpha channel, disposal to background), set by flushFrame
+  uint8_t          hasMerged;       // colors of the frame were merged into other colors by lossy transparency (see aIsMerged), set by flushFrame
+  uint8_t          aIsMerged[256];  // 1 per color index merged into another color: its pixels might show the other color on the canvas
   uint8_t          disposalMethod;
   uint8_t          transIndex;
 } CGIF_Frame;
 
+// copy of a frame kept by the frame cache to confirm hash hits (shared by the cache entries, see CGIF_GEN_REUSE_FRAMES)
+typedef struct {
+  uint64_t hash;          // content hash of the frame
+  uint8_t* pImageData;    // copy of the image data (width x height)
+  uint32_t aID[256];      // color ID per index (see initHashIDs)
+  int      numRefs;       // number of cache entries using the copy
+} CachedImage;
+
+// encoded frame kept for reuse (see CGIF_GEN_REUSE_FRAMES)
+typedef struct {
+  CGIFRaw_FrameConfig rawConfig;     // raw frame config of the encoded frame (pLCT points to the copy below)
+  CGIFRaw_EncFrame    encFrame;      // LZW-encoded image data (NULL: unused entry)
+  uint8_t*            pLCT;          // copy of the local color table
+  CachedImage*        pImgCur;       // copy of the frame
+  CachedImage*        pImgBef;       // copy of the frame before
+  uint32_t            attrFlags;     // CGIF_FRAME_ATTR_* of the frame
+  uint32_t            frameGenFlags; // size optimizations (CGIF_FRAME_GEN_*) requested for the frame
+  uint32_t            genFlags;      // size optimizations (CGIF_FRAME_GEN_*) used for the encoded variant
+  uint8_t             disposalMethod;
+} FrameCacheEntry;
+
+// local color table last mapped to the global color table (see mapToGlobalTable)
+typedef struct {
+  uint64_t hash;          // palette hash of aLCT
+  uint16_t numEntries;    // number of entries in aLCT (0: unused)
+  int      isIdentity;    // each entry of aLCT is the entry of the global color table with the same index
+  uint8_t  aLCT[256 * 3]; // copy of the local color table
+  int16_t  aMap[256];     // index in the global color table per entry (-1: color not in there)
+} LCTMap;
+
+#ifdef CGIF_ASYNC
+typedef struct st_async_state AsyncState;
+
+// image buffer of a copied frame in async mode (recycled between the calling thread and the encoder thread)
+typedef struct {
+  AsyncState* pAsync;     // async state the buffer belongs to
+  uint8_t*    pImageData; // image data (width x height)
+  uint8_t*    pLCT;       // local color table
+  uint16_t    sizeLCT;    // number of entries pLCT can hold
+  uint8_t*    pDirtyTiles; // dirty tiles (one byte per tile, allocated on demand)
+} AsyncBuffer;
+
+// frame handed over to the encoder thread
+typedef struct {
+  CGIF_FrameConfig config;          // frame config (pImageData / pLocalPalette: copy in an AsyncBuffer or borrowed from the user)
+  cgif_release_fn* pReleaseFn;      // releases the buffers once the frame is not needed anymore
+  void*            pReleaseContext;
+  DimResult        rect;            // patch of cgif_addframe_rect (pImageData holds the patch only, width 0: full frame)
+  const uint8_t*   pDirtyTiles;     // dirty tiles of cgif_addframe_tiles (copy in an AsyncBuffer, NULL: none given)
+} AsyncFrame;
+
+// state of the encoder thread: two single-producer single-consumer rings (frames to the encoder, free buffers back to the caller).
+// the mutex and condition variable are used for sleeping only (ring full / empty).
+struct st_async_state {
+  pthread_t       thread;
+  pthread_mutex_t mutex;
+  pthread_cond_t  cond;
+  AsyncFrame      aRing[SIZE_ASYNC_RING];     // frames to be added by the encoder thread
+  uint32_t        ringHead;                   // next frame to be written (calling thread)
+  uint32_t        ringTail;                   // next frame to be read (encoder thread)
+  AsyncBuffer     aBuffer[NUM_ASYNC_BUFFERS]; // image buffers of copied frames (allocated on demand)
+  int             numBuffers;                 // number of allocated buffers in aBuffer
+  uint8_t         aFree[NUM_ASYNC_BUFFERS];   // indices of free buffers
+  uint32_t        freeHead;                   // next free buffer to be written (encoder thread)
+  uint32_t        freeTail;                   // next free buffer to be read (calling thread)
+  int             isClosing;                  // set by cgif_close: stop once the ring is empty
+  cgif_result     result;                     // first error of the encoder thread
+  cgif_result     callerResult;               // error of the calling thread (e.g. copying a frame failed)
+};
+
+// state of the writer thread (CGIF_GEN_ASYNC_OUTPUT): ring of full output buffers, filled by the thread adding the frames.
+// the mutex and condition variable are used for sleeping only (all buffers full / none to write).
+struct st_output_writer {
+  pthread_t       thread;
+  pthread_mutex_t mutex;
+  pthread_cond_t  cond;
+  uint8_t*        aBuffer[NUM_OUTPUT_BUFFERS];   // output buffers (sizeOutBuf bytes each)
+  size_t          aNumBytes[NUM_OUTPUT_BUFFERS]; // number of bytes of each full buffer
+  uint32_t        head;                          // next buffer to be handed over (filled by the encoding thread)
+  uint32_t        tail;                          // next buffer to be written (writer thread)
+  int             isClosing;                     // set by cgif_close: stop once all buffers are written
+  int             hasError;                      // a write failed (reported by the next handover or cgif_close)
+};
+#endif
+
 // CGIF type
 // note: internal sections, subject to change in future versions
 struct st_gif {
-  CGIF_Frame*        aFrames[SIZE_FRAME_QUEUE]; // (internal) we need to keep the last three frames in memory.
+  CGIF_Frame*        aFrames[MAX_FRAME_QUEUE]; // (internal) we need to keep the last sizeFrameQueue frames in memory.
+  CGIF_Frame*        aFramePool[SIZE_FRAME_POOL]; // (internal) unused frame slots, recycled by cgif_addframe
+  int                numPoolFrames;             // (internal) number of frame slots in aFramePool
+  int                sizeFrameQueue;            // (internal) number of frames in aFrames: the frame before (written) + frames not yet written
   CGIF_Config        config;                    // (internal) configuration parameters of the GIF
   CGIFRaw*           pGIFRaw;                   // (internal) raw GIF stream
   FILE*              pFile;
   cgif_result        curResult;
   int                iHEAD;                     // (internal) index to current HEAD frame in aFrames queue
+  uint32_t           cntFrames;                 // (internal) number of frames written so far
+  FrameCacheEntry    aFrameCache[SIZE_FRAME_CACHE]; // (internal) recently encoded frames (CGIF_GEN_REUSE_FRAMES)
+  int                iFrameCache;               // (internal) next entry of aFrameCache to be replaced
+  struct st_async_state* pAsync;                // (internal) encoder thread (CGIF_GEN_ASYNC_ENCODING), NULL if frames are added synchronously
+  int                hasHoistedGCT;             // (internal) pGlobalPalette was built from the local color tables of the first frames (CGIF_GEN_HOIST_GLOBAL_TABLE)
+  LCTMap             lctMap;                    // (internal) mapping of the last local color table to the global color table
+  uint64_t*          pTileTags;                 // (internal) tile tags of the frame being added (swapped with the buffer of its frame slot once queued)
+  uint64_t           nextTileTag;               // (internal) counter for the unique tags of dirty tiles
+  uint64_t           cntTileTags;               // (internal) counter for CGIF_Frame.tagsID
+  uint8_t*           pNearTable;                // (internal) colorTolerance: 256 x 256 table, 1 if two indices of the global color table are within the tolerance
+  int                hasDropped;                // (internal) the frame added last was dropped (minDelay): dirty tiles of the next frame are not complete
+  CGIF_Frame*        pDropped;                  // (internal) copy of the frame dropped last (minDelay), base of a patch / user-provided transparency (NULL: none)
+  uint8_t*           pOutBuf;                   // (internal) output buffer of path-based output (NULL: written through stdio)
+  size_t             sizeOutBuf;                // (internal) size of pOutBuf
+  size_t             numOutBytes;               // (internal) number of bytes in pOutBuf not yet written to the file
+  uint64_t           offsetFile;                // (internal) number of bytes written to the file so far
+  uint64_t           offsetAdvised;             // (internal) start of the file range not yet released from the page cache (CGIF_GEN_OUTPUT_HINTS)
+  struct st_output_writer* pWriter;             // (internal) writer thread of the output buffers (CGIF_GEN_ASYNC_OUTPUT), NULL if written synchronously
+  int                isFinished;                // (internal) all frames are written (cgif_take_output / cgif_close): no more frames
+  uint8_t*           pOutput;                   // (internal) GIF collected in memory (CGIF_GEN_MEMORY_OUTPUT), until handed over by cgif_take_output
+  size_t             sizeOutput;                // (internal) size of pOutput
 };
 
-// dimension result type
+// pixel equivalence table of a frame pair: iCur and iBef are RGB equal if aCur[iCur] == aBef[iBef] (or aCur[iCur] == PIXEL_ID_ANY)
 typedef struct {
-  uint16_t width;
-  uint16_t height;
-  uint16_t top;
-  uint16_t left;
-} DimResult;
+  uint32_t aCur[256]; // canonical color IDs (24-bit RGB value) of the current frame
+  uint32_t aBef[256]; // canonical color IDs (24-bit RGB value) of the frame before
+} PixelEqTable;
+
+#define PIXEL_ID_ANY      CGIF_RAW_PIXEL_ID_ANY // matches every pixel (user-provided transparency of the current frame)
+#define PIXEL_ID_NONE_CUR (0xFFFFFFFEuL) // matches no pixel (index out of bounds)
+#define PIXEL_ID_NONE_BEF (0xFFFFFFFDuL) // matches no pixel (index out of bounds or user-provided transparency of the frame before)
+
+// encoding candidate (variant) of a frame
+typedef struct {
+  CGIFRaw_FrameConfig rawConfig;     // raw frame config of the variant
+  CGIFRaw_EncFrame    encFrame;      // LZW-encoded variant
+  const CGIFRaw*      pGIFRaw;       // raw GIF stream the variant is encoded for
+  CGIFRaw_PixelSrc    src;           // image data of the variant: cropped / made transparent while encoding (unused if the frame is encoded as is)
+  PixelEqTable        eqTable;       // pixel equivalence table of the frame pair (pixel IDs of src)
+  uint8_t             aMap[256];     // color index mapping of the opaque pixels (see findTransIndex)
+  uint32_t            genFlags;      // size optimizations (CGIF_FRAME_GEN_*) used for the variant
+  cgif_result         r;             // result of the LZW-encoding
+} EncCandidate;
 
 /* calculate next power of two exponent of given number (n MUST be <= 256) */
 static uint8_t calcNextPower2Ex(uint16_t n) {
@@ -44,13 +238,196 @@ static uint8_t calcNextPower2Ex(uint16_t n) {
   return nextPow2;
 }
 
+#ifdef CGIF_DIFF_SSE2
+/* index of the lowest / highest set bit (mask MUST NOT be zero) */
+#if defined(_MSC_VER) && !defined(__clang__)
+static uint32_t bitScanForward32(uint32_t mask) {
+  unsigned long i;
+  _BitScanForward(&i, mask);
+  return i;
+}
+static uint32_t bitScanReverse32(uint32_t mask) {
+  unsigned long i;
+  _BitScanReverse(&i, mask);
+  return i;
+}
+#else
+static uint32_t bitScanForward32(uint32_t mask) {
+  return (uint32_t)__builtin_ctz(mask);
+}
+static uint32_t bitScanReverse32(uint32_t mask) {
+  return 31 - (uint32_t)__builtin_clz(mask);
+}
+#endif
+#endif
+
+/* write a chunk of output data to the file. returns 0 on success or -1 on error. */
+static int writeFile(CGIF* pGIF, const uint8_t* pData, const size_t numBytes) {
+  if(fwrite(pData, 1, numBytes, pGIF->pFile) != numBytes) {
+    return -1;
+  }
+  pGIF->offsetFile += numBytes;
+#ifdef CGIF_HAVE_FADVISE
+  // start the writeback of the chunk and drop the chunk before from the page cache (if it is written back by now)
+  if(pGIF->config.genFlags & CGIF_GEN_OUTPUT_HINTS) {
+    posix_fadvise(fileno(pGIF->pFile), (off_t)pGIF->offsetAdvised, (off_t)(pGIF->offsetFile - pGIF->offsetAdvised), POSIX_FADV_DONTNEED);
+    pGIF->offsetAdvised = pGIF->offsetFile - numBytes;
+  }
+#endif
+  return 0;
+}
+
+#ifdef CGIF_ASYNC
+static void wakeWriter(struct st_output_writer* pWriter) {
+  pthread_mutex_lock(&pWriter->mutex);
+  pthread_cond_broadcast(&pWriter->cond);
+  pthread_mutex_unlock(&pWriter->mutex);
+}
+
+/* writer thread: write the full output buffers in order until cgif_close is called (skipped after an error) */
+static void* outputWriter(void* pArg) {
+  CGIF*                    pGIF    = (CGIF*)pArg;
+  struct st_output_writer* pWriter = pGIF->pWriter;
+  uint32_t                 tail;
+
+  for(;;) {
+    tail = pWriter->tail;
+    pthread_mutex_lock(&pWriter->mutex);
+    while(ATOMIC_LOAD(&pWriter->head) == tail && !ATOMIC_LOAD(&pWriter->isClosing)) {
+      pthread_cond_wait(&pWriter->cond, &pWriter->mutex);
+    }
+    pthread_mutex_unlock(&pWriter->mutex);
+    if(ATOMIC_LOAD(&pWriter->head) == tail) {
+      break; // closing + all buffers written
+    }
+    if(!pWriter->hasError && writeFile(pGIF, pWriter->aBuffer[tail % NUM_OUTPUT_BUFFERS], pWriter->aNumBytes[tail % NUM_OUTPUT_BUFFERS])) {
+      ATOMIC_STORE(&pWriter->hasError, 1);
+    }
+    ATOMIC_STORE(&pWriter->tail, tail + 1);
+    wakeWriter(pWriter);
+  }
+  return NULL;
+}
+
+/* start the writer thread, the output buffer becomes its first buffer. returns 0 if the output is to be written synchronously */
+static int startWriter(CGIF* pGIF) {
+  struct st_output_writer* pWriter;
+
+  pWriter = malloc(sizeof(struct st_output_writer));
+  if(pWriter == NULL) {
+    return 0;
+  }
+  memset(pWriter, 0, sizeof(struct st_output_writer));
+  pWriter->aBuffer[0] = pGIF->pOutBuf;
+  for(int i = 1; i < NUM_OUTPUT_BUFFERS; ++i) {
+    pWriter->aBuffer[i] = malloc(pGIF->sizeOutBuf);
+    if(pWriter->aBuffer[i] == NULL) {
+      goto START_WRITER_Cleanup;
+    }
+  }
+  if(pthread_mutex_init(&pWriter->mutex, NULL)) {
+    goto START_WRITER_Cleanup;
+  }
+  if(pthread_cond_init(&pWriter->cond, NULL)) {
+    pthread_mutex_destroy(&pWriter->mutex);
+    goto START_WRITER_Cleanup;
+  }
+  pGIF->pWriter = pWriter;
+  if(pthread_create(&pWriter->thread, NULL, outputWriter, pGIF)) {
+    pthread_cond_destroy(&pWriter->cond);
+    pthread_mutex_destroy(&pWriter->mutex);
+    pGIF->pWriter = NULL;
+    goto START_WRITER_Cleanup;
+  }
+  return 1;
+
+START_WRITER_Cleanup:
+  for(int i = 1; i < NUM_OUTPUT_BUFFERS; ++i) {
+    free(pWriter->aBuffer[i]);
+  }
+  free(pWriter);
+  return 0;
+}
+
+/* hand the output buffer over to the writer thread and wait for the next free buffer. returns 0 on success or -1 on error (of an earlier write). */
+static int handOverOutput(CGIF* pGIF, size_t numBytes) {
+  struct st_output_writer* pWriter = pGIF->pWriter;
+  const uint32_t           head    = pWriter->head + 1;
+
+  pWriter->aNumBytes[pWriter->head % NUM_OUTPUT_BUFFERS] = numBytes;
+  ATOMIC_STORE(&pWriter->head, head);
+  wakeWriter(pWriter);
+  pthread_mutex_lock(&pWriter->mutex);
+  while(head - ATOMIC_LOAD(&pWriter->tail) >= NUM_OUTPUT_BUFFERS) {
+    pthread_cond_wait(&pWriter->cond, &pWriter->mutex);
+  }
+  pthread_mutex_unlock(&pWriter->mutex);
+  pGIF->pOutBuf = pWriter->aBuffer[head % NUM_OUTPUT_BUFFERS];
+  return (ATOMIC_LOAD(&pWriter->hasError)) ? -1 : 0;
+}
+
+/* let the writer thread write the remaining buffers, wait for it to finish and free its state. returns 0 on success or -1 on error. */
+static int stopWriter(CGIF* pGIF) {
+  struct st_output_writer* pWriter = pGIF->pWriter;
+  int                      r;
+
+  ATOMIC_STORE(&pWriter->isClosing, 1);
+  wakeWriter(pWriter);
+  pthread_join(pWriter->thread, NULL);
+  r = (pWriter->hasError) ? -1 : 0;
+  // the buffers are freed here, including the one pOutBuf points to
+  for(int i = 0; i < NUM_OUTPUT_BUFFERS; ++i) {
+    free(pWriter->aBuffer[i]);
+  }
+  pthread_cond_destroy(&pWriter->cond);
+  pthread_mutex_destroy(&pWriter->mutex);
+  free(pWriter);
+  pGIF->pWriter = NULL;
+  pGIF->pOutBuf = NULL;
+  return r;
+}
+#endif
+
+/* write the data in the output buffer to the file (or hand it over to the writer thread). returns 0 on success or -1 on error. */
+static int flushOutput(CGIF* pGIF) {
+  const size_t numBytes = pGIF->numOutBytes;
+
+  pGIF->numOutBytes = 0;
+  if(numBytes == 0) {
+    return 0;
+  }
+#ifdef CGIF_ASYNC
+  if(pGIF->pWriter) {
+    return handOverOutput(pGIF, numBytes);
+  }
+#endif
+  return writeFile(pGIF, pGIF->pOutBuf, numBytes);
+}
+
 /* write callback. returns 0 on success or -1 on error.  */
 static int writecb(void* pContext, const uint8_t* pData, const size_t numBytes) {
   CGIF* pGIF;
   size_t r;
 
   pGIF = (CGIF*)pContext;
-  if(pGIF->pFile) {
+  if(pGIF->pOutBuf) {
+    // collect small pieces (headers, sub-blocks) in the output buffer, large pieces are written directly (in order: not with the writer thread)
+    if(pGIF->numOutBytes + numBytes > pGIF->sizeOutBuf && flushOutput(pGIF)) {
+      return -1;
+    }
+    if(numBytes >= pGIF->sizeOutBuf && pGIF->pWriter == NULL) {
+      return writeFile(pGIF, pData, numBytes);
+    }
+    for(size_t i = 0, n; i < numBytes; i += n) {
+      n = (numBytes - i < pGIF->sizeOutBuf - pGIF->numOutBytes) ? numBytes - i : pGIF->sizeOutBuf - pGIF->numOutBytes;
+      memcpy(pGIF->pOutBuf + pGIF->numOutBytes, pData + i, n);
+      pGIF->numOutBytes += n;
+      if(pGIF->numOutBytes == pGIF->sizeOutBuf && i + n < numBytes && flushOutput(pGIF)) {
+        return -1;
+      }
+    }
+    return 0;
+  } else if(pGIF->pFile) {
     r = fwrite(pData, 1, numBytes, pGIF->pFile);
     if(r == numBytes) return 0;
     else return -1;
@@ -60,24 +437,130 @@ static int writecb(void* pContext, const uint8_t* pData, const size_t numBytes)
   return 0;
 }
 
+/* free a frame slot including its buffers */
+static void freeFrameSlot(CGIF_Frame* pFrame) {
+  free(pFrame->pSlotImageData);
+  free(pFrame->pSlotLCT);
+  free(pFrame->pTileTags);
+  free(pFrame);
+}
+
+/* release a copy of a frame kept by the frame cache (freed once no cache entry uses it) */
+static void releaseCachedImage(CachedImage* pImg) {
+  if(pImg && --(pImg->numRefs) == 0) {
+    free(pImg->pImageData);
+    free(pImg);
+  }
+}
+
+/* free an entry of the frame cache */
+static void freeCachedFrame(FrameCacheEntry* pEntry) {
+  if(pEntry->encFrame.pRasterData) {
+    releaseCachedImage(pEntry->pImgCur);
+    releaseCachedImage(pEntry->pImgBef);
+  }
+  cgif_raw_freeframe(&pEntry->encFrame);
+  free(pEntry->pLCT);
+  pEntry->pImgCur = NULL;
+  pEntry->pImgBef = NULL;
+  pEntry->pLCT    = NULL;
+}
+
 /* free space allocated for CGIF struct */
 static void freeCGIF(CGIF* pGIF) {
-  if((pGIF->config.attrFlags & CGIF_ATTR_NO_GLOBAL_TABLE) == 0) {
+  for(int i = 0; i < pGIF->numPoolFrames; ++i) {
+    freeFrameSlot(pGIF->aFramePool[i]);
+  }
+  for(int i = 0; i < SIZE_FRAME_CACHE; ++i) {
+    freeCachedFrame(&pGIF->aFrameCache[i]);
+  }
+  if(pGIF->pDropped) {
+    freeFrameSlot(pGIF->pDropped);
+  }
+  if((pGIF->config.attrFlags & CGIF_ATTR_NO_GLOBAL_TABLE) == 0 || pGIF->hasHoistedGCT) {
     free(pGIF->config.pGlobalPalette);
   }
+  free(pGIF->pTileTags);
+  free(pGIF->pNearTable);
+  free(pGIF->pOutBuf);
+  free(pGIF->pOutput);
   free(pGIF);
 }
 
+/* create the raw GIF stream (writes the GIF header and the global color table, if any) */
+static cgif_result createRawGIF(CGIF* pGIF) {
+  CGIFRaw_Config rawConfig = {0};
+  const int      hasGCT    = (pGIF->config.attrFlags & CGIF_ATTR_NO_GLOBAL_TABLE) == 0 || pGIF->hasHoistedGCT;
+
+  rawConfig.pGCT      = pGIF->config.pGlobalPalette;
+  rawConfig.sizeGCT   = hasGCT ? pGIF->config.numGlobalPaletteEntries : 0;
+  // translate CGIF_ATTR_* to CGIF_RAW_ATTR_* flags
+  rawConfig.attrFlags = (pGIF->config.attrFlags & CGIF_ATTR_IS_ANIMATED) ? CGIF_RAW_ATTR_IS_ANIMATED : 0;
+  rawConfig.attrFlags |= (pGIF->config.attrFlags & CGIF_ATTR_NO_LOOP) ? CGIF_RAW_ATTR_NO_LOOP : 0;
+  rawConfig.width     = pGIF->config.width;
+  rawConfig.height    = pGIF->config.height;
+  rawConfig.numLoops  = pGIF->config.numLoops;
+  rawConfig.pWriteFn  = writecb;
+  rawConfig.pContext  = (void*)pGIF;
+  // memory output: collected by the raw GIF stream (no write callback)
+  if(pGIF->config.genFlags & CGIF_GEN_MEMORY_OUTPUT) {
+    rawConfig.attrFlags     |= CGIF_RAW_ATTR_MEMORY_OUTPUT;
+    rawConfig.sizeOutputHint = pGIF->config.sizeOutputHint;
+  }
+  // pass config down and create a new raw GIF stream.
+  pGIF->pGIFRaw = cgif_raw_newgif(&rawConfig);
+  return (pGIF->pGIFRaw == NULL) ? CGIF_ERROR : CGIF_OK;
+}
+
+/* distance of two colors: maximum difference per channel or perceptual ("redmean" weighted euclidean distance, CGIF_GEN_PERCEPTUAL_TOLERANCE).
+   the perceptual distance is scaled to the tolerance: a grey that differs by n in all three channels has a distance of about n */
+static int isNearColor(const uint8_t* pA, const uint8_t* pB, uint16_t tolerance, int isPerceptual) {
+  const int32_t dR = (int32_t)pA[0] - pB[0];
+  const int32_t dG = (int32_t)pA[1] - pB[1];
+  const int32_t dB = (int32_t)pA[2] - pB[2];
+
+  if(isPerceptual) {
+    const int32_t rMean = ((int32_t)pA[0] + pB[0]) / 2;
+    const int64_t d2    = (((512 + rMean) * dR * dR) >> 8) + 4 * dG * dG + (((767 - rMean) * dB * dB) >> 8); // a grey step of 1: 9
+    return d2 <= 9 * (int64_t)tolerance * tolerance;
+  }
+  return abs(dR) <= tolerance && abs(dG) <= tolerance && abs(dB) <= tolerance;
+}
+
+/* precompute which indices of the global color table are within colorTolerance of each other (indices outside of the table: only equal to themselves) */
+static void initNearTable(CGIF* pGIF) {
+  const uint8_t* pCT          = pGIF->config.pGlobalPalette;
+  const int      sizeCT       = pGIF->config.numGlobalPaletteEntries;
+  const int      isPerceptual = (pGIF->config.genFlags & CGIF_GEN_PERCEPTUAL_TOLERANCE) ? 1 : 0;
+
+  for(int a = 0; a < 256; ++a) {
+    for(int b = 0; b < 256; ++b) {
+      pGIF->pNearTable[a * 256 + b] = (a == b) || (a < sizeCT && b < sizeCT && isNearColor(pCT + a * 3, pCT + b * 3, pGIF->config.colorTolerance, isPerceptual));
+    }
+  }
+}
+
+/* check whether the global color table is built from the local color tables of the frames (CGIF_GEN_HOIST_GLOBAL_TABLE) */
+static int isHoistingGCT(const CGIF_Config* pConfig) {
+  return (pConfig->genFlags & CGIF_GEN_HOIST_GLOBAL_TABLE) && (pConfig->attrFlags & CGIF_ATTR_NO_GLOBAL_TABLE) && !(pConfig->attrFlags & CGIF_ATTR_HAS_TRANSPARENCY);
+}
+
 /* create a new GIF */
 CGIF* cgif_newgif(CGIF_Config* pConfig) {
   FILE*          pFile;
   CGIF*          pGIF;
-  CGIFRaw*       pGIFRaw; // raw GIF stream
-  CGIFRaw_Config rawConfig = {0};
   // width or heigth cannot be zero
   if(!pConfig->width || !pConfig->height) {
     return NULL;
   }
+  // the frame queue needs at least the frame before and the current frame
+  if(pConfig->sizeFrameQueue == 1 || pConfig->sizeFrameQueue > MAX_FRAME_QUEUE) {
+    return NULL;
+  }
+  // memory output: no file / write callback
+  if((pConfig->genFlags & CGIF_GEN_MEMORY_OUTPUT) && (pConfig->path || pConfig->pWriteFn)) {
+    return NULL;
+  }
   pFile = NULL;
   // open output file (if necessary)
   if(pConfig->path) {
@@ -98,7 +581,27 @@ CGIF* cgif_newgif(CGIF_Config* pConfig) {
   memset(pGIF, 0, sizeof(CGIF));
   pGIF->pFile = pFile;
   pGIF->iHEAD = 1;
+  pGIF->sizeFrameQueue = pConfig->sizeFrameQueue ? pConfig->sizeFrameQueue : SIZE_FRAME_QUEUE;
+  if(pConfig->genFlags & CGIF_GEN_LOW_MEMORY) {
+    pGIF->sizeFrameQueue = 2; // the frame before (canvas) + the pending frame
+  }
   memcpy(&(pGIF->config), pConfig, sizeof(CGIF_Config));
+  // output buffer: the file is written in large chunks (stdio buffering is turned off, each chunk is one write call)
+  if(pFile && !(pConfig->genFlags & CGIF_GEN_NO_OUTPUT_BUFFER)) {
+    pGIF->sizeOutBuf = pConfig->sizeOutputBuffer ? pConfig->sizeOutputBuffer : SIZE_OUTPUT_BUFFER;
+    pGIF->pOutBuf    = malloc(pGIF->sizeOutBuf);
+    if(pGIF->pOutBuf == NULL) {
+      fclose(pFile);
+      free(pGIF);
+      return NULL;
+    }
+    setvbuf(pFile, NULL, _IONBF, 0);
+  }
+#ifdef CGIF_HAVE_FADVISE
+  if(pFile && (pConfig->genFlags & CGIF_GEN_OUTPUT_HINTS)) {
+    posix_fadvise(fileno(pFile), 0, 0, POSIX_FADV_SEQUENTIAL);
+  }
+#endif
   // make a deep copy of global color tabele (GCT), if required.
   if((pConfig->attrFlags & CGIF_ATTR_NO_GLOBAL_TABLE) == 0) {
     pGIF->config.pGlobalPalette = malloc(pConfig->numGlobalPaletteEntries * 3);
@@ -106,360 +609,1244 @@ CGIF* cgif_newgif(CGIF_Config* pConfig) {
       if(pFile) {
         fclose(pFile);
       }
+      free(pGIF->pOutBuf);
       free(pGIF);
       return NULL;
     }
     memcpy(pGIF->config.pGlobalPalette, pConfig->pGlobalPalette, pConfig->numGlobalPaletteEntries * 3);
+    // colors within the tolerance: looked up per pixel
+    if(pConfig->colorTolerance) {
+      pGIF->pNearTable = malloc(256 * 256);
+      if(pGIF->pNearTable == NULL) {
+        if(pFile) {
+          fclose(pFile);
+        }
+        freeCGIF(pGIF);
+        return NULL;
+      }
+      initNearTable(pGIF);
+    }
+  }
+#ifdef CGIF_ASYNC
+  // the output buffers are written by a writer thread (falls back to writing them synchronously)
+  if(pGIF->pOutBuf && (pConfig->genFlags & CGIF_GEN_ASYNC_OUTPUT)) {
+    startWriter(pGIF);
   }
+#endif
 
-  rawConfig.pGCT      = pConfig->pGlobalPalette;
-  rawConfig.sizeGCT   = (pConfig->attrFlags & CGIF_ATTR_NO_GLOBAL_TABLE) ? 0 : pConfig->numGlobalPaletteEntries;
-  // translate CGIF_ATTR_* to CGIF_RAW_ATTR_* flags
-  rawConfig.attrFlags = (pConfig->attrFlags & CGIF_ATTR_IS_ANIMATED) ? CGIF_RAW_ATTR_IS_ANIMATED : 0;
-  rawConfig.attrFlags |= (pConfig->attrFlags & CGIF_ATTR_NO_LOOP) ? CGIF_RAW_ATTR_NO_LOOP : 0;
-  rawConfig.width     = pConfig->width;
-  rawConfig.height    = pConfig->height;
-  rawConfig.numLoops  = pConfig->numLoops;
-  rawConfig.pWriteFn  = writecb;
-  rawConfig.pContext  = (void*)pGIF;
-  // pass config down and create a new raw GIF stream.
-  pGIFRaw = cgif_raw_newgif(&rawConfig);
-  // check for errors
-  if(pGIFRaw == NULL) {
-    if(pFile) {
-      fclose(pFile);
+  // the global color table is built from the first frames: the raw GIF stream is created once the first frame is written (see hoistGlobalTable)
+  if(!isHoistingGCT(pConfig)) {
+    if(createRawGIF(pGIF) != CGIF_OK) {
+#ifdef CGIF_ASYNC
+      if(pGIF->pWriter) {
+        stopWriter(pGIF);
+      }
+#endif
+      if(pFile) {
+        fclose(pFile);
+      }
+      freeCGIF(pGIF);
+      return NULL;
     }
-    freeCGIF(pGIF);
-    return NULL;
   }
-
-  pGIF->pGIFRaw = pGIFRaw;
   // assume error per default.
   // set to CGIF_OK by the first successful cgif_addframe() call, as a GIF without frames is invalid.
   pGIF->curResult = CGIF_PENDING;
   return pGIF;
 }
 
-/* compare given pixel indices using the correct local or global color table; returns 0 if the two pixels are RGB equal */
-static int cmpPixel(const CGIF* pGIF, const CGIF_FrameConfig* pCur, const CGIF_FrameConfig* pBef, const uint8_t iCur, const uint8_t iBef) {
-  uint8_t* pBefCT; // color table to use for pBef
-  uint8_t* pCurCT; // color table to use for pCur
+/* set the canonical color IDs (24-bit RGB value) of all 256 possible indices of a frame; indices outside of the color table get idInvalid */
+static void initPixelIDs(const CGIF* pGIF, const CGIF_FrameConfig* pConfig, uint32_t* aID, uint32_t idInvalid) {
+  const uint8_t* pCT    = (pConfig->attrFlags & CGIF_FRAME_ATTR_USE_LOCAL_TABLE) ? pConfig->pLocalPalette : pGIF->config.pGlobalPalette; // local or global table used?
+  const uint16_t sizeCT = (pConfig->attrFlags & CGIF_FRAME_ATTR_USE_LOCAL_TABLE) ? pConfig->numLocalPaletteEntries : pGIF->config.numGlobalPaletteEntries;
 
-  if((pCur->attrFlags & CGIF_FRAME_ATTR_HAS_SET_TRANS) && iCur == pCur->transIndex) {
-    return 0; // identical
+  for(int i = 0; i < 256; ++i) {
+    aID[i] = (i < sizeCT) ? (((uint32_t)pCT[i * 3] << 16) | ((uint32_t)pCT[i * 3 + 1] << 8) | pCT[i * 3 + 2]) : idInvalid;
   }
-  if((pBef->attrFlags & CGIF_FRAME_ATTR_HAS_SET_TRANS) && iBef == pBef->transIndex) {
-    return 1; // done: cannot compare
+}
+
+/* build the pixel equivalence table of the given frame pair (once per frame pair instead of color table lookups per pixel) */
+static void initPixelEqTable(const CGIF* pGIF, const CGIF_FrameConfig* pCur, const CGIF_FrameConfig* pBef, PixelEqTable* pEq) {
+  initPixelIDs(pGIF, pCur, pEq->aCur, PIXEL_ID_NONE_CUR);
+  initPixelIDs(pGIF, pBef, pEq->aBef, PIXEL_ID_NONE_BEF);
+  if(pBef->attrFlags & CGIF_FRAME_ATTR_HAS_SET_TRANS) {
+    pEq->aBef[pBef->transIndex] = PIXEL_ID_NONE_BEF; // cannot compare
   }
-  // safety bounds check
-  const uint16_t sizeCTBef = (pBef->attrFlags & CGIF_FRAME_ATTR_USE_LOCAL_TABLE) ? pBef->numLocalPaletteEntries : pGIF->config.numGlobalPaletteEntries;
-  const uint16_t sizeCTCur = (pCur->attrFlags & CGIF_FRAME_ATTR_USE_LOCAL_TABLE) ? pCur->numLocalPaletteEntries : pGIF->config.numGlobalPaletteEntries;
-  if((iBef >= sizeCTBef) || (iCur >= sizeCTCur)) {
-    return 1; // error: out-of-bounds - cannot compare
+  if(pCur->attrFlags & CGIF_FRAME_ATTR_HAS_SET_TRANS) {
+    pEq->aCur[pCur->transIndex] = PIXEL_ID_ANY; // identical
   }
-  pBefCT = (pBef->attrFlags & CGIF_FRAME_ATTR_USE_LOCAL_TABLE) ? pBef->pLocalPalette : pGIF->config.pGlobalPalette; // local or global table used?
-  pCurCT = (pCur->attrFlags & CGIF_FRAME_ATTR_USE_LOCAL_TABLE) ? pCur->pLocalPalette : pGIF->config.pGlobalPalette; // local or global table used?
-  return memcmp(pBefCT + iBef * 3, pCurCT + iCur * 3, 3);
 }
 
-// compare given frames; returns 0 if frames are equal and 1 if they differ. If they differ, pResult returns area of difference
-static int getDiffArea(CGIF* pGIF, CGIF_FrameConfig* pCur, CGIF_FrameConfig* pBef, DimResult *pResult) {
-  const uint8_t* pCurImageData;
-  const uint8_t* pBefImageData;
-  uint16_t       i, x;
-  uint16_t       newHeight, newWidth, newLeft, newTop;
-  const uint16_t width  = pGIF->config.width;
-  const uint16_t height = pGIF->config.height;
-  uint8_t        iCur, iBef;
-
-  pCurImageData = pCur->pImageData;
-  pBefImageData = pBef->pImageData;
-  // find top
-  i = 0;
-  while(i < height) {
-    for(int c = 0; c < width; ++c) {
-      iCur = *(pCurImageData + MULU16(i, width) + c);
-      iBef = *(pBefImageData + MULU16(i, width) + c);
-      if(cmpPixel(pGIF, pCur, pBef, iCur, iBef) != 0) {
-        goto FoundTop;
+/* pixels of colors merged by lossy transparency might show another color on the canvas: they match no pixel (repainted by the next frame) */
+static void markMergedPixels(const CGIF_Frame* pBef, PixelEqTable* pEq) {
+  if(pBef->hasMerged) {
+    for(int c = 0; c < 256; ++c) {
+      if(pBef->aIsMerged[c]) {
+        pEq->aBef[c] = PIXEL_ID_NONE_BEF;
       }
     }
-    ++i;
   }
-FoundTop:
-  if(i == height) {
-    return 0;
+}
+
+/* set the color IDs of all 256 possible indices of a frame for the content hash (indices outside of the color table are kept apart) */
+static void initHashIDs(const CGIF* pGIF, const CGIF_FrameConfig* pConfig, uint32_t* aID) {
+  initPixelIDs(pGIF, pConfig, aID, PIXEL_ID_NONE_CUR);
+  for(int c = 0; c < 256; ++c) {
+    aID[c] = (aID[c] == PIXEL_ID_NONE_CUR) ? (uint32_t)(0x01000000 | c) : aID[c];
+  }
+}
+
+/* 64-bit content hash of a frame with the color table resolved (frames that look the same have the same hash) */
+static uint64_t hashFrame(const CGIF* pGIF, const CGIF_FrameConfig* pConfig) {
+  uint32_t       aID[256];
+  const uint8_t* pImageData = pConfig->pImageData;
+  const uint32_t numPixel   = MULU16(pGIF->config.width, pGIF->config.height);
+  uint64_t       h          = numPixel;
+  uint32_t       i;
+
+  initHashIDs(pGIF, pConfig, aID);
+  // two pixels per step: xor, multiply, xorshift
+  for(i = 0; i + 2 <= numPixel; i += 2) {
+    h ^= ((uint64_t)aID[pImageData[i]] << 32) | aID[pImageData[i + 1]];
+    h *= 0x9E3779B97F4A7C15uLL;
+    h ^= h >> 29;
+  }
+  if(i < numPixel) {
+    h ^= aID[pImageData[i]];
+    h *= 0x9E3779B97F4A7C15uLL;
+    h ^= h >> 29;
   }
-  newTop = i;
+  return h;
+}
 
-  // find actual height
-  i = height - 1;
-  while(i > newTop) {
-    for(int c = 0; c < width; ++c) {
-      iCur = *(pCurImageData + MULU16(i, width) + c);
-      iBef = *(pBefImageData + MULU16(i, width) + c);
-      if(cmpPixel(pGIF, pCur, pBef, iCur, iBef) != 0) {
-        goto FoundHeight;
-      }
-    }
-    --i;
+/* compare given pixel indices using the pixel equivalence table of the frame pair; returns 0 if the two pixels are RGB equal */
+static int cmpPixel(const PixelEqTable* pEq, const uint8_t iCur, const uint8_t iBef) {
+  const uint32_t idCur = pEq->aCur[iCur];
+  return (idCur != pEq->aBef[iBef]) & (idCur != PIXEL_ID_ANY);
+}
+
+/* returns the first index in [0, n) where the two byte arrays differ (n if they are equal) */
+static uint32_t findFirstDiff(const uint8_t* pA, const uint8_t* pB, uint32_t n) {
+  uint32_t i = 0;
+  uint32_t mask;
+
+  // fast path for equal rows (memcmp uses the widest vector ISA available at runtime)
+  if(memcmp(pA, pB, n) == 0) {
+    return n;
   }
-FoundHeight:
-  newHeight = (i + 1) - newTop;
 
-  // find left
-  i = newTop;
-  x = 0;
-  while(cmpPixel(pGIF, pCur, pBef, pCurImageData[MULU16(i, width) + x], pBefImageData[MULU16(i, width) + x]) == 0) {
-    ++i;
-    if(i > (newTop + newHeight - 1)) {
-      ++x; //(x==width cannot happen as return 0 is trigged in the only possible case before)
-      i = newTop;
+#ifdef CGIF_DIFF_AVX2
+  for(; i + 32 <= n; i += 32) {
+    const __m256i a = _mm256_loadu_si256((const __m256i*)(pA + i));
+    const __m256i b = _mm256_loadu_si256((const __m256i*)(pB + i));
+    mask = ~(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(a, b));
+    if(mask) {
+      return i + bitScanForward32(mask);
+    }
+  }
+#endif
+#if defined(CGIF_DIFF_SSE2)
+  for(; i + 16 <= n; i += 16) {
+    const __m128i a = _mm_loadu_si128((const __m128i*)(pA + i));
+    const __m128i b = _mm_loadu_si128((const __m128i*)(pB + i));
+    mask = ~(uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(a, b)) & 0xFFFF;
+    if(mask) {
+      return i + bitScanForward32(mask);
+    }
+  }
+#elif defined(CGIF_DIFF_NEON)
+  for(; i + 16 <= n; i += 16) {
+    // narrow the 16 byte compare result to a 64-bit mask (4 bits per byte)
+    const uint8x16_t eq    = vceqq_u8(vld1q_u8(pA + i), vld1q_u8(pB + i));
+    const uint64_t   mask4 = ~vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(eq), 4)), 0);
+    if(mask4) {
+      return i + ((uint32_t)__builtin_ctzll(mask4) >> 2);
+    }
+  }
+#endif
+  (void)mask;
+  for(; i < n; ++i) {
+    if(pA[i] != pB[i]) {
+      return i;
     }
   }
-  newLeft = x;
+  return n;
+}
+
+/* returns one past the last index in [0, n) where the two byte arrays differ (0 if they are equal) */
+static uint32_t findLastDiff(const uint8_t* pA, const uint8_t* pB, uint32_t n) {
+  uint32_t mask;
+
+  if(memcmp(pA, pB, n) == 0) {
+    return 0;
+  }
 
-  // find actual width
-  i = newTop;
-  x = width - 1;
-  while(cmpPixel(pGIF, pCur, pBef, pCurImageData[MULU16(i, width) + x], pBefImageData[MULU16(i, width) + x]) == 0) {
-    ++i;
-    if(i > (newTop + newHeight - 1)) {
-      --x; //(x<newLeft cannot happen as return 0 is trigged in the only possible case before)
-      i = newTop;
+#ifdef CGIF_DIFF_AVX2
+  for(; n >= 32; n -= 32) {
+    const __m256i a = _mm256_loadu_si256((const __m256i*)(pA + n - 32));
+    const __m256i b = _mm256_loadu_si256((const __m256i*)(pB + n - 32));
+    mask = ~(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(a, b));
+    if(mask) {
+      return n - 32 + bitScanReverse32(mask) + 1;
+    }
+  }
+#endif
+#if defined(CGIF_DIFF_SSE2)
+  for(; n >= 16; n -= 16) {
+    const __m128i a = _mm_loadu_si128((const __m128i*)(pA + n - 16));
+    const __m128i b = _mm_loadu_si128((const __m128i*)(pB + n - 16));
+    mask = ~(uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(a, b)) & 0xFFFF;
+    if(mask) {
+      return n - 16 + bitScanReverse32(mask) + 1;
+    }
+  }
+#elif defined(CGIF_DIFF_NEON)
+  for(; n >= 16; n -= 16) {
+    const uint8x16_t eq    = vceqq_u8(vld1q_u8(pA + n - 16), vld1q_u8(pB + n - 16));
+    const uint64_t   mask4 = ~vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(eq), 4)), 0);
+    if(mask4) {
+      return n - 16 + ((uint32_t)(63 - __builtin_clzll(mask4)) >> 2) + 1;
+    }
+  }
+#endif
+  (void)mask;
+  for(; n > 0; --n) {
+    if(pA[n - 1] != pB[n - 1]) {
+      return n;
     }
   }
-  newWidth = (x + 1) - newLeft;
+  return 0;
+}
 
-  pResult->width  = newWidth;
-  pResult->height = newHeight;
-  pResult->top    = newTop;
-  pResult->left   = newLeft;
-  return 1;
+/* returns the first column in [0, end) where the two rows differ (end if there is none) */
+static uint16_t findFirstDiffCol(const PixelEqTable* pEq, const uint8_t* pCurRow, const uint8_t* pBefRow, uint16_t end) {
+  uint16_t x;
+
+  if(pEq == NULL) {
+    return (uint16_t)findFirstDiff(pCurRow, pBefRow, end);
+  }
+  for(x = 0; x < end && cmpPixel(pEq, pCurRow[x], pBefRow[x]) == 0; ++x);
+  return x;
 }
 
-// compare given global palette frames; returns 0 if frames are equal and 1 if they differ. If they differ, pResult returns area of difference
-static int getDiffAreaGlobalPalette(CGIF* pGIF, CGIF_FrameConfig* pCur, CGIF_FrameConfig* pBef, DimResult *pResult) {
+/* returns one past the last column in [start, end) where the two rows differ (start if there is none) */
+static uint16_t findLastDiffCol(const PixelEqTable* pEq, const uint8_t* pCurRow, const uint8_t* pBefRow, uint16_t start, uint16_t end) {
+  uint16_t x;
+
+  if(pEq == NULL) {
+    return start + (uint16_t)findLastDiff(pCurRow + start, pBefRow + start, end - start);
+  }
+  for(x = end; x > start && cmpPixel(pEq, pCurRow[x - 1], pBefRow[x - 1]) == 0; --x);
+  return x;
+}
+
+// compare given frames within pWindow; returns 0 if frames are equal and 1 if they differ. If they differ, pResult returns area of difference
+// pEq: pixel equivalence table of the frame pair, NULL if the color indices can be compared directly (same color table, no user-provided transparency).
+// the frames are scanned row by row (single pass): only the columns left/right of the area found so far need to be checked.
+static int getDiffAreaWindow(CGIF* pGIF, const CGIF_FrameConfig* pCur, const CGIF_FrameConfig* pBef, const DimResult* pWindow, DimResult *pResult, const PixelEqTable* pEq) {
   const uint8_t* pCurImageData;
   const uint8_t* pBefImageData;
   uint32_t       offset;
-  uint16_t       i, x;
-  uint16_t       newHeight, newWidth, newLeft, newTop;
-  const uint16_t width  = pGIF->config.width;
-  const uint16_t height = pGIF->config.height;
+  uint16_t       i, top, bottom, left, right, x;
+  const uint16_t stride = pGIF->config.width;
+  const uint16_t width  = pWindow->width;
+  const uint16_t height = pWindow->height;
 
-  pCurImageData = pCur->pImageData;
-  pBefImageData = pBef->pImageData;
+  // rows start at the left edge of the window (columns relative to it)
+  pCurImageData = pCur->pImageData + MULU16(pWindow->top, stride) + pWindow->left;
+  pBefImageData = pBef->pImageData + MULU16(pWindow->top, stride) + pWindow->left;
   // find top
-  i = 0;
+  left   = width;
   offset = 0;
-  while(i < height) {
-    if (memcmp(pCurImageData + offset, pBefImageData + offset, width)) {
+  for(top = 0; top < height; ++top) {
+    left = findFirstDiffCol(pEq, pCurImageData + offset, pBefImageData + offset, width);
+    if(left < width) {
       break;
     }
-    ++i;
-    offset += width;
+    offset += stride;
   }
-
-  if(i == height) {
+  if(top == height) {
     return 0;
   }
-  newTop = i;
+  right = findLastDiffCol(pEq, pCurImageData + offset, pBefImageData + offset, left + 1, width);
 
-  // find actual height
-  i = height - 1;
-  offset = MULU16(i, width);
-  while(i > newTop) {
-    if (memcmp(pCurImageData + offset, pBefImageData + offset, width)) {
+  // find bottom
+  offset = MULU16(height - 1, stride);
+  for(bottom = height - 1; bottom > top; --bottom) {
+    x = findLastDiffCol(pEq, pCurImageData + offset, pBefImageData + offset, 0, width);
+    if(x > 0) {
+      right = (x > right) ? x : right;
+      left  = findFirstDiffCol(pEq, pCurImageData + offset, pBefImageData + offset, left);
       break;
     }
-    --i;
-    offset -= width;
-  }
-  newHeight = (i + 1) - newTop;
-
-  // find left
-  i = newTop;
-  x = 0;
-  offset = MULU16(i, width);
-  while(pCurImageData[offset + x] == pBefImageData[offset + x]) {
-    ++i;
-    offset += width;
-    if(i > (newTop + newHeight - 1)) {
-      ++x; //(x==width cannot happen as return 0 is triggered in the only possible case before)
-      i = newTop;
-      offset = MULU16(i, width);
-    }
-  }
-  newLeft = x;
-
-  // find actual width
-  i = newTop;
-  x = width - 1;
-  offset = MULU16(i, width);
-  while(pCurImageData[offset + x] == pBefImageData[offset + x]) {
-    ++i;
-    offset += width;
-    if(i > (newTop + newHeight - 1)) {
-      --x; //(x<newLeft cannot happen as return 0 is triggered in the only possible case before)
-      i = newTop;
-      offset = MULU16(i, width);
-    }
-  }
-  newWidth = (x + 1) - newLeft;
-
-  pResult->width  = newWidth;
-  pResult->height = newHeight;
-  pResult->top    = newTop;
-  pResult->left   = newLeft;
+    offset -= stride;
+  }
+
+  // widen left/right using the rows in between
+  offset = MULU16(top + 1, stride);
+  for(i = top + 1; i < bottom && (left > 0 || right < width); ++i) {
+    left  = findFirstDiffCol(pEq, pCurImageData + offset, pBefImageData + offset, left);
+    right = findLastDiffCol(pEq, pCurImageData + offset, pBefImageData + offset, right, width);
+    offset += stride;
+  }
+
+  pResult->width  = right - left;
+  pResult->height = (bottom + 1) - top;
+  pResult->top    = pWindow->top + top;
+  pResult->left   = pWindow->left + left;
   return 1;
 }
 
-/* optimize GIF file size by only redrawing the rectangular area that differs from previous frame */
-static uint8_t* doWidthHeightOptim(CGIF* pGIF, CGIF_FrameConfig* pCur, CGIF_FrameConfig* pBef, DimResult* pResult) {
-  uint16_t i;
-  uint8_t* pNewImageData;
-  const uint16_t width  = pGIF->config.width;
-  const uint8_t* pCurImageData = pCur->pImageData;
-  int diffFrame;
-
-  if ((pBef->attrFlags & CGIF_FRAME_ATTR_USE_LOCAL_TABLE) == 0 && (pCur->attrFlags & CGIF_FRAME_ATTR_USE_LOCAL_TABLE) == 0
-      && (pBef->attrFlags & CGIF_FRAME_ATTR_HAS_SET_TRANS) == 0 && (pCur->attrFlags & CGIF_FRAME_ATTR_HAS_SET_TRANS) == 0) {
-    // Both frames use global palette; use fast comparison.
-    diffFrame = getDiffAreaGlobalPalette(pGIF, pCur, pBef, pResult);
-  } else {
-    diffFrame = getDiffArea(pGIF, pCur, pBef, pResult);
-  }
+// compare given frames (whole frame, see getDiffAreaWindow)
+static int getDiffArea(CGIF* pGIF, CGIF_FrameConfig* pCur, CGIF_FrameConfig* pBef, DimResult *pResult, const PixelEqTable* pEq) {
+  const DimResult window = { pGIF->config.width, pGIF->config.height, 0, 0 };
 
-  if (diffFrame == 0) { // need dummy pixel (frame is identical with one before)
-    // TBD we might make it possible to merge identical frames in the future
-    pResult->width  = 1;
-    pResult->height = 1;
-    pResult->left   = 0;
-    pResult->top    = 0;
-  }
+  return getDiffAreaWindow(pGIF, pCur, pBef, &window, pResult, pEq);
+}
 
-  // create new image data
-  pNewImageData = malloc(MULU16(pResult->width, pResult->height));
-  if(pNewImageData == NULL) {
-    return NULL; // allocation failed
-  }
-  for (i = 0; i < pResult->height; ++i) {
-    memcpy(pNewImageData + MULU16(i, pResult->width), pCurImageData + MULU16((i + pResult->top), width) + pResult->left, pResult->width);
-  }
+/* returns 1 if the two frames can be compared by their color indices (same color table, no user-provided transparency) */
+static int canCmpIndices(const CGIF_FrameConfig* pCur, const CGIF_FrameConfig* pBef) {
+  return ((pBef->attrFlags & CGIF_FRAME_ATTR_USE_LOCAL_TABLE) == 0 && (pCur->attrFlags & CGIF_FRAME_ATTR_USE_LOCAL_TABLE) == 0
+          && (pBef->attrFlags & CGIF_FRAME_ATTR_HAS_SET_TRANS) == 0 && (pCur->attrFlags & CGIF_FRAME_ATTR_HAS_SET_TRANS) == 0);
+}
 
-  return pNewImageData;
+/* number of tiles per row / in total (see CGIF_GEN_TILE_HASH) */
+static uint32_t getNumTilesX(const CGIF* pGIF) {
+  return (pGIF->config.width + TILE_SIZE - 1) / TILE_SIZE;
+}
+static uint32_t getNumTiles(const CGIF* pGIF) {
+  return getNumTilesX(pGIF) * ((pGIF->config.height + TILE_SIZE - 1) / TILE_SIZE);
 }
 
-/* move frame down to the raw GIF API */
-static cgif_result flushFrame(CGIF* pGIF, CGIF_Frame* pCur, CGIF_Frame* pBef) {
-  CGIFRaw_FrameConfig rawConfig;
-  DimResult           dimResult;
-  uint8_t*            pTmpImageData;
-  uint8_t*            pBefImageData;
-  int                 isFirstFrame, useLCT, hasAlpha, hasSetTransp;
-  uint16_t            numPaletteEntries;
-  uint16_t            imageWidth, imageHeight, width, height, top, left;
-  uint8_t             transIndex, disposalMethod;
-  cgif_result         r;
+/* area of tile t (tiles at the right/bottom edge might be smaller) */
+static void getTileArea(const CGIF* pGIF, uint32_t t, DimResult* pTile) {
+  const uint32_t numTilesX = getNumTilesX(pGIF);
 
-  imageWidth     = pGIF->config.width;
-  imageHeight    = pGIF->config.height;
-  isFirstFrame   = (pBef == NULL) ? 1 : 0;
-  useLCT         = (pCur->config.attrFlags & CGIF_FRAME_ATTR_USE_LOCAL_TABLE) ? 1 : 0; // LCT stands for "local color table"
-  hasAlpha       = ((pGIF->config.attrFlags & CGIF_ATTR_HAS_TRANSPARENCY) || (pCur->config.attrFlags & CGIF_FRAME_ATTR_HAS_ALPHA)) ? 1 : 0;
-  hasSetTransp   = (pCur->config.attrFlags & CGIF_FRAME_ATTR_HAS_SET_TRANS) ? 1 : 0;
-  disposalMethod = pCur->disposalMethod;
-  transIndex     = pCur->transIndex;
-  // deactivate impossible size optimizations
-  //  => in case alpha channel is used
-  // CGIF_FRAME_GEN_USE_TRANSPARENCY and CGIF_FRAME_GEN_USE_DIFF_WINDOW are not possible
-  if(isFirstFrame || hasAlpha) {
-    pCur->config.genFlags &= ~(CGIF_FRAME_GEN_USE_TRANSPARENCY | CGIF_FRAME_GEN_USE_DIFF_WINDOW);
-  }
-  // transparency setting (which areas are identical to the frame before) provided by user:
-  // CGIF_FRAME_GEN_USE_TRANSPARENCY not possible
-  if(hasSetTransp) {
-    pCur->config.genFlags &= ~(CGIF_FRAME_GEN_USE_TRANSPARENCY);
-  }
-  numPaletteEntries = (useLCT) ? pCur->config.numLocalPaletteEntries : pGIF->config.numGlobalPaletteEntries;
-  // switch off transparency optimization if color table is full (no free spot for the transparent index), TBD: count used colors, adapt table
-  if(numPaletteEntries == 256) {
-    pCur->config.genFlags &= ~CGIF_FRAME_GEN_USE_TRANSPARENCY;
-  }
+  pTile->left   = (t % numTilesX) * TILE_SIZE;
+  pTile->top    = (t / numTilesX) * TILE_SIZE;
+  pTile->width  = (pGIF->config.width - pTile->left < TILE_SIZE) ? pGIF->config.width - pTile->left : TILE_SIZE;
+  pTile->height = (pGIF->config.height - pTile->top < TILE_SIZE) ? pGIF->config.height - pTile->top : TILE_SIZE;
+}
 
-  // purge overlap of current frame and frame before (width - height optim), if required (CGIF_FRAME_GEN_USE_DIFF_WINDOW set)
-  if(pCur->config.genFlags & CGIF_FRAME_GEN_USE_DIFF_WINDOW) {
-    pTmpImageData = doWidthHeightOptim(pGIF, &pCur->config, &pBef->config, &dimResult);
-    if(pTmpImageData == NULL) {
-      return CGIF_EALLOC; // allocation failed in doWidthHeightOptim
-    }
-    width  = dimResult.width;
-    height = dimResult.height;
-    top    = dimResult.top;
-    left   = dimResult.left;
-  } else {
-    pTmpImageData = NULL;
-    width         = imageWidth;
-    height        = imageHeight;
-    top           = 0;
-    left          = 0;
-  }
+/* one step of the tile hash: xor, multiply, xorshift */
+static uint64_t mixTileHash(uint64_t h, uint64_t w) {
+  h ^= w;
+  h *= 0x9E3779B97F4A7C15uLL;
+  return h ^ (h >> 29);
+}
 
-  // mark matching areas of the previous frame as transparent, if required (CGIF_FRAME_GEN_USE_TRANSPARENCY set)
-  if(pCur->config.genFlags & CGIF_FRAME_GEN_USE_TRANSPARENCY) {
-    // set transIndex to next free index
-    int pow2 = calcNextPower2Ex(numPaletteEntries);
-    pow2 = (pow2 < 2) ? 2 : pow2; // TBD keep transparency index behavior as in V0.1.0 (for now)
-    transIndex = (1 << pow2) - 1;
-    if(transIndex < numPaletteEntries) {
-      transIndex = (1 << (pow2 + 1)) - 1;
+/* 64-bit hash of the color indices of each tile (even, see CGIF_Frame.pTileTags).
+   four independent lanes per tile (instruction-level parallelism). the tiles of a row are processed in chunks of TILE_HASH_CHUNK tiles (lanes kept on the stack) */
+#define TILE_HASH_CHUNK (16)
+static void hashTiles(const CGIF* pGIF, const uint8_t* pImageData, uint64_t* aTag) {
+  uint64_t       aLane[TILE_HASH_CHUNK][4];
+  uint64_t       w[4];
+  const uint16_t width     = pGIF->config.width;
+  const uint32_t numTilesX = getNumTilesX(pGIF);
+  uint32_t       numChunk;
+  DimResult      tile;
+
+  for(uint32_t t = 0; t < getNumTiles(pGIF); t += numChunk) {
+    // tiles t ... t + numChunk - 1 (same tile row)
+    numChunk = (numTilesX - t % numTilesX < TILE_HASH_CHUNK) ? numTilesX - t % numTilesX : TILE_HASH_CHUNK;
+    getTileArea(pGIF, t, &tile);
+    for(uint32_t c = 0; c < numChunk; ++c) {
+      aLane[c][0] = 0x243F6A8885A308D3uLL;
+      aLane[c][1] = 0x13198A2E03707344uLL;
+      aLane[c][2] = 0xA4093822299F31D0uLL;
+      aLane[c][3] = 0x082EFA98EC4E6C89uLL;
     }
-    if(pTmpImageData == NULL) {
-      pTmpImageData = malloc(MULU16(imageWidth, imageHeight));
-      if(pTmpImageData == NULL) {
-        return CGIF_EALLOC; // allocation failed
+    for(uint16_t y = tile.top; y < tile.top + tile.height; ++y) {
+      const uint8_t* pRow = pImageData + MULU16(y, width);
+      uint32_t       x    = tile.left;
+      uint32_t       c;
+
+      // full tiles: 4 x 2 steps of 8 bytes each
+      for(c = 0; c < numChunk && x + TILE_SIZE <= width; ++c, x += TILE_SIZE) {
+        uint64_t h0 = aLane[c][0], h1 = aLane[c][1], h2 = aLane[c][2], h3 = aLane[c][3];
+        for(int i = 0; i < TILE_SIZE; i += 32) {
+          memcpy(w, pRow + x + i, 32);
+          h0 = mixTileHash(h0, w[0]);
+          h1 = mixTileHash(h1, w[1]);
+          h2 = mixTileHash(h2, w[2]);
+          h3 = mixTileHash(h3, w[3]);
+        }
+        aLane[c][0] = h0;
+        aLane[c][1] = h1;
+        aLane[c][2] = h2;
+        aLane[c][3] = h3;
       }
-      memcpy(pTmpImageData, pCur->config.pImageData, MULU16(imageWidth, imageHeight));
-    }
-    pBefImageData = pBef->config.pImageData;
-    for(int i = 0; i < height; ++i) {
-      for(int x = 0; x < width; ++x) {
-        if(cmpPixel(pGIF, &pCur->config, &pBef->config, pTmpImageData[MULU16(i, width) + x], pBefImageData[MULU16(top + i, imageWidth) + (left + x)]) == 0) {
-          pTmpImageData[MULU16(i, width) + x] = transIndex;
+      // tile at the right edge
+      if(c < numChunk) {
+        for(int i = 0; x < width; x += 8, ++i) {
+          w[0] = 0;
+          memcpy(w, pRow + x, (width - x < 8) ? width - x : 8);
+          aLane[c][i % 4] = mixTileHash(aLane[c][i % 4], w[0]);
         }
       }
     }
+    for(uint32_t c = 0; c < numChunk; ++c) {
+      aTag[t + c] = mixTileHash(mixTileHash(mixTileHash(aLane[c][0], aLane[c][1]), aLane[c][2]), aLane[c][3]) & ~(uint64_t)1;
+    }
   }
-
-  // move frame down to GIF raw API
-  rawConfig.pLCT           = pCur->config.pLocalPalette;
-  rawConfig.pImageData     = (pTmpImageData) ? pTmpImageData : pCur->config.pImageData;
-  rawConfig.attrFlags      = 0;
-  if(hasAlpha || (pCur->config.genFlags & CGIF_FRAME_GEN_USE_TRANSPARENCY) || hasSetTransp) {
-    rawConfig.attrFlags |= CGIF_RAW_FRAME_ATTR_HAS_TRANS;
-  }
-  rawConfig.attrFlags |= (pCur->config.attrFlags & CGIF_FRAME_ATTR_INTERLACED) ? CGIF_RAW_FRAME_ATTR_INTERLACED : 0;
-  rawConfig.width          = width;
-  rawConfig.height         = height;
-  rawConfig.top            = top;
-  rawConfig.left           = left;
-  rawConfig.delay          = pCur->config.delay;
-  rawConfig.sizeLCT        = (useLCT) ? pCur->config.numLocalPaletteEntries : 0;
-  rawConfig.disposalMethod = disposalMethod;
-  rawConfig.transIndex     = transIndex;
-  r = cgif_raw_addframe(pGIF->pGIFRaw, &rawConfig);
-  free(pTmpImageData);
-  return r;
 }
 
-static void freeFrame(CGIF_Frame* pFrame) {
+/* compare the frame being added (pImageData, tags in pGIF->pTileTags) with pHead row by row: a tile with the content hash of the tile in pHead,
+   but different pixels (hash collision) gets a unique tag */
+static void confirmTileTags(CGIF* pGIF, const uint8_t* pImageData, const CGIF_Frame* pHead) {
+  const uint16_t width     = pGIF->config.width;
+  const uint32_t numTilesX = getNumTilesX(pGIF);
+
+  for(uint16_t y = 0; y < pGIF->config.height; ++y) {
+    const uint8_t* pCurRow = pImageData + MULU16(y, width);
+    const uint8_t* pBefRow = pHead->config.pImageData + MULU16(y, width);
+    const uint32_t t0      = (y / TILE_SIZE) * numTilesX;
+    if(!memcmp(pCurRow, pBefRow, width)) {
+      continue; // fast path for equal rows
+    }
+    for(uint32_t t = t0; t < t0 + numTilesX; ++t) {
+      const uint32_t x = (t - t0) * TILE_SIZE;
+      if(pGIF->pTileTags[t] == pHead->pTileTags[t] && memcmp(pCurRow + x, pBefRow + x, (width - x < TILE_SIZE) ? width - x : TILE_SIZE)) {
+        pGIF->pTileTags[t] = (pGIF->nextTileTag++ << 1) | 1;
+      }
+    }
+  }
+}
+
+/* set the tile tags of the frame being added (pGIF->pTileTags):
+   pBase: tiles that are not dirty take the tags of this frame (NULL: all tiles are dirty).
+   dirty tiles (pDirtyTiles or within pRect) are hashed (pImageData given) or get a unique tag (no hashing).
+   pHead: frame added before (with tile tags, NULL: none), hashed tiles with the same content hash are compared (see confirmTileTags) */
+static void setTileTags(CGIF* pGIF, const uint8_t* pImageData, const CGIF_Frame* pBase, const uint8_t* pDirtyTiles, const DimResult* pRect, const CGIF_Frame* pHead) {
+  DimResult tile;
+
+  if(pBase == NULL && pImageData) {
+    hashTiles(pGIF, pImageData, pGIF->pTileTags);
+    if(pHead) {
+      confirmTileTags(pGIF, pImageData, pHead);
+    }
+    return;
+  }
+  for(uint32_t t = 0; t < getNumTiles(pGIF); ++t) {
+    int isDirty = 1;
+    if(pBase && pDirtyTiles) {
+      isDirty = pDirtyTiles[t];
+    } else if(pBase && pRect) {
+      getTileArea(pGIF, t, &tile);
+      isDirty = tile.left < pRect->left + pRect->width && pRect->left < tile.left + tile.width && tile.top < pRect->top + pRect->height && pRect->top < tile.top + tile.height;
+    }
+    pGIF->pTileTags[t] = (isDirty) ? (pGIF->nextTileTag++ << 1) | 1 : pBase->pTileTags[t];
+  }
+}
+
+/* check whether the frame being added (pImageData, tags in pGIF->pTileTags) is identical with pHead by their tile tags:
+   equal tags: equal tiles (set against pHead, see setTileTags). different content hashes: the tiles differ for sure. otherwise (unique tags): compare the tiles */
+static int isSameByTiles(const CGIF* pGIF, const uint8_t* pImageData, const CGIF_Frame* pHead) {
+  DimResult tile;
+
+  for(uint32_t t = 0; t < getNumTiles(pGIF); ++t) {
+    const uint64_t tag = pGIF->pTileTags[t];
+    if(tag == pHead->pTileTags[t]) {
+      continue;
+    }
+    if(!(tag & 1) && !(pHead->pTileTags[t] & 1)) {
+      return 0;
+    }
+    getTileArea(pGIF, t, &tile);
+    for(uint16_t y = tile.top; y < tile.top + tile.height; ++y) {
+      const uint32_t offset = MULU16(y, pGIF->config.width) + tile.left;
+      if(memcmp(pImageData + offset, pHead->config.pImageData + offset, tile.width)) {
+        return 0;
+      }
+    }
+  }
+  return 1;
+}
+
+/* compare two frames with tile tags (see getDiffAreaWindow): only tiles with different tags are scanned.
+   equal content hashes are equal tiles only if the tags of pCur were set against pBef (see confirmTileTags), otherwise such tiles are scanned as well.
+   tiles within the area found so far cannot widen it and are skipped. */
+static int getDiffAreaTiles(CGIF* pGIF, const CGIF_Frame* pCur, const CGIF_Frame* pBef, DimResult* pResult) {
+  DimResult tile, diff;
+  uint32_t  left, top, right, bottom;
+  int       isDiff = 0;
+  const int isBase = (pCur->tagsBaseID == pBef->tagsID);
+
+  left   = pGIF->config.width;
+  top    = pGIF->config.height;
+  right  = 0;
+  bottom = 0;
+  for(uint32_t t = 0; t < getNumTiles(pGIF); ++t) {
+    if(pCur->pTileTags[t] == pBef->pTileTags[t] && (isBase || (pCur->pTileTags[t] & 1))) {
+      continue;
+    }
+    getTileArea(pGIF, t, &tile);
+    if(isDiff && tile.left >= left && tile.top >= top && tile.left + tile.width <= right && tile.top + tile.height <= bottom) {
+      continue;
+    }
+    if(getDiffAreaWindow(pGIF, &pCur->config, &pBef->config, &tile, &diff, NULL)) {
+      left   = (diff.left < left) ? diff.left : left;
+      top    = (diff.top < top) ? diff.top : top;
+      right  = (diff.left + diff.width > right) ? diff.left + diff.width : right;
+      bottom = (diff.top + diff.height > bottom) ? diff.top + diff.height : bottom;
+      isDiff = 1;
+    }
+  }
+  if(!isDiff) {
+    return 0;
+  }
+  pResult->width  = right - left;
+  pResult->height = bottom - top;
+  pResult->top    = top;
+  pResult->left   = left;
+  return 1;
+}
+
+/* compare two frames (whole frame): by their tile tags if both have them, otherwise see getDiffArea.
+   colors of pBef merged by lossy transparency: by pEq only (see markMergedPixels) */
+static int getFrameDiffArea(CGIF* pGIF, CGIF_Frame* pCur, CGIF_Frame* pBef, const PixelEqTable* pEq, DimResult* pResult) {
+  if(pCur->hasTileTags && pBef->hasTileTags && !pBef->hasMerged) {
+    return getDiffAreaTiles(pGIF, pCur, pBef, pResult); // global color table only: the color indices are compared
+  }
+  // Both frames use global palette; use fast comparison of the color indices.
+  return getDiffArea(pGIF, &pCur->config, &pBef->config, pResult, (canCmpIndices(&pCur->config, &pBef->config) && !pBef->hasMerged) ? NULL : pEq);
+}
+
+/* optimize GIF file size by only redrawing the rectangular area that differs from previous frame */
+static void doWidthHeightOptim(CGIF* pGIF, CGIF_Frame* pCur, CGIF_Frame* pBef, const PixelEqTable* pEq, DimResult* pResult) {
+  int diffFrame;
+
+  diffFrame = getFrameDiffArea(pGIF, pCur, pBef, pEq, pResult);
+  if (diffFrame == 0) { // need dummy pixel (frame is identical with one before)
+    // TBD we might make it possible to merge identical frames in the future
+    pResult->width  = 1;
+    pResult->height = 1;
+    pResult->left   = 0;
+    pResult->top    = 0;
+  }
+}
+
+/* count the color indices of the pixels in the area pDim that differ from the frame before (the pixels that stay opaque with transparency optimization) */
+static void countOpaqueIndices(CGIF* pGIF, CGIF_FrameConfig* pCur, CGIF_FrameConfig* pBef, const PixelEqTable* pEq, const DimResult* pDim, uint32_t* aCount) {
+  const uint16_t imageWidth = pGIF->config.width;
+
+  memset(aCount, 0, 256 * sizeof(uint32_t));
+  for(uint16_t i = 0; i < pDim->height; ++i) {
+    const uint8_t* pCurRow = pCur->pImageData + MULU16(pDim->top + i, imageWidth) + pDim->left;
+    const uint8_t* pBefRow = pBef->pImageData + MULU16(pDim->top + i, imageWidth) + pDim->left;
+
+    for(uint16_t x = 0; x < pDim->width; ++x) {
+      aCount[pCurRow[x]] += (cmpPixel(pEq, pCurRow[x], pBefRow[x]) != 0);
+    }
+  }
+}
+
+/* find a transparent index inside of the color table (keeps the LZW code size): an index that no opaque pixel uses.
+   otherwise, free an index by merging its color into the nearest color of the table (aMap: mapping of the opaque pixels).
+   merging is lossless for duplicate colors; merging different colors (least-used color first) requires allowLossy.
+   returns the transparent index or -1 if there is none. */
+static int findTransIndex(const uint8_t* pCT, uint16_t numEntries, const uint32_t* aCount, int allowLossy, uint8_t* aMap, int* pIsMapped) {
+  uint32_t bestCount = 0, bestDist = 0;
+  int      iBest = -1, iBestNearest = 0;
+
+  *pIsMapped = 0;
+  for(int i = 0; i < numEntries; ++i) {
+    if(aCount[i] == 0) {
+      return i; // unused index
+    }
+  }
+  for(int i = 0; i < numEntries; ++i) {
+    // nearest other color of the table (squared RGB distance)
+    uint32_t dist = UINT32_MAX;
+    int      iNearest = 0;
+    for(int j = 0; j < numEntries && dist; ++j) {
+      const int dR = (int)pCT[i * 3] - pCT[j * 3], dG = (int)pCT[i * 3 + 1] - pCT[j * 3 + 1], dB = (int)pCT[i * 3 + 2] - pCT[j * 3 + 2];
+      const uint32_t d = (uint32_t)(dR * dR + dG * dG + dB * dB);
+      if(j != i && d < dist) {
+        dist     = d;
+        iNearest = j;
+      }
+    }
+    if(dist && !allowLossy) {
+      continue;
+    }
+    // prefer lossless merges, then the least-used color, then the nearest color
+    if(iBest < 0 || (dist == 0) > (bestDist == 0) || ((dist == 0) == (bestDist == 0) && (aCount[i] < bestCount || (aCount[i] == bestCount && dist < bestDist)))) {
+      iBest        = i;
+      iBestNearest = iNearest;
+      bestCount    = aCount[i];
+      bestDist     = dist;
+    }
+  }
+  if(iBest >= 0) {
+    for(int i = 0; i < 256; ++i) {
+      aMap[i] = i;
+    }
+    aMap[iBest] = iBestNearest;
+    *pIsMapped  = 1;
+  }
+  return iBest;
+}
+
+/* find the rows and columns of pArea that differ and shrink pArea to their bounding box; returns 0 if pArea has no differences */
+static int scanDiffArea(const CGIF* pGIF, const CGIF_FrameConfig* pCur, const CGIF_FrameConfig* pBef, const PixelEqTable* pEq, DimResult* pArea, uint8_t* aRowDiff, uint8_t* aColDiff) {
+  const uint16_t imageWidth = pGIF->config.width;
+  const uint32_t top        = pArea->top;
+  const uint32_t left       = pArea->left;
+  const uint32_t bottom     = top + pArea->height;
+  const uint32_t right      = left + pArea->width;
+  uint32_t       y, x;
+
+  memset(aColDiff + left, 0, pArea->width);
+  for(y = top; y < bottom; ++y) {
+    const uint8_t* pCurRow = pCur->pImageData + MULU16(y, imageWidth);
+    const uint8_t* pBefRow = pBef->pImageData + MULU16(y, imageWidth);
+    uint8_t        rowDiff = 0;
+    if(pEq) {
+      for(x = left; x < right; ++x) {
+        const uint8_t d = (uint8_t)cmpPixel(pEq, pCurRow[x], pBefRow[x]);
+        aColDiff[x] |= d;
+        rowDiff     |= d;
+      }
+    } else {
+      for(x = left; x < right; ++x) {
+        const uint8_t d = (pCurRow[x] != pBefRow[x]);
+        aColDiff[x] |= d;
+        rowDiff     |= d;
+      }
+    }
+    aRowDiff[y] = rowDiff;
+  }
+  // shrink to bounding box
+  for(y = top; y < bottom && !aRowDiff[y]; ++y);
+  if(y == bottom) {
+    return 0;
+  }
+  pArea->top = y;
+  for(y = bottom; !aRowDiff[y - 1]; --y);
+  pArea->height = y - pArea->top;
+  for(x = left; !aColDiff[x]; ++x);
+  pArea->left = x;
+  for(x = right; !aColDiff[x - 1]; --x);
+  pArea->width = x - pArea->left;
+  return 1;
+}
+
+/* find the longest run of unchanged rows/columns in aDiff[start, start + n); returns its length (*pGapStart: its first index) */
+static uint16_t findLongestGap(const uint8_t* aDiff, uint16_t start, uint16_t n, uint16_t* pGapStart) {
+  uint32_t i, runStart;
+  uint16_t maxLen = 0;
+
+  runStart = start;
+  for(i = start; i <= (uint32_t)start + n; ++i) {
+    if(i == (uint32_t)start + n || aDiff[i]) {
+      if(i - runStart > maxLen) {
+        maxLen     = i - runStart;
+        *pGapStart = runStart;
+      }
+      runStart = i + 1;
+    }
+  }
+  return maxLen;
+}
+
+/* split the diff area into disjoint rectangles by cutting along the largest unchanged band of rows or columns (recursive XY-cut).
+   returns the number of rectangles in aRects (at most MAX_NUM_RECTS) or -1 if an allocation failed */
+static int splitDiffArea(const CGIF* pGIF, const CGIF_FrameConfig* pCur, const CGIF_FrameConfig* pBef, const PixelEqTable* pEq, const DimResult* pArea, DimResult* aRects) {
+  uint8_t* pBuf;
+  uint8_t* aRowDiff;
+  uint8_t* aColDiff;
+  int      i, numRects;
+
+  pBuf = malloc((uint32_t)pGIF->config.width + pGIF->config.height);
+  if(pBuf == NULL) {
+    return -1;
+  }
+  aRowDiff    = pBuf;
+  aColDiff    = pBuf + pGIF->config.height;
+  aRects[0]   = *pArea;
+  numRects    = 1;
+  for(i = 0; i < numRects;) {
+    DimResult* pRect = &aRects[i];
+    uint16_t   gapRows, gapCols, startRows = 0, startCols = 0;
+    uint32_t   gainRows, gainCols;
+
+    // the rectangle contains differences by construction: shrink it to its bounding box
+    scanDiffArea(pGIF, pCur, pBef, pEq, pRect, aRowDiff, aColDiff);
+    gapRows  = findLongestGap(aRowDiff, pRect->top, pRect->height, &startRows);
+    gapCols  = findLongestGap(aColDiff, pRect->left, pRect->width, &startCols);
+    gainRows = MULU16(gapRows, pRect->width);
+    gainCols = MULU16(gapCols, pRect->height);
+    // split only if a considerable part of the rectangle is dropped
+    const uint32_t gain = (gainRows >= gainCols) ? gainRows : gainCols;
+    if(numRects == MAX_NUM_RECTS || gain < MIN_RECT_SPLIT_GAIN || gain * 4 < MULU16(pRect->width, pRect->height)) {
+      ++i; // done with this rectangle
+      continue;
+    }
+    aRects[numRects] = *pRect;
+    if(gainRows >= gainCols) {
+      aRects[numRects].top    = startRows + gapRows;
+      aRects[numRects].height = (pRect->top + pRect->height) - aRects[numRects].top;
+      pRect->height           = startRows - pRect->top;
+    } else {
+      aRects[numRects].left   = startCols + gapCols;
+      aRects[numRects].width  = (pRect->left + pRect->width) - aRects[numRects].left;
+      pRect->width            = startCols - pRect->left;
+    }
+    ++numRects;
+  }
+  free(pBuf);
+  return numRects;
+}
+
+/* prepare the raw frame config of pCur using the size optimizations given by genFlags
+   pArea: area of the frame to encode with CGIF_FRAME_GEN_USE_DIFF_WINDOW (NULL: determine the diff window) */
+static cgif_result prepareFrame(CGIF* pGIF, CGIF_Frame* pCur, CGIF_Frame* pBef, uint32_t genFlags, const DimResult* pArea, EncCandidate* pCand) {
+  CGIFRaw_FrameConfig* pRawConfig;
+  DimResult            dimResult;
+  PixelEqTable*        pEq;
+  uint32_t             aCount[256];
+  int                  useLCT, hasAlpha, hasSetTransp, isMapped;
+  uint16_t             numPaletteEntries;
+  uint8_t              transIndex;
+
+  pRawConfig   = &pCand->rawConfig;
+  pEq          = &pCand->eqTable;
+  useLCT       = (pCur->config.attrFlags & CGIF_FRAME_ATTR_USE_LOCAL_TABLE) ? 1 : 0; // LCT stands for "local color table"
+  hasAlpha     = ((pGIF->config.attrFlags & CGIF_ATTR_HAS_TRANSPARENCY) || (pCur->config.attrFlags & CGIF_FRAME_ATTR_HAS_ALPHA)) ? 1 : 0;
+  hasSetTransp = (pCur->config.attrFlags & CGIF_FRAME_ATTR_HAS_SET_TRANS) ? 1 : 0;
+  transIndex   = pCur->transIndex;
+  numPaletteEntries = (useLCT) ? pCur->config.numLocalPaletteEntries : pGIF->config.numGlobalPaletteEntries;
+
+  if(genFlags & (CGIF_FRAME_GEN_USE_DIFF_WINDOW | CGIF_FRAME_GEN_USE_TRANSPARENCY)) {
+    initPixelEqTable(pGIF, &pCur->config, &pBef->config, pEq);
+    markMergedPixels(pBef, pEq);
+  }
+  // purge overlap of current frame and frame before (width - height optim), if required (CGIF_FRAME_GEN_USE_DIFF_WINDOW set)
+  if((genFlags & CGIF_FRAME_GEN_USE_DIFF_WINDOW) && pArea) {
+    dimResult = *pArea;
+  } else if(genFlags & CGIF_FRAME_GEN_USE_DIFF_WINDOW) {
+    doWidthHeightOptim(pGIF, pCur, pBef, pEq, &dimResult);
+  } else {
+    dimResult.width  = pGIF->config.width;
+    dimResult.height = pGIF->config.height;
+    dimResult.top    = 0;
+    dimResult.left   = 0;
+  }
+
+  // mark matching areas of the previous frame as transparent, if required (CGIF_FRAME_GEN_USE_TRANSPARENCY set)
+  isMapped = 0;
+  if(genFlags & CGIF_FRAME_GEN_USE_TRANSPARENCY) {
+    // set transIndex to next free index
+    int pow2 = calcNextPower2Ex(numPaletteEntries);
+    pow2 = (pow2 < 2) ? 2 : pow2; // TBD keep transparency index behavior as in V0.1.0 (for now)
+    transIndex = (1 << pow2) - 1;
+    if(transIndex < numPaletteEntries) {
+      // color table fills the LZW code size: use an index of the table that the opaque pixels do not need (instead of growing the code size).
+      // not on a canvas with transparent pixels (alpha channel): the index after the table keeps the frame as in V0.1.0 there
+      int iTrans = -1;
+      if(!pBef->isAlphaCanvas) {
+        const uint8_t* pCT = (useLCT) ? pCur->config.pLocalPalette : pGIF->config.pGlobalPalette;
+        countOpaqueIndices(pGIF, &pCur->config, &pBef->config, pEq, &dimResult, aCount);
+        iTrans = findTransIndex(pCT, numPaletteEntries, aCount, (pCur->config.genFlags & CGIF_FRAME_GEN_USE_LOSSY_TRANSPARENCY) ? 1 : 0, pCand->aMap, &isMapped);
+      }
+      if(iTrans >= 0) {
+        transIndex = iTrans;
+      } else if(numPaletteEntries < 256) {
+        transIndex = (1 << (pow2 + 1)) - 1;
+      } else {
+        genFlags &= ~CGIF_FRAME_GEN_USE_TRANSPARENCY; // full color table: no free spot for the transparent index
+      }
+    }
+  }
+
+  // crop + transparency: done by the LZW encoder while reading the (differing) area, row by row (no copy of the frame)
+  pRawConfig->pSrc = NULL;
+  if(genFlags & (CGIF_FRAME_GEN_USE_DIFF_WINDOW | CGIF_FRAME_GEN_USE_TRANSPARENCY)) {
+    const int useTrans = (genFlags & CGIF_FRAME_GEN_USE_TRANSPARENCY) ? 1 : 0;
+    pCand->src.pImageData    = pCur->config.pImageData;
+    pCand->src.pBefImageData = (useTrans) ? pBef->config.pImageData : NULL;
+    pCand->src.pIDCur        = pEq->aCur;
+    pCand->src.pIDBef        = pEq->aBef;
+    pCand->src.pMap          = (useTrans && isMapped) ? pCand->aMap : NULL;
+    pCand->src.stride        = pGIF->config.width;
+    // flexible transparency: not with an alpha channel or user-set transparency (transIndex is a color of the frame itself then)
+    pCand->src.isFlexTrans   = (useTrans && (pCur->config.genFlags & CGIF_FRAME_GEN_USE_FLEX_TRANSPARENCY) && !hasAlpha && !hasSetTransp) ? 1 : 0;
+    pRawConfig->pSrc         = &pCand->src;
+  }
+
+  // move frame down to GIF raw API
+  pCand->genFlags            = genFlags;
+  pRawConfig->pLCT           = pCur->config.pLocalPalette;
+  pRawConfig->pImageData     = pCur->config.pImageData;
+  pRawConfig->attrFlags      = 0;
+  if(hasAlpha || (genFlags & CGIF_FRAME_GEN_USE_TRANSPARENCY) || hasSetTransp) {
+    pRawConfig->attrFlags |= CGIF_RAW_FRAME_ATTR_HAS_TRANS;
+  }
+  pRawConfig->attrFlags |= (pCur->config.attrFlags & CGIF_FRAME_ATTR_INTERLACED) ? CGIF_RAW_FRAME_ATTR_INTERLACED : 0;
+  pRawConfig->width          = dimResult.width;
+  pRawConfig->height         = dimResult.height;
+  pRawConfig->top            = dimResult.top;
+  pRawConfig->left           = dimResult.left;
+  pRawConfig->delay          = pCur->config.delay;
+  pRawConfig->sizeLCT        = (useLCT) ? pCur->config.numLocalPaletteEntries : 0;
+  pRawConfig->disposalMethod = pCur->disposalMethod;
+  pRawConfig->transIndex     = transIndex;
+  return CGIF_OK;
+}
+
+/* LZW-encode a prepared candidate (might be run on a separate thread) */
+static void* encodeCandidate(void* pArg) {
+  EncCandidate* pCand = (EncCandidate*)pArg;
+
+  pCand->r = cgif_raw_encodeframe(pCand->pGIFRaw, &pCand->rawConfig, &pCand->encFrame);
+  return NULL;
+}
+
+/* encode all candidates (at most MAX_NUM_RECTS), in parallel if possible */
+static void encodeCandidates(EncCandidate* aCand, int numCand) {
+#ifdef CGIF_HAVE_PTHREAD
+  pthread_t aThreads[MAX_NUM_RECTS];
+  int       aStarted[MAX_NUM_RECTS] = {0};
+
+  // the first candidate is encoded by the calling thread
+  for(int i = 1; i < numCand; ++i) {
+    aStarted[i] = (pthread_create(&aThreads[i], NULL, encodeCandidate, &aCand[i]) == 0) ? 1 : 0;
+  }
+  for(int i = 0; i < numCand; ++i) {
+    if(aStarted[i]) {
+      pthread_join(aThreads[i], NULL);
+    } else {
+      encodeCandidate(&aCand[i]); // thread creation failed (or first candidate): encode on calling thread
+    }
+  }
+#else
+  for(int i = 0; i < numCand; ++i) {
+    encodeCandidate(&aCand[i]);
+  }
+#endif
+}
+
+/* free the encoded variants */
+static void freeCandidates(EncCandidate* aCand, int numCand) {
+  for(int i = 0; i < numCand; ++i) {
+    cgif_raw_freeframe(&aCand[i].encFrame);
+  }
+}
+
+/* split the diff window of the encoded variant pBox into several rectangles (written as consecutive GIF frames), if this is estimated to be smaller.
+   *pNumRects is the number of encoded rectangles in aRect (0: keep pBox) */
+static cgif_result splitFrame(CGIF* pGIF, CGIF_Frame* pCur, CGIF_Frame* pBef, const EncCandidate* pBox, EncCandidate* aRect, int* pNumRects) {
+  DimResult    area, aRects[MAX_NUM_RECTS];
+  PixelEqTable eqTable;
+  uint32_t     sizeBox, sizeRects, sizeRect, sizeOverhead;
+  int          numRects;
+  cgif_result  r;
+
+  *pNumRects = 0;
+  area.width  = pBox->rawConfig.width;
+  area.height = pBox->rawConfig.height;
+  area.top    = pBox->rawConfig.top;
+  area.left   = pBox->rawConfig.left;
+  initPixelEqTable(pGIF, &pCur->config, &pBef->config, &eqTable);
+  markMergedPixels(pBef, &eqTable);
+  numRects = splitDiffArea(pGIF, &pCur->config, &pBef->config, (canCmpIndices(&pCur->config, &pBef->config) && !pBef->hasMerged) ? NULL : &eqTable, &area, aRects);
+  if(numRects < 0) {
+    return CGIF_EALLOC;
+  }
+  if(numRects < 2) {
+    return CGIF_OK; // nothing to split
+  }
+  // estimate the size of both options: each additional GIF frame comes with a frame header (and the LCT)
+  r = cgif_raw_estimateframe(pGIF->pGIFRaw, &pBox->rawConfig, &sizeBox);
+  if(r != CGIF_OK) {
+    return r;
+  }
+  sizeOverhead = SIZE_FRAME_OVERHEAD;
+  if(pBox->rawConfig.sizeLCT) {
+    const uint8_t pow2LCT = calcNextPower2Ex(pBox->rawConfig.sizeLCT);
+    sizeOverhead += 3 * (1uL << ((pow2LCT < 1) ? 1 : pow2LCT));
+  }
+  sizeRects = (numRects - 1) * sizeOverhead;
+  for(int i = 0; i < numRects; ++i) {
+    aRect[i].pGIFRaw = pGIF->pGIFRaw;
+    r = prepareFrame(pGIF, pCur, pBef, pBox->genFlags, &aRects[i], &aRect[i]);
+    if(r == CGIF_OK) {
+      r = cgif_raw_estimateframe(pGIF->pGIFRaw, &aRect[i].rawConfig, &sizeRect);
+    }
+    if(r != CGIF_OK) {
+      freeCandidates(aRect, i + 1);
+      return r;
+    }
+    sizeRects += sizeRect;
+  }
+  if(sizeRects >= sizeBox) {
+    freeCandidates(aRect, numRects);
+    return CGIF_OK; // splitting does not pay off: keep pBox
+  }
+  // the frame delay is applied once all rectangles are drawn
+  for(int i = 0; i < numRects - 1; ++i) {
+    aRect[i].rawConfig.delay = 0;
+  }
+  encodeCandidates(aRect, numRects);
+  for(int i = 0; i < numRects; ++i) {
+    if(aRect[i].r != CGIF_OK) {
+      freeCandidates(aRect, numRects);
+      return aRect[i].r;
+    }
+  }
+  *pNumRects = numRects;
+  return CGIF_OK;
+}
+
+/* write an encoded variant to the raw GIF stream (and report its statistics) */
+static cgif_result writeCandidate(CGIF* pGIF, EncCandidate* pCand, int numVariants) {
+  CGIF_FrameStats stats;
+  cgif_result     r;
+
+  stats.frameIndex     = pGIF->cntFrames;
+  stats.sizeRasterData = pCand->encFrame.sizeRasterData;
+  stats.genFlags       = pCand->genFlags;
+  stats.width          = pCand->rawConfig.width;
+  stats.height         = pCand->rawConfig.height;
+  stats.top            = pCand->rawConfig.top;
+  stats.left           = pCand->rawConfig.left;
+  stats.delay          = pCand->rawConfig.delay;
+  stats.numVariants    = numVariants;
+  r = cgif_raw_writeframe(pGIF->pGIFRaw, &pCand->rawConfig, &pCand->encFrame);
+  if(r == CGIF_OK) {
+    ++(pGIF->cntFrames);
+    if(pGIF->config.pFrameStatsFn) {
+      pGIF->config.pFrameStatsFn(pGIF->config.pContext, &stats);
+    }
+  }
+  return r;
+}
+
+/* check whether a frame looks the same as a copy kept by the frame cache (the hash alone could collide) */
+static int isCachedImage(const CGIF* pGIF, const CachedImage* pImg, const CGIF_Frame* pFrame) {
+  uint32_t       aID[256];
+  const uint8_t* pImageData = pFrame->config.pImageData;
+  const uint32_t numPixel   = MULU16(pGIF->config.width, pGIF->config.height);
+
+  if(pImg->hash != pFrame->hash) {
+    return 0;
+  }
+  initHashIDs(pGIF, &pFrame->config, aID);
+  if(!memcmp(aID, pImg->aID, sizeof(aID))) {
+    return !memcmp(pImageData, pImg->pImageData, numPixel); // same color table: compare the indices
+  }
+  for(uint32_t i = 0; i < numPixel; ++i) {
+    if(aID[pImageData[i]] != pImg->aID[pImg->pImageData[i]]) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+/* look up the encoding of the frame pair pBef -> pCur in the cache of recently encoded frames (NULL: not found) */
+static FrameCacheEntry* findCachedFrame(CGIF* pGIF, const CGIF_Frame* pCur, const CGIF_Frame* pBef) {
+  for(int i = 0; i < SIZE_FRAME_CACHE; ++i) {
+    FrameCacheEntry* pEntry = &pGIF->aFrameCache[i];
+    if(pEntry->encFrame.pRasterData && pEntry->pImgCur->hash == pCur->hash && pEntry->pImgBef->hash == pBef->hash
+       && pEntry->frameGenFlags == pCur->config.genFlags && pEntry->attrFlags == pCur->config.attrFlags && pEntry->disposalMethod == pCur->disposalMethod
+       && isCachedImage(pGIF, pEntry->pImgCur, pCur) && isCachedImage(pGIF, pEntry->pImgBef, pBef)) {
+      return pEntry;
+    }
+  }
+  return NULL;
+}
+
+/* get a copy of the frame for the frame cache: shared with the cache entries if they already keep one (NULL: out of memory) */
+static CachedImage* getCachedImage(CGIF* pGIF, const CGIF_Frame* pFrame) {
+  const uint32_t numPixel = MULU16(pGIF->config.width, pGIF->config.height);
+  CachedImage*   pImg;
+
+  for(int i = 0; i < SIZE_FRAME_CACHE; ++i) {
+    const FrameCacheEntry* pEntry = &pGIF->aFrameCache[i];
+    if(pEntry->encFrame.pRasterData) {
+      if(isCachedImage(pGIF, pEntry->pImgCur, pFrame)) {
+        pImg = pEntry->pImgCur;
+        ++(pImg->numRefs);
+        return pImg;
+      }
+      if(isCachedImage(pGIF, pEntry->pImgBef, pFrame)) {
+        pImg = pEntry->pImgBef;
+        ++(pImg->numRefs);
+        return pImg;
+      }
+    }
+  }
+  pImg = malloc(sizeof(CachedImage));
+  if(pImg == NULL) {
+    return NULL;
+  }
+  pImg->pImageData = malloc(numPixel);
+  if(pImg->pImageData == NULL) {
+    free(pImg);
+    return NULL;
+  }
+  memcpy(pImg->pImageData, pFrame->config.pImageData, numPixel);
+  initHashIDs(pGIF, &pFrame->config, pImg->aID);
+  pImg->hash    = pFrame->hash;
+  pImg->numRefs = 1;
+  return pImg;
+}
+
+/* keep a copy of the encoded variant pCand of the frame pair pBef -> pCur for reuse (replaces the oldest entry) */
+static void cacheFrame(CGIF* pGIF, const CGIF_Frame* pCur, const CGIF_Frame* pBef, const EncCandidate* pCand) {
+  FrameCacheEntry* pEntry = &pGIF->aFrameCache[pGIF->iFrameCache];
+  uint8_t*         pRasterData;
+  uint8_t*         pLCT = NULL;
+  CachedImage*     pImgCur;
+  CachedImage*     pImgBef;
+
+  // the cache is an optimization only: skip the frame if memory is short
+  pRasterData = malloc(pCand->encFrame.sizeRasterData);
+  if(pRasterData == NULL) {
+    return;
+  }
+  if(pCand->rawConfig.sizeLCT) {
+    pLCT = malloc(pCand->rawConfig.sizeLCT * 3);
+    if(pLCT == NULL) {
+      free(pRasterData);
+      return;
+    }
+    memcpy(pLCT, pCand->rawConfig.pLCT, pCand->rawConfig.sizeLCT * 3);
+  }
+  // copies of both frames to confirm a hash hit later on
+  pImgCur = getCachedImage(pGIF, pCur);
+  pImgBef = (pImgCur) ? getCachedImage(pGIF, pBef) : NULL;
+  if(pImgBef == NULL) {
+    releaseCachedImage(pImgCur);
+    free(pLCT);
+    free(pRasterData);
+    return;
+  }
+  memcpy(pRasterData, pCand->encFrame.pRasterData, pCand->encFrame.sizeRasterData);
+  freeCachedFrame(pEntry);
+  pEntry->rawConfig            = pCand->rawConfig;
+  pEntry->rawConfig.pImageData = NULL; // only the encoded raster data is kept
+  pEntry->rawConfig.pSrc       = NULL;
+  pEntry->rawConfig.pLCT       = pLCT;
+  pEntry->encFrame             = pCand->encFrame;
+  pEntry->encFrame.pRasterData = pRasterData;
+  pEntry->pLCT                 = pLCT;
+  pEntry->pImgCur              = pImgCur;
+  pEntry->pImgBef              = pImgBef;
+  pEntry->attrFlags            = pCur->config.attrFlags;
+  pEntry->frameGenFlags        = pCur->config.genFlags;
+  pEntry->genFlags             = pCand->genFlags;
+  pEntry->disposalMethod       = pCur->disposalMethod;
+  pGIF->iFrameCache            = (pGIF->iFrameCache + 1) % SIZE_FRAME_CACHE;
+}
+
+/* write a copy of a cached frame with the delay of pCur */
+static cgif_result writeCachedFrame(CGIF* pGIF, const CGIF_Frame* pCur, const FrameCacheEntry* pEntry) {
+  EncCandidate cand;
+
+  memset(&cand, 0, sizeof(cand));
+  cand.rawConfig            = pEntry->rawConfig;
+  cand.rawConfig.delay      = pCur->config.delay;
+  cand.encFrame             = pEntry->encFrame;
+  cand.encFrame.pRasterData = malloc(pEntry->encFrame.sizeRasterData);
+  cand.genFlags             = pEntry->genFlags;
+  if(cand.encFrame.pRasterData == NULL) {
+    pGIF->pGIFRaw->curResult = CGIF_EALLOC; // keep raw GIF stream in sync (as with cgif_raw_addframe)
+    return CGIF_EALLOC;
+  }
+  memcpy(cand.encFrame.pRasterData, pEntry->encFrame.pRasterData, pEntry->encFrame.sizeRasterData);
+  return writeCandidate(pGIF, &cand, 0);
+}
+
+/* remember the colors of the written variant that were merged into other colors by lossy transparency (see findTransIndex) */
+static void setMergedColors(CGIF_Frame* pCur, const EncCandidate* pCand) {
+  const uint32_t* aID = pCand->eqTable.aCur;
+
+  if(pCand->rawConfig.pSrc == NULL || pCand->src.pMap == NULL) {
+    return;
+  }
+  for(int c = 0; c < 256; ++c) {
+    if(aID[pCand->src.pMap[c]] != aID[c]) { // not a duplicate color
+      pCur->aIsMerged[c] = 1;
+      pCur->hasMerged    = 1;
+    }
+  }
+}
+
+/* move frame down to the raw GIF API */
+static cgif_result flushFrame(CGIF* pGIF, CGIF_Frame* pCur, CGIF_Frame* pBef) {
+  EncCandidate        aCand[MAX_NUM_CANDIDATES];
+  EncCandidate        aRect[MAX_NUM_RECTS];
+  DimResult           area;
+  const DimResult*    pArea;
+  int                 isFirstFrame, hasAlpha, hasSetTransp;
+  int                 numCand, iBest, numRects;
+  uint32_t            genFlags;
+  cgif_result         r;
+
+  isFirstFrame   = (pBef == NULL) ? 1 : 0;
+  hasAlpha       = ((pGIF->config.attrFlags & CGIF_ATTR_HAS_TRANSPARENCY) || (pCur->config.attrFlags & CGIF_FRAME_ATTR_HAS_ALPHA)) ? 1 : 0;
+  hasSetTransp   = (pCur->config.attrFlags & CGIF_FRAME_ATTR_HAS_SET_TRANS) ? 1 : 0;
+  // deactivate impossible size optimizations
+  //  => in case alpha channel is used
+  // CGIF_FRAME_GEN_USE_TRANSPARENCY and CGIF_FRAME_GEN_USE_DIFF_WINDOW are not possible
+  if(isFirstFrame || hasAlpha) {
+    pCur->config.genFlags &= ~(CGIF_FRAME_GEN_USE_TRANSPARENCY | CGIF_FRAME_GEN_USE_DIFF_WINDOW);
+  }
+  // transparency setting (which areas are identical to the frame before) provided by user:
+  // CGIF_FRAME_GEN_USE_TRANSPARENCY not possible
+  if(hasSetTransp) {
+    pCur->config.genFlags &= ~(CGIF_FRAME_GEN_USE_TRANSPARENCY);
+  }
+  // transparent pixels of the canvas (alpha channel) stay if the frame does not cover the whole canvas with opaque pixels
+  pCur->isAlphaCanvas = (hasAlpha || pCur->disposalMethod == DISPOSAL_METHOD_BACKGROUND
+                         || (!isFirstFrame && pBef->isAlphaCanvas && ((pCur->config.genFlags & (CGIF_FRAME_GEN_USE_TRANSPARENCY | CGIF_FRAME_GEN_USE_DIFF_WINDOW)) || hasSetTransp))) ? 1 : 0;
+  // colors merged by lossy transparency: set once the variant to be written is chosen (see setMergedColors)
+  pCur->hasMerged = 0;
+  memset(pCur->aIsMerged, 0, sizeof(pCur->aIsMerged));
+  // the same frame pair was encoded recently: reuse its encoding (CGIF_GEN_REUSE_FRAMES set).
+  // not on a canvas with transparent pixels or colors merged by lossy transparency: the encoding depends on the canvas then (see prepareFrame)
+  if(!isFirstFrame && pCur->hasHash && pBef->hasHash && !pBef->isAlphaCanvas && !pBef->hasMerged) {
+    const FrameCacheEntry* pEntry = findCachedFrame(pGIF, pCur, pBef);
+    if(pEntry) {
+      return writeCachedFrame(pGIF, pCur, pEntry);
+    }
+  }
+  // patch of cgif_addframe_rect applied to pBef: the frames can only differ within the patch
+  // (not if colors of pBef were merged by lossy transparency: their pixels are repainted)
+  pArea = NULL;
+  if(pCur->rect.width && pCur->pRectBase == pBef && !pBef->hasMerged) {
+    if(pCur->config.attrFlags & CGIF_FRAME_ATTR_EXACT_RECT) {
+      area = pCur->rect; // declared exact by the user: no search
+    } else if(getDiffAreaWindow(pGIF, &pCur->config, &pBef->config, &pCur->rect, &area, NULL) == 0) {
+      area.width  = 1; // need dummy pixel (as with doWidthHeightOptim)
+      area.height = 1;
+      area.left   = 0;
+      area.top    = 0;
+    }
+    pArea = &area;
+  }
+
+  // collect the variants to be encoded:
+  // by default, just the one with all enabled size optimizations.
+  // with CGIF_GEN_SPECULATIVE_ENCODING: additionally the full frame and the diff window without transparency.
+  genFlags = pCur->config.genFlags & (CGIF_FRAME_GEN_USE_TRANSPARENCY | CGIF_FRAME_GEN_USE_DIFF_WINDOW);
+  memset(aCand, 0, sizeof(aCand));
+  memset(aRect, 0, sizeof(aRect));
+  numCand  = 0;
+  numRects = 0;
+  if((pGIF->config.genFlags & CGIF_GEN_SPECULATIVE_ENCODING) && genFlags) {
+    aCand[numCand++].genFlags = 0;
+    if((genFlags & CGIF_FRAME_GEN_USE_DIFF_WINDOW) && (genFlags & CGIF_FRAME_GEN_USE_TRANSPARENCY)) {
+      aCand[numCand++].genFlags = CGIF_FRAME_GEN_USE_DIFF_WINDOW;
+    }
+  }
+  aCand[numCand++].genFlags = genFlags;
+  for(int i = 0; i < numCand; ++i) {
+    aCand[i].pGIFRaw = pGIF->pGIFRaw;
+    r = prepareFrame(pGIF, pCur, pBef, aCand[i].genFlags, pArea, &aCand[i]);
+    if(r != CGIF_OK) {
+      goto FLUSHFRAME_Cleanup;
+    }
+  }
+  encodeCandidates(aCand, numCand);
+  // keep the smallest variant (on equal size: the one with more optimizations)
+  iBest = -1;
+  for(int i = 0; i < numCand; ++i) {
+    if(aCand[i].r != CGIF_OK) {
+      r = aCand[i].r;
+      pGIF->pGIFRaw->curResult = r; // keep raw GIF stream in sync (as with cgif_raw_addframe)
+      goto FLUSHFRAME_Cleanup;
+    }
+    if(iBest < 0 || aCand[i].encFrame.sizeRasterData <= aCand[iBest].encFrame.sizeRasterData) {
+      iBest = i;
+    }
+  }
+
+  // split the diff window into several rectangles, if required (CGIF_FRAME_GEN_USE_DIFF_RECTS set)
+  // not possible if the area of the frame is restored after displaying it (disposal method)
+  if((pCur->config.genFlags & CGIF_FRAME_GEN_USE_DIFF_RECTS) && (aCand[iBest].genFlags & CGIF_FRAME_GEN_USE_DIFF_WINDOW) && pCur->disposalMethod == DISPOSAL_METHOD_LEAVE) {
+    r = splitFrame(pGIF, pCur, pBef, &aCand[iBest], aRect, &numRects);
+    if(r != CGIF_OK) {
+      pGIF->pGIFRaw->curResult = r; // keep raw GIF stream in sync (as with cgif_raw_addframe)
+      goto FLUSHFRAME_Cleanup;
+    }
+  }
+  if(numRects) {
+    for(int i = 0; i < numRects && r == CGIF_OK; ++i) {
+      aRect[i].genFlags |= CGIF_FRAME_GEN_USE_DIFF_RECTS;
+      setMergedColors(pCur, &aRect[i]);
+      r = writeCandidate(pGIF, &aRect[i], numCand);
+    }
+  } else {
+    setMergedColors(pCur, &aCand[iBest]);
+    if(!isFirstFrame && pCur->hasHash && pBef->hasHash && !pBef->isAlphaCanvas && !pBef->hasMerged && !pCur->hasMerged) {
+      cacheFrame(pGIF, pCur, pBef, &aCand[iBest]);
+    }
+    r = writeCandidate(pGIF, &aCand[iBest], numCand);
+  }
+
+FLUSHFRAME_Cleanup:
+  freeCandidates(aCand, numCand);
+  freeCandidates(aRect, numRects);
+  return r;
+}
+
+/* choose the disposal method of pCur by looking ahead at the next frame (CGIF_GEN_OPTIM_DISPOSAL set):
+   restore the canvas of the frame before after displaying pCur (DISPOSAL_METHOD_PREVIOUS), if the next frame differs from it in a smaller area (transient overlays) */
+static void chooseDisposal(CGIF* pGIF, CGIF_Frame* pCur, CGIF_Frame* pBef, CGIF_Frame* pNext) {
+  PixelEqTable eqTable;
+  DimResult    dimResult;
+  uint32_t     areaLeave, areaPrevious;
+
+  if(!(pGIF->config.genFlags & CGIF_GEN_OPTIM_DISPOSAL) || pBef == NULL || pNext == NULL) {
+    return;
+  }
+  // the canvas before pCur must be the frame before as is (no alpha channel, no disposal to background).
+  // the next frame must be encoded relative to the canvas (diff window) without user-provided transparency (marked relative to pCur).
+  if(pCur->disposalMethod != DISPOSAL_METHOD_LEAVE || pBef->disposalMethod != DISPOSAL_METHOD_LEAVE || (pBef->config.attrFlags & CGIF_FRAME_ATTR_HAS_ALPHA)
+     || !(pNext->config.genFlags & CGIF_FRAME_GEN_USE_DIFF_WINDOW) || (pNext->config.attrFlags & (CGIF_FRAME_ATTR_HAS_ALPHA | CGIF_FRAME_ATTR_HAS_SET_TRANS))) {
+    return;
+  }
+  // area the next frame has to encode on top of pCur ...
+  initPixelEqTable(pGIF, &pNext->config, &pCur->config, &eqTable);
+  areaLeave = getFrameDiffArea(pGIF, pNext, pCur, &eqTable, &dimResult) ? MULU16(dimResult.width, dimResult.height) : 0;
+  // ... and on top of the frame before
+  initPixelEqTable(pGIF, &pNext->config, &pBef->config, &eqTable);
+  areaPrevious = getFrameDiffArea(pGIF, pNext, pBef, &eqTable, &dimResult) ? MULU16(dimResult.width, dimResult.height) : 0;
+  if(areaPrevious < areaLeave) {
+    pCur->disposalMethod = DISPOSAL_METHOD_PREVIOUS;
+  }
+}
+
+/* get an unused frame slot: recycle one from the pool (steady state) or allocate a new one */
+static CGIF_Frame* getFrameSlot(CGIF* pGIF) {
+  CGIF_Frame* pFrame;
+
+  if(pGIF->numPoolFrames) {
+    return pGIF->aFramePool[--(pGIF->numPoolFrames)];
+  }
+  pFrame = malloc(sizeof(CGIF_Frame));
+  if(pFrame) {
+    memset(pFrame, 0, sizeof(CGIF_Frame));
+  }
+  return pFrame;
+}
+
+/* give a frame back: release borrowed buffers and put the slot (with its buffers) back into the pool */
+static void freeFrame(CGIF* pGIF, CGIF_Frame* pFrame) {
   if(pFrame) {
-    free(pFrame->config.pImageData);
-    if(pFrame->config.attrFlags & CGIF_FRAME_ATTR_USE_LOCAL_TABLE) {
-      free(pFrame->config.pLocalPalette);
+    if(pFrame->isBorrowed && pFrame->pReleaseFn) {
+      // hand the buffers back to the user
+      pFrame->pReleaseFn(pFrame->pReleaseContext, pFrame->config.pImageData, pFrame->config.pLocalPalette);
+    }
+    pFrame->isBorrowed = 0;
+    if(pGIF->numPoolFrames < pGIF->sizeFrameQueue + 1) {
+      pGIF->aFramePool[(pGIF->numPoolFrames)++] = pFrame;
+    } else {
+      freeFrameSlot(pFrame);
     }
-    free(pFrame);
   }
 }
 
@@ -476,11 +1863,306 @@ static void copyFrameConfig(CGIF_FrameConfig* pDest, CGIF_FrameConfig* pSrc) {
   }
 }
 
-/* queue a new GIF frame */
-int cgif_addframe(CGIF* pGIF, CGIF_FrameConfig* pConfig) {
+/* mark the color table indices used by a frame (transparent pixels excluded); returns 0 if an index outside of the local color table is used */
+static int markUsedIndices(const CGIF* pGIF, const CGIF_FrameConfig* pConfig, uint8_t* aUsed) {
+  const uint32_t numPixel = MULU16(pGIF->config.width, pGIF->config.height);
+
+  memset(aUsed, 0, 256);
+  for(uint32_t i = 0; i < numPixel; ++i) {
+    aUsed[pConfig->pImageData[i]] = 1;
+  }
+  if(pConfig->attrFlags & (CGIF_FRAME_ATTR_HAS_ALPHA | CGIF_FRAME_ATTR_HAS_SET_TRANS)) {
+    aUsed[pConfig->transIndex] = 0;
+  }
+  for(int c = pConfig->numLocalPaletteEntries; c < 256; ++c) {
+    if(aUsed[c]) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+/* index of the given RGB color in a color table or -1 if not found */
+static int findColor(const uint8_t* pCT, uint16_t numEntries, const uint8_t* pRGB) {
+  for(int i = 0; i < numEntries; ++i) {
+    if(pCT[i * 3] == pRGB[0] && pCT[i * 3 + 1] == pRGB[1] && pCT[i * 3 + 2] == pRGB[2]) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+/* add the colors used by a frame with a local color table to the global color table being built.
+   all or none of them are added: the last entry is kept free for the transparent index of frames with alpha channel / user-provided transparency. */
+static void addToGlobalTable(const CGIF* pGIF, const CGIF_FrameConfig* pConfig, uint8_t* pGCT, uint16_t* pNumEntries) {
+  uint8_t  aUsed[256];
+  uint16_t numEntries = *pNumEntries;
+
+  if(!(pConfig->attrFlags & CGIF_FRAME_ATTR_USE_LOCAL_TABLE) || !markUsedIndices(pGIF, pConfig, aUsed)) {
+    return;
+  }
+  for(int c = 0; c < pConfig->numLocalPaletteEntries; ++c) {
+    if(aUsed[c] && findColor(pGCT, numEntries, pConfig->pLocalPalette + c * 3) < 0) {
+      if(numEntries == 255) {
+        return; // colors of the frame do not fit
+      }
+      memcpy(pGCT + numEntries * 3, pConfig->pLocalPalette + c * 3, 3);
+      ++numEntries;
+    }
+  }
+  *pNumEntries = numEntries;
+}
+
+/* hash of a color table (64-bit FNV-1a) */
+static uint64_t hashPalette(const uint8_t* pCT, uint16_t numEntries) {
+  uint64_t hash = 0xCBF29CE484222325uLL;
+
+  for(int i = 0; i < numEntries * 3; ++i) {
+    hash = (hash ^ pCT[i]) * 0x100000001B3uLL;
+  }
+  return hash;
+}
+
+/* get the mapping of a local color table to the global color table (recomputed only if the local color table changed) */
+static const LCTMap* getLCTMap(CGIF* pGIF, const CGIF_FrameConfig* pConfig) {
+  LCTMap*        pMap = &pGIF->lctMap;
+  const uint64_t hash = hashPalette(pConfig->pLocalPalette, pConfig->numLocalPaletteEntries);
+
+  if(pMap->numEntries && pMap->numEntries == pConfig->numLocalPaletteEntries && pMap->hash == hash && !memcmp(pMap->aLCT, pConfig->pLocalPalette, pMap->numEntries * 3)) {
+    return pMap; // same local color table as before
+  }
+  pMap->hash       = hash;
+  pMap->numEntries = pConfig->numLocalPaletteEntries;
+  pMap->isIdentity = 1;
+  memcpy(pMap->aLCT, pConfig->pLocalPalette, pMap->numEntries * 3);
+  for(int c = 0; c < pMap->numEntries; ++c) {
+    pMap->aMap[c]     = (int16_t)findColor(pGIF->config.pGlobalPalette, pGIF->config.numGlobalPaletteEntries, pMap->aLCT + c * 3);
+    pMap->isIdentity &= (pMap->aMap[c] == c);
+  }
+  return pMap;
+}
+
+/* use the global color table for a frame with a local color table, if all its colors are in there (the local color table is not written).
+   the frame keeps its local color table if the remapped frame is estimated to be larger (longer LZW codes with a larger global color table
+   vs. the bytes of the local color table). */
+static void mapToGlobalTable(CGIF* pGIF, CGIF_Frame* pFrame) {
+  CGIF_FrameConfig* pConfig  = &pFrame->config;
+  const uint32_t    numPixel = MULU16(pGIF->config.width, pGIF->config.height);
+  const int         hasTrans = (pConfig->attrFlags & (CGIF_FRAME_ATTR_HAS_ALPHA | CGIF_FRAME_ATTR_HAS_SET_TRANS)) ? 1 : 0;
+  const LCTMap*     pMap;
+  uint8_t           aUsed[256], aMap[256];
+  uint16_t          numEffLCT, numEffGCT; // number of effective colors (transparent index included)
+  uint32_t          sizeLCT, sizeGCT;
+  int               transIndex;
+
+  if(((pGIF->config.attrFlags & CGIF_ATTR_NO_GLOBAL_TABLE) && !pGIF->hasHoistedGCT) || !(pConfig->attrFlags & CGIF_FRAME_ATTR_USE_LOCAL_TABLE)) {
+    return;
+  }
+  pMap = getLCTMap(pGIF, pConfig);
+  if(!markUsedIndices(pGIF, pConfig, aUsed)) {
+    return;
+  }
+  for(int c = 0; c < pConfig->numLocalPaletteEntries; ++c) {
+    if(aUsed[c] && pMap->aMap[c] < 0) {
+      return; // color not in the global color table
+    }
+    aMap[c] = (uint8_t)pMap->aMap[c];
+  }
+  // transparent index: kept as is (same indices) or first entry after the global color table
+  transIndex = (!hasTrans || pMap->isIdentity) ? pConfig->transIndex : pGIF->config.numGlobalPaletteEntries;
+  if(transIndex > 255) {
+    return; // no free index left
+  }
+  numEffLCT = (hasTrans && pConfig->transIndex >= pConfig->numLocalPaletteEntries) ? pConfig->transIndex + 1 : pConfig->numLocalPaletteEntries;
+  numEffGCT = (hasTrans && transIndex >= pGIF->config.numGlobalPaletteEntries) ? transIndex + 1 : pGIF->config.numGlobalPaletteEntries;
+  if(calcNextPower2Ex(numEffGCT) > calcNextPower2Ex(numEffLCT)) {
+    const uint8_t pow2LCT = calcNextPower2Ex(pConfig->numLocalPaletteEntries);
+    if(cgif_raw_estimatesize(pConfig->pImageData, pGIF->config.width, pGIF->config.height, numEffLCT, &sizeLCT) != CGIF_OK
+    || cgif_raw_estimatesize(pConfig->pImageData, pGIF->config.width, pGIF->config.height, numEffGCT, &sizeGCT) != CGIF_OK
+    || sizeGCT > sizeLCT + 3 * (1u << ((pow2LCT < 1) ? 1 : pow2LCT))) {
+      return;
+    }
+  }
+  if(!pMap->isIdentity) {
+    // the remapped image data goes to the buffer of the frame slot
+    if(pFrame->pSlotImageData == NULL) {
+      pFrame->pSlotImageData = malloc(numPixel);
+      if(pFrame->pSlotImageData == NULL) {
+        return; // keep the local color table
+      }
+    }
+    if(hasTrans) {
+      aMap[pConfig->transIndex] = (uint8_t)transIndex;
+    }
+    for(uint32_t i = 0; i < numPixel; ++i) {
+      pFrame->pSlotImageData[i] = aMap[pConfig->pImageData[i]];
+    }
+    // borrowed buffers are not needed anymore
+    if(pFrame->isBorrowed && pFrame->pReleaseFn) {
+      pFrame->pReleaseFn(pFrame->pReleaseContext, pConfig->pImageData, pConfig->pLocalPalette);
+    }
+    pFrame->isBorrowed     = 0;
+    pConfig->pImageData    = pFrame->pSlotImageData;
+    pConfig->pLocalPalette = NULL;
+  }
+  // pLocalPalette of an unchanged borrowed frame is kept for pReleaseFn
+  pConfig->numLocalPaletteEntries = 0;
+  pConfig->attrFlags             &= ~CGIF_FRAME_ATTR_USE_LOCAL_TABLE;
+  if(hasTrans) {
+    pConfig->transIndex = pFrame->transIndex = (uint8_t)transIndex;
+  }
+}
+
+/* build the global color table from the colors used by the queued frames and create the raw GIF stream (CGIF_GEN_HOIST_GLOBAL_TABLE).
+   called before the first frame is written: the frame queue is the lookahead. */
+static cgif_result hoistGlobalTable(CGIF* pGIF) {
+  uint8_t     aGCT[256 * 3];
+  uint16_t    numEntries = 0;
+  cgif_result r;
+
+  for(int i = 1; i < pGIF->sizeFrameQueue; ++i) {
+    if(pGIF->aFrames[i] != NULL) {
+      addToGlobalTable(pGIF, &pGIF->aFrames[i]->config, aGCT, &numEntries);
+    }
+  }
+  if(numEntries) {
+    pGIF->config.pGlobalPalette = malloc(numEntries * 3);
+    if(pGIF->config.pGlobalPalette == NULL) {
+      return CGIF_EALLOC;
+    }
+    memcpy(pGIF->config.pGlobalPalette, aGCT, numEntries * 3);
+    pGIF->config.numGlobalPaletteEntries = numEntries;
+    pGIF->hasHoistedGCT                  = 1;
+  }
+  r = createRawGIF(pGIF);
+  if(r != CGIF_OK) {
+    return r;
+  }
+  for(int i = 1; i < pGIF->sizeFrameQueue; ++i) {
+    if(pGIF->aFrames[i] != NULL) {
+      mapToGlobalTable(pGIF, pGIF->aFrames[i]);
+    }
+  }
+  return CGIF_OK;
+}
+
+/* returns 1 if the patch pRect (cgif_addframe_rect) is non-empty and within the frame */
+static int isValidRect(const CGIF* pGIF, const DimResult* pRect) {
+  return pRect->width && pRect->height && (uint32_t)pRect->left + pRect->width <= pGIF->config.width && (uint32_t)pRect->top + pRect->height <= pGIF->config.height;
+}
+
+/* check whether all pixels of the frame (pImageData, or the patch pRect) are within the color tolerance of pHead */
+static int isNearFrame(const CGIF* pGIF, const uint8_t* pImageData, const CGIF_Frame* pHead, const DimResult* pRect) {
+  const DimResult  frame = { pGIF->config.width, pGIF->config.height, 0, 0 };
+  const DimResult* pArea = (pRect) ? pRect : &frame;
+  const uint8_t*   pNear = pGIF->pNearTable;
+
+  for(uint16_t y = 0; y < pArea->height; ++y) {
+    const uint8_t* pCurRow = pImageData + ((pRect) ? MULU16(y, pRect->width) : MULU16(y, pGIF->config.width));
+    const uint8_t* pBefRow = pHead->config.pImageData + MULU16(pArea->top + y, pGIF->config.width) + pArea->left;
+    if(memcmp(pCurRow, pBefRow, pArea->width) == 0) {
+      continue;
+    }
+    for(uint16_t x = 0; x < pArea->width; ++x) {
+      if(!pNear[((uint32_t)pCurRow[x] << 8) | pBefRow[x]]) {
+        return 0;
+      }
+    }
+  }
+  return 1;
+}
+
+/* set the pixels of the frame (full frame in pImageData, within pRect only if given) that are within the color tolerance of pHead to the color index of pHead */
+static void snapToFrame(const CGIF* pGIF, uint8_t* pImageData, const CGIF_Frame* pHead, const DimResult* pRect) {
+  const DimResult  frame = { pGIF->config.width, pGIF->config.height, 0, 0 };
+  const DimResult* pArea = (pRect) ? pRect : &frame;
+  const uint8_t*   pNear = pGIF->pNearTable;
+
+  for(uint16_t y = 0; y < pArea->height; ++y) {
+    const uint32_t offset  = MULU16(pArea->top + y, pGIF->config.width) + pArea->left;
+    uint8_t*       pCurRow = pImageData + offset;
+    const uint8_t* pBefRow = pHead->config.pImageData + offset;
+    for(uint16_t x = 0; x < pArea->width; ++x) {
+      pCurRow[x] = (pNear[((uint32_t)pCurRow[x] << 8) | pBefRow[x]]) ? pBefRow[x] : pCurRow[x];
+    }
+  }
+}
+
+/* copy the local color table of pConfig into the LCT buffer of a frame slot; returns 0 if out of memory */
+static int copySlotLCT(CGIF_Frame* pFrame, const CGIF_FrameConfig* pConfig) {
+  if(pFrame->pSlotLCT == NULL || pFrame->sizeSlotLCT < pConfig->numLocalPaletteEntries) {
+    // reserve space for the largest valid LCT right away, so the buffer never needs to grow later on
+    const uint16_t sizeLCT = (pConfig->numLocalPaletteEntries > 256) ? pConfig->numLocalPaletteEntries : 256;
+    free(pFrame->pSlotLCT);
+    pFrame->sizeSlotLCT = 0;
+    pFrame->pSlotLCT    = malloc(sizeLCT * 3);
+    if(pFrame->pSlotLCT == NULL) {
+      return 0;
+    }
+    pFrame->sizeSlotLCT = sizeLCT;
+  }
+  memcpy(pFrame->pSlotLCT, pConfig->pLocalPalette, pConfig->numLocalPaletteEntries * 3);
+  return 1;
+}
+
+/* keep a copy of a frame dropped by the frame rate cap (minDelay): a patch or user-provided transparency of the next frame builds on it */
+static cgif_result keepDroppedFrame(CGIF* pGIF, const CGIF_FrameConfig* pConfig) {
+  CGIF_Frame* pFrame = pGIF->pDropped;
+
+  pGIF->pDropped = NULL;
+  if(pFrame == NULL) {
+    pFrame = getFrameSlot(pGIF);
+    if(pFrame == NULL) {
+      return CGIF_EALLOC;
+    }
+  }
+  if(pFrame->pSlotImageData == NULL) {
+    pFrame->pSlotImageData = malloc(MULU16(pGIF->config.width, pGIF->config.height));
+  }
+  if(pFrame->pSlotImageData == NULL || ((pConfig->attrFlags & CGIF_FRAME_ATTR_USE_LOCAL_TABLE) && !copySlotLCT(pFrame, pConfig))) {
+    freeFrame(pGIF, pFrame);
+    return CGIF_EALLOC;
+  }
+  memcpy(pFrame->pSlotImageData, pConfig->pImageData, MULU16(pGIF->config.width, pGIF->config.height));
+  memset(&pFrame->config, 0, sizeof(CGIF_FrameConfig));
+  copyFrameConfig(&pFrame->config, (CGIF_FrameConfig*)pConfig);
+  pFrame->config.pImageData = pFrame->pSlotImageData;
+  if(pConfig->attrFlags & CGIF_FRAME_ATTR_USE_LOCAL_TABLE) {
+    pFrame->config.pLocalPalette = pFrame->pSlotLCT;
+  }
+  pFrame->pReleaseFn     = NULL;
+  pFrame->isBorrowed     = 0;
+  pFrame->hasHash        = 0;
+  pFrame->hasTileTags    = 0;
+  pFrame->pRectBase      = NULL;
+  memset(&pFrame->rect, 0, sizeof(DimResult));
+  pFrame->disposalMethod = (pGIF->config.attrFlags & CGIF_ATTR_HAS_TRANSPARENCY) ? DISPOSAL_METHOD_BACKGROUND : DISPOSAL_METHOD_LEAVE;
+  pFrame->transIndex     = (pConfig->attrFlags & CGIF_FRAME_ATTR_HAS_ALPHA) ? pConfig->transIndex : 0;
+  pGIF->pDropped         = pFrame;
+  return CGIF_OK;
+}
+
+/* the frame dropped last (minDelay) replaces the frame added last (not written yet), which was shown for both delays */
+static void restoreDroppedFrame(CGIF* pGIF) {
+  CGIF_Frame* pHead = pGIF->aFrames[pGIF->iHEAD];
+  CGIF_Frame* pFrame = pGIF->pDropped;
+
+  pFrame->config.delay          = pHead->config.delay;
+  pGIF->pDropped                = NULL;
+  pGIF->aFrames[pGIF->iHEAD]    = pFrame;
+  freeFrame(pGIF, pHead);
+  mapToGlobalTable(pGIF, pFrame);
+}
+
+/* queue a new GIF frame (isBorrowed: keep the user's buffers instead of making a deep copy; *pIsQueued is set once the frame is in the queue)
+   pRect: pImageData only holds this patch of the frame, the rest is taken from the frame before (NULL: full frame)
+   pDirtyTiles: tiles that might differ from the frame before (NULL: unknown) */
+static int addFrame(CGIF* pGIF, CGIF_FrameConfig* pConfig, int isBorrowed, cgif_release_fn* pReleaseFn, void* pReleaseContext, const DimResult* pRect, const uint8_t* pDirtyTiles, int* pIsQueued) {
   CGIF_Frame* pNewFrame;
-  int         hasAlpha, hasSetTransp;
+  CGIF_Frame* pHead; // frame added last (the patch of cgif_addframe_rect is applied to it)
+  int         hasAlpha, hasSetTransp, hasHash, hasTileTags, isSnapped, isReplacing;
   uint32_t    i;
+  uint64_t    hash;
   cgif_result r;
 
   // check for previous errors
@@ -506,20 +2188,106 @@ int cgif_addframe(CGIF* pGIF, CGIF_FrameConfig* pConfig) {
     pGIF->curResult = CGIF_ERROR;
     return CGIF_ERROR; // invalid config
   }
+  // the frame before was dropped (minDelay): patches and user-provided transparency build on it, so its copy takes the place of the frame added last
+  if(pGIF->hasDropped && (pRect || hasSetTransp)) {
+    restoreDroppedFrame(pGIF);
+  }
+  if(pGIF->pDropped) {
+    freeFrame(pGIF, pGIF->pDropped);
+    pGIF->pDropped = NULL;
+  }
+  // dirty tiles are given relative to the dropped frame
+  if(pGIF->hasDropped) {
+    pDirtyTiles = NULL;
+  }
+  // patch (cgif_addframe_rect): must be within the frame, both the patch and the frame before use the global color table as is
+  pHead = pGIF->aFrames[pGIF->iHEAD];
+  if(pRect && (!isValidRect(pGIF, pRect) || hasAlpha || (pConfig->attrFlags & (CGIF_FRAME_ATTR_USE_LOCAL_TABLE | CGIF_FRAME_ATTR_HAS_SET_TRANS))
+     || pHead == NULL || (pHead->config.attrFlags & (CGIF_FRAME_ATTR_USE_LOCAL_TABLE | CGIF_FRAME_ATTR_HAS_ALPHA | CGIF_FRAME_ATTR_HAS_SET_TRANS)))) {
+    pGIF->curResult = CGIF_ERROR;
+    return pGIF->curResult;
+  }
+
+  // frame rate cap (minDelay): the frame before is shown shorter than minDelay.
+  // drop the new frame and add its delay to the frame before, or replace the frame before (CGIF_GEN_RATE_KEEP_LATEST, always for patches).
+  // an alpha channel over a frame without one is never capped: the frame before pHead was not prepared for it (disposal method, diff window)
+  isReplacing = 0;
+  if(pHead && pHead->config.delay < pGIF->config.minDelay && (uint32_t)pHead->config.delay + pConfig->delay <= 0xFFFF
+     && !hasSetTransp && !(pHead->config.attrFlags & CGIF_FRAME_ATTR_HAS_SET_TRANS)
+     && (!(pConfig->attrFlags & CGIF_FRAME_ATTR_HAS_ALPHA) || (pHead->config.attrFlags & CGIF_FRAME_ATTR_HAS_ALPHA))) {
+    if(!pRect && !(pGIF->config.genFlags & CGIF_GEN_RATE_KEEP_LATEST)) {
+      // a copy is kept: it replaces the frame before if a patch or user-provided transparency follows (as with CGIF_GEN_RATE_KEEP_LATEST)
+      r = keepDroppedFrame(pGIF, pConfig);
+      if(r != CGIF_OK) {
+        pGIF->curResult = r;
+        return pGIF->curResult;
+      }
+      pHead->config.delay += pConfig->delay;
+      pGIF->hasDropped     = 1;
+      return CGIF_OK;
+    }
+    isReplacing = 1;
+  }
+  pGIF->hasDropped = 0;
+
+  // color tolerance: the pixels within the tolerance of pHead are set to the color index of pHead (snapped) once the frame is copied.
+  // all later comparisons are exact, the canvas never differs from the frames by more than the tolerance.
+  // both frames must use the global color table as is
+  isSnapped = (pGIF->pNearTable && pHead && !hasAlpha && !hasSetTransp && !(pConfig->attrFlags & CGIF_FRAME_ATTR_USE_LOCAL_TABLE)
+              && !(pHead->config.attrFlags & (CGIF_FRAME_ATTR_USE_LOCAL_TABLE | CGIF_FRAME_ATTR_HAS_ALPHA | CGIF_FRAME_ATTR_HAS_SET_TRANS))) ? 1 : 0;
+
+  // content hash of the frame, if required (CGIF_GEN_REUSE_FRAMES set)
+  // not possible with alpha channel or user-provided transparency: the look of the frame depends on the frame before
+  hash    = 0;
+  // patches are not hashed: that would need the full frame
+  hasHash = ((pGIF->config.genFlags & CGIF_GEN_REUSE_FRAMES) && !hasAlpha && !hasSetTransp && !pRect) ? 1 : 0;
+  if(hasHash && !isSnapped) {
+    hash = hashFrame(pGIF, pConfig); // snapped frames: hashed once snapped
+  }
+  // tile tags, if required (CGIF_GEN_TILE_HASH set or dirty tiles given): global color table only, as the color indices are compared
+  // patches and dirty tiles: the tags of the unchanged tiles are taken from the frame before (if it has them), no hashing
+  // snapped frames have no tile tags (their content changes with the snap)
+  hasTileTags = 0;
+  if(!hasAlpha && !hasSetTransp && !isSnapped && !(pConfig->attrFlags & CGIF_FRAME_ATTR_USE_LOCAL_TABLE)) {
+    hasTileTags = (pRect) ? pHead->hasTileTags : ((pGIF->config.genFlags & CGIF_GEN_TILE_HASH) || pDirtyTiles);
+  }
+  if(hasTileTags) {
+    const CGIF_Frame* pBase = ((pRect || pDirtyTiles) && pHead && pHead->hasTileTags) ? pHead : NULL;
+    if(pGIF->pTileTags == NULL) {
+      pGIF->pTileTags = malloc(getNumTiles(pGIF) * sizeof(uint64_t));
+      if(pGIF->pTileTags == NULL) {
+        pGIF->curResult = CGIF_EALLOC;
+        return pGIF->curResult;
+      }
+    }
+    setTileTags(pGIF, (pRect || (pDirtyTiles && !(pGIF->config.genFlags & CGIF_GEN_TILE_HASH))) ? NULL : pConfig->pImageData, pBase, pDirtyTiles, pRect, (pHead && pHead->hasTileTags) ? pHead : NULL);
+  }
 
   // if frame matches previous frame, drop it completely and sum the frame delay
   if(pGIF->aFrames[pGIF->iHEAD] != NULL) {
     const uint32_t frameDelay = pConfig->delay + pGIF->aFrames[pGIF->iHEAD]->config.delay;
     if(frameDelay <= 0xFFFF && !(pGIF->config.genFlags & CGIF_GEN_KEEP_IDENT_FRAMES)) {
       int sameFrame = 1;
-      if ((pConfig->attrFlags & CGIF_FRAME_ATTR_USE_LOCAL_TABLE) == 0 && (pGIF->aFrames[pGIF->iHEAD]->config.attrFlags & CGIF_FRAME_ATTR_USE_LOCAL_TABLE) == 0
-          && (pConfig->attrFlags & CGIF_FRAME_ATTR_HAS_SET_TRANS) == 0 && (pGIF->aFrames[pGIF->iHEAD]->config.attrFlags & CGIF_FRAME_ATTR_HAS_SET_TRANS) == 0) {
+      if(isSnapped) {
+        sameFrame = isNearFrame(pGIF, pConfig->pImageData, pHead, pRect); // all pixels within the tolerance
+      } else if(hasHash && pGIF->aFrames[pGIF->iHEAD]->hasHash && hash != pGIF->aFrames[pGIF->iHEAD]->hash) {
+        sameFrame = 0; // different hashes: frames differ for sure
+      } else if(pRect) {
+        // only the patch can differ
+        for(i = 0; i < pRect->height && sameFrame; ++i) {
+          sameFrame = !memcmp(pConfig->pImageData + MULU16(i, pRect->width), pHead->config.pImageData + MULU16(pRect->top + i, pGIF->config.width) + pRect->left, pRect->width);
+        }
+      } else if(hasTileTags && pHead->hasTileTags) {
+        sameFrame = isSameByTiles(pGIF, pConfig->pImageData, pHead); // only the tiles with different tags are compared
+      } else if (canCmpIndices(pConfig, &pGIF->aFrames[pGIF->iHEAD]->config)) {
         if (memcmp(pConfig->pImageData, pGIF->aFrames[pGIF->iHEAD]->config.pImageData, MULU16(pGIF->config.width, pGIF->config.height))) {
           sameFrame = 0;
         }
       } else {
+        PixelEqTable eqTable;
+        initPixelEqTable(pGIF, pConfig, &pGIF->aFrames[pGIF->iHEAD]->config, &eqTable);
         for(i = 0; i < MULU16(pGIF->config.width, pGIF->config.height); i++) {
-          if(cmpPixel(pGIF, pConfig, &pGIF->aFrames[pGIF->iHEAD]->config, pConfig->pImageData[i], pGIF->aFrames[pGIF->iHEAD]->config.pImageData[i])) {
+          if(cmpPixel(&eqTable, pConfig->pImageData[i], pGIF->aFrames[pGIF->iHEAD]->config.pImageData[i])) {
             sameFrame = 0;
             break;
           }
@@ -533,117 +2301,553 @@ int cgif_addframe(CGIF* pGIF, CGIF_FrameConfig* pConfig) {
     }
   }
 
-  // search for free slot in frame queue
-  for(i = pGIF->iHEAD; i < SIZE_FRAME_QUEUE && pGIF->aFrames[i] != NULL; ++i);
+  // the frame is queued: adapt the disposal method of the frame before (pHead).
+  // done before the queue is flushed, as pHead is written right away with a frame queue of 2.
+  if(pHead != NULL && !isReplacing) {
+    if(pGIF->config.attrFlags & CGIF_ATTR_HAS_TRANSPARENCY) {
+      pHead->config.genFlags &= ~(CGIF_FRAME_GEN_USE_TRANSPARENCY | CGIF_FRAME_GEN_USE_DIFF_WINDOW);
+      pHead->disposalMethod   = DISPOSAL_METHOD_BACKGROUND; // restore to background color
+    }
+    // per-frame alpha channel
+    if(pConfig->attrFlags & CGIF_FRAME_ATTR_HAS_ALPHA) {
+      pHead->config.genFlags &= ~(CGIF_FRAME_GEN_USE_DIFF_WINDOW); // width/height optim not possible for frame before
+      pHead->disposalMethod   = DISPOSAL_METHOD_BACKGROUND; // restore to background color
+    }
+  }
+  // search for free slot in frame queue (replacing: the slot of pHead, not written yet)
+  for(i = pGIF->iHEAD; !isReplacing && i < (uint32_t)pGIF->sizeFrameQueue && pGIF->aFrames[i] != NULL; ++i);
   // check whether the queue is full
   // when queue is full: we need to flush one frame.
-  if(i == SIZE_FRAME_QUEUE) {
+  if(i == (uint32_t)pGIF->sizeFrameQueue) {
+    // first frame to be written: the GIF header is not written yet (CGIF_GEN_HOIST_GLOBAL_TABLE)
+    if(pGIF->pGIFRaw == NULL) {
+      r = hoistGlobalTable(pGIF);
+      if(r != CGIF_OK) {
+        pGIF->curResult = r;
+        return pGIF->curResult;
+      }
+    }
+    chooseDisposal(pGIF, pGIF->aFrames[1], pGIF->aFrames[0], (i > 2) ? pGIF->aFrames[2] : NULL);
     r = flushFrame(pGIF, pGIF->aFrames[1], pGIF->aFrames[0]);
-    freeFrame(pGIF->aFrames[0]);
-    pGIF->aFrames[0] = NULL; // avoid potential double free in cgif_close
+    if(pGIF->aFrames[1]->disposalMethod == DISPOSAL_METHOD_PREVIOUS) {
+      // the canvas is restored after the flushed frame: the frame before stays the reference for the next one.
+      freeFrame(pGIF, pGIF->aFrames[1]);
+    } else {
+      freeFrame(pGIF, pGIF->aFrames[0]);
+      pGIF->aFrames[0] = pGIF->aFrames[1];
+    }
+    pGIF->aFrames[1] = NULL; // avoid potential double free in cgif_close
     // check for errors
     if(r != CGIF_OK) {
       pGIF->curResult = r;
       return pGIF->curResult;
     }
-    i = SIZE_FRAME_QUEUE - 1;
+    i = pGIF->sizeFrameQueue - 1;
     // keep the flushed frame in memory, as we might need it to write the next one.
-    pGIF->aFrames[0] = pGIF->aFrames[1];
-    pGIF->aFrames[1] = pGIF->aFrames[2];
-    pGIF->aFrames[2] = NULL;
+    memmove(&pGIF->aFrames[1], &pGIF->aFrames[2], (i - 1) * sizeof(CGIF_Frame*));
+    pGIF->aFrames[i] = NULL;
   }
-  // create new Frame struct + make a deep copy of pConfig.
-  pNewFrame = malloc(sizeof(CGIF_Frame));
+  // get a frame slot + make a deep copy of pConfig.
+  // the buffers of a recycled slot are reused: no allocations per frame in steady state.
+  pNewFrame = getFrameSlot(pGIF);
   if(pNewFrame == NULL) {
     pGIF->curResult = CGIF_EALLOC;
     return pGIF->curResult;
   }
-  copyFrameConfig(&(pNewFrame->config), pConfig);
-  pNewFrame->config.pImageData = malloc(MULU16(pGIF->config.width, pGIF->config.height));
-  if(pNewFrame->config.pImageData == NULL) {
-    free(pNewFrame);
+  // borrowed frames: image data and LCT stay with the user until the frame is released
+  // patches are always copied: the frame is the frame before with the patch applied. so are snapped frames (color tolerance)
+  if(!isBorrowed || pRect || isSnapped) {
+    if(pNewFrame->pSlotImageData == NULL) {
+      pNewFrame->pSlotImageData = malloc(MULU16(pGIF->config.width, pGIF->config.height));
+      if(pNewFrame->pSlotImageData == NULL) {
+        freeFrame(pGIF, pNewFrame);
+        pGIF->curResult = CGIF_EALLOC;
+        return pGIF->curResult;
+      }
+    }
+  }
+  if(pRect) {
+    memcpy(pNewFrame->pSlotImageData, pHead->config.pImageData, MULU16(pGIF->config.width, pGIF->config.height));
+    for(uint16_t y = 0; y < pRect->height; ++y) {
+      memcpy(pNewFrame->pSlotImageData + MULU16(pRect->top + y, pGIF->config.width) + pRect->left, pConfig->pImageData + MULU16(y, pRect->width), pRect->width);
+    }
+    // borrowed patch (encoder thread): not needed anymore
+    if(isBorrowed && pReleaseFn) {
+      pReleaseFn(pReleaseContext, pConfig->pImageData, pConfig->pLocalPalette);
+    }
+    isBorrowed = 0;
+    pReleaseFn = NULL;
+  } else if(!isBorrowed || isSnapped) {
+    memcpy(pNewFrame->pSlotImageData, pConfig->pImageData, MULU16(pGIF->config.width, pGIF->config.height));
+    // borrowed frame (snapped copy): not needed anymore
+    if(isBorrowed && pReleaseFn) {
+      pReleaseFn(pReleaseContext, pConfig->pImageData, pConfig->pLocalPalette);
+    }
+    isBorrowed = 0;
+    pReleaseFn = NULL;
+  }
+  if(isSnapped) {
+    snapToFrame(pGIF, pNewFrame->pSlotImageData, pHead, pRect);
+  }
+  // make a deep copy of the local color table, if required.
+  if(!isBorrowed && (pConfig->attrFlags & CGIF_FRAME_ATTR_USE_LOCAL_TABLE) && !copySlotLCT(pNewFrame, pConfig)) {
+    freeFrame(pGIF, pNewFrame);
     pGIF->curResult = CGIF_EALLOC;
     return pGIF->curResult;
   }
-  memcpy(pNewFrame->config.pImageData, pConfig->pImageData, MULU16(pGIF->config.width, pGIF->config.height));
-  // make a deep copy of the local color table, if required.
-  if(pConfig->attrFlags & CGIF_FRAME_ATTR_USE_LOCAL_TABLE) {
-    pNewFrame->config.pLocalPalette  = malloc(pConfig->numLocalPaletteEntries * 3);
-    if(pNewFrame->config.pLocalPalette == NULL) {
-      free(pNewFrame->config.pImageData);
-      free(pNewFrame);
-      pGIF->curResult = CGIF_EALLOC;
-      return pGIF->curResult;
+  memset(&(pNewFrame->config), 0, sizeof(CGIF_FrameConfig));
+  copyFrameConfig(&(pNewFrame->config), pConfig);
+  pNewFrame->isBorrowed      = isBorrowed;
+  pNewFrame->pReleaseFn      = pReleaseFn;
+  pNewFrame->pReleaseContext = pReleaseContext;
+  pNewFrame->hash            = hash;
+  pNewFrame->hasHash         = hasHash;
+  pNewFrame->pRectBase       = (pRect) ? pHead : NULL;
+  pNewFrame->hasTileTags     = hasTileTags;
+  if(hasTileTags) {
+    // hand the tags over to the frame slot (its former buffer is used for the next frame)
+    uint64_t* pTileTags = pNewFrame->pTileTags;
+    pNewFrame->pTileTags  = pGIF->pTileTags;
+    pNewFrame->tagsID     = ++(pGIF->cntTileTags);
+    pNewFrame->tagsBaseID = (pHead && pHead->hasTileTags) ? pHead->tagsID : 0;
+    pGIF->pTileTags       = pTileTags;
+  }
+  if(pRect) {
+    pNewFrame->rect = *pRect;
+  } else {
+    memset(&pNewFrame->rect, 0, sizeof(DimResult));
+  }
+  if(!isBorrowed) {
+    pNewFrame->config.pImageData = pNewFrame->pSlotImageData;
+    if(pConfig->attrFlags & CGIF_FRAME_ATTR_USE_LOCAL_TABLE) {
+      pNewFrame->config.pLocalPalette = pNewFrame->pSlotLCT;
     }
-    memcpy(pNewFrame->config.pLocalPalette, pConfig->pLocalPalette, pConfig->numLocalPaletteEntries * 3);
+  }
+  if(hasHash && isSnapped) {
+    pNewFrame->hash = hashFrame(pGIF, &pNewFrame->config);
+  }
+  // replacing pHead: the new frame is shown for both delays, a patch is not just a patch of the frame before anymore
+  if(isReplacing) {
+    pNewFrame->config.delay = pHead->config.delay + pConfig->delay;
+    pNewFrame->pRectBase    = NULL;
+    memset(&pNewFrame->rect, 0, sizeof(DimResult));
+    freeFrame(pGIF, pHead);
   }
   pNewFrame->disposalMethod        = DISPOSAL_METHOD_LEAVE;
   pNewFrame->transIndex            = 0;
   pGIF->aFrames[i]                 = pNewFrame; // add frame to queue
   pGIF->iHEAD                      = i;         // update HEAD index
-  // check whether we need to adapt the disposal method of the frame before.
+  *pIsQueued                       = 1;
   if(pGIF->config.attrFlags & CGIF_ATTR_HAS_TRANSPARENCY) {
     pGIF->aFrames[i]->disposalMethod = DISPOSAL_METHOD_BACKGROUND; // TBD might be removed
     pGIF->aFrames[i]->transIndex     = 0;
-    if(pGIF->aFrames[i - 1] != NULL) {
-      pGIF->aFrames[i - 1]->config.genFlags &= ~(CGIF_FRAME_GEN_USE_TRANSPARENCY | CGIF_FRAME_GEN_USE_DIFF_WINDOW);
-      pGIF->aFrames[i - 1]->disposalMethod   = DISPOSAL_METHOD_BACKGROUND; // restore to background color
-    }
   }
-  // set per-frame alpha channel (we need to adapt the disposal method of the frame before)
+  // set per-frame alpha channel
   if(pConfig->attrFlags & CGIF_FRAME_ATTR_HAS_ALPHA) {
     pGIF->aFrames[i]->transIndex = pConfig->transIndex;
-    if(pGIF->aFrames[i - 1] != NULL) {
-      pGIF->aFrames[i - 1]->config.genFlags &= ~(CGIF_FRAME_GEN_USE_DIFF_WINDOW); // width/height optim not possible for frame before
-      pGIF->aFrames[i - 1]->disposalMethod   = DISPOSAL_METHOD_BACKGROUND; // restore to background color
-    }
   }
   // user provided transparency setting
   if(hasSetTransp) {
     pGIF->aFrames[i]->transIndex = pConfig->transIndex;
   }
+  mapToGlobalTable(pGIF, pGIF->aFrames[i]);
   pGIF->curResult = CGIF_OK;
   return pGIF->curResult;
 }
 
-/* close the GIF-file and free allocated space */
-int cgif_close(CGIF* pGIF) {
+#ifdef CGIF_ASYNC
+/* wake up the other thread (waiting for a ring to be non-empty / non-full) */
+static void wakeAsync(AsyncState* pAsync) {
+  pthread_mutex_lock(&pAsync->mutex);
+  pthread_cond_broadcast(&pAsync->cond);
+  pthread_mutex_unlock(&pAsync->mutex);
+}
+
+/* release callback of copied frames: hand the buffer back to the calling thread */
+static void releaseAsyncBuffer(void* pContext, uint8_t* pImageData, uint8_t* pLocalPalette) {
+  AsyncBuffer*   pBuffer = (AsyncBuffer*)pContext;
+  AsyncState*    pAsync  = pBuffer->pAsync;
+  const uint32_t head    = pAsync->freeHead;
+  (void)pImageData;
+  (void)pLocalPalette;
+
+  pAsync->aFree[head % NUM_ASYNC_BUFFERS] = (uint8_t)(pBuffer - pAsync->aBuffer);
+  ATOMIC_STORE(&pAsync->freeHead, head + 1);
+  wakeAsync(pAsync);
+}
+
+/* encoder thread: add the frames of the ring until cgif_close is called */
+static void* asyncEncoder(void* pArg) {
+  CGIF*       pGIF   = (CGIF*)pArg;
+  AsyncState* pAsync = pGIF->pAsync;
+  AsyncFrame* pFrame;
+  uint32_t    tail;
+  int         isQueued;
+  cgif_result r;
+
+  for(;;) {
+    tail = pAsync->ringTail;
+    pthread_mutex_lock(&pAsync->mutex);
+    while(ATOMIC_LOAD(&pAsync->ringHead) == tail && !ATOMIC_LOAD(&pAsync->isClosing)) {
+      pthread_cond_wait(&pAsync->cond, &pAsync->mutex);
+    }
+    pthread_mutex_unlock(&pAsync->mutex);
+    if(ATOMIC_LOAD(&pAsync->ringHead) == tail) {
+      break; // closing + all frames added
+    }
+    // after an error: addFrame returns the error right away (the frame is released)
+    pFrame   = &pAsync->aRing[tail % SIZE_ASYNC_RING];
+    isQueued = 0;
+    r = addFrame(pGIF, &pFrame->config, 1, pFrame->pReleaseFn, pFrame->pReleaseContext, (pFrame->rect.width) ? &pFrame->rect : NULL, pFrame->pDirtyTiles, &isQueued);
+    if(!isQueued && pFrame->pReleaseFn) {
+      pFrame->pReleaseFn(pFrame->pReleaseContext, pFrame->config.pImageData, pFrame->config.pLocalPalette);
+    }
+    if(r != CGIF_OK && ATOMIC_LOAD(&pAsync->result) == CGIF_OK) {
+      ATOMIC_STORE(&pAsync->result, r); // reported by the next cgif_addframe call
+    }
+    ATOMIC_STORE(&pAsync->ringTail, tail + 1);
+    wakeAsync(pAsync);
+  }
+  return NULL;
+}
+
+/* start the encoder thread (on the first frame); returns 0 if frames are to be added synchronously */
+static int startAsync(CGIF* pGIF) {
+  AsyncState* pAsync;
+
+  pAsync = malloc(sizeof(AsyncState));
+  if(pAsync == NULL) {
+    return 0;
+  }
+  memset(pAsync, 0, sizeof(AsyncState));
+  pAsync->result       = CGIF_OK;
+  pAsync->callerResult = CGIF_OK;
+  if(pthread_mutex_init(&pAsync->mutex, NULL)) {
+    free(pAsync);
+    return 0;
+  }
+  if(pthread_cond_init(&pAsync->cond, NULL)) {
+    pthread_mutex_destroy(&pAsync->mutex);
+    free(pAsync);
+    return 0;
+  }
+  pGIF->pAsync = pAsync;
+  if(pthread_create(&pAsync->thread, NULL, asyncEncoder, pGIF)) {
+    pthread_cond_destroy(&pAsync->cond);
+    pthread_mutex_destroy(&pAsync->mutex);
+    free(pAsync);
+    pGIF->pAsync = NULL;
+    return 0;
+  }
+  return 1;
+}
+
+/* let the encoder thread add the remaining frames and wait for it to finish */
+static void stopAsync(CGIF* pGIF) {
+  AsyncState* pAsync = pGIF->pAsync;
+
+  ATOMIC_STORE(&pAsync->isClosing, 1);
+  wakeAsync(pAsync);
+  pthread_join(pAsync->thread, NULL);
+  if(pAsync->callerResult != CGIF_OK) {
+    pGIF->curResult = pAsync->callerResult;
+  }
+}
+
+/* free the async state (encoder thread is stopped, all frames are released) */
+static void freeAsync(AsyncState* pAsync) {
+  for(int i = 0; i < pAsync->numBuffers; ++i) {
+    free(pAsync->aBuffer[i].pImageData);
+    free(pAsync->aBuffer[i].pLCT);
+    free(pAsync->aBuffer[i].pDirtyTiles);
+  }
+  pthread_cond_destroy(&pAsync->cond);
+  pthread_mutex_destroy(&pAsync->mutex);
+  free(pAsync);
+}
+
+/* get a free image buffer for a copied frame (waits for the encoder thread if all buffers are in use); returns its index or -1 on error */
+static int getAsyncBuffer(CGIF* pGIF, uint16_t sizeLCT) {
+  AsyncState*  pAsync = pGIF->pAsync;
+  AsyncBuffer* pBuffer;
+  int          i;
+
+  if(ATOMIC_LOAD(&pAsync->freeHead) == pAsync->freeTail && pAsync->numBuffers < SIZE_ASYNC_RING + pGIF->sizeFrameQueue) {
+    // allocate a new buffer
+    pBuffer = &pAsync->aBuffer[pAsync->numBuffers];
+    pBuffer->pAsync     = pAsync;
+    pBuffer->pImageData = malloc(MULU16(pGIF->config.width, pGIF->config.height));
+    if(pBuffer->pImageData == NULL) {
+      return -1;
+    }
+    i = pAsync->numBuffers++;
+  } else {
+    // recycle a buffer released by the encoder thread
+    pthread_mutex_lock(&pAsync->mutex);
+    while(ATOMIC_LOAD(&pAsync->freeHead) == pAsync->freeTail) {
+      pthread_cond_wait(&pAsync->cond, &pAsync->mutex);
+    }
+    pthread_mutex_unlock(&pAsync->mutex);
+    i = pAsync->aFree[pAsync->freeTail % NUM_ASYNC_BUFFERS];
+    pAsync->freeTail++;
+    pBuffer = &pAsync->aBuffer[i];
+  }
+  if(sizeLCT > pBuffer->sizeLCT) {
+    // reserve space for the largest valid LCT right away (as for frame slots)
+    const uint16_t size = (sizeLCT > 256) ? sizeLCT : 256;
+    free(pBuffer->pLCT);
+    pBuffer->sizeLCT = 0;
+    pBuffer->pLCT    = malloc(size * 3);
+    if(pBuffer->pLCT == NULL) {
+      return -1; // buffer is freed by cgif_close
+    }
+    pBuffer->sizeLCT = size;
+  }
+  return i;
+}
+
+/* hand a new frame over to the encoder thread: copy it into a free buffer (isBorrowed = 0) or pass the user's buffers on.
+   waits if the encoder thread falls behind (ring full). errors of the encoder thread are returned by the next call. */
+static int addFrameAsync(CGIF* pGIF, CGIF_FrameConfig* pConfig, int isBorrowed, cgif_release_fn* pReleaseFn, void* pReleaseContext, const DimResult* pRect, const uint8_t* pDirtyTiles, int* pIsQueued) {
+  AsyncState*    pAsync = pGIF->pAsync;
+  AsyncFrame*    pFrame;
+  const uint32_t head = pAsync->ringHead;
+  int            i;
+
+  if(pAsync->callerResult != CGIF_OK) {
+    return pAsync->callerResult;
+  }
+  if(ATOMIC_LOAD(&pAsync->result) != CGIF_OK) {
+    return ATOMIC_LOAD(&pAsync->result);
+  }
+  // the size of the patch is needed to copy it: check it right away (the rest is checked by the encoder thread)
+  if(pRect && !isValidRect(pGIF, pRect)) {
+    pAsync->callerResult = CGIF_ERROR;
+    return pAsync->callerResult;
+  }
+  // wait for a free spot in the ring (backpressure)
+  pthread_mutex_lock(&pAsync->mutex);
+  while(head - ATOMIC_LOAD(&pAsync->ringTail) == SIZE_ASYNC_RING) {
+    pthread_cond_wait(&pAsync->cond, &pAsync->mutex);
+  }
+  pthread_mutex_unlock(&pAsync->mutex);
+  pFrame = &pAsync->aRing[head % SIZE_ASYNC_RING];
+  memset(&pFrame->config, 0, sizeof(CGIF_FrameConfig));
+  copyFrameConfig(&pFrame->config, pConfig);
+  pFrame->pDirtyTiles = NULL;
+  if(isBorrowed) {
+    pFrame->pReleaseFn      = pReleaseFn;
+    pFrame->pReleaseContext = pReleaseContext;
+  } else {
+    const uint16_t sizeLCT = (pConfig->attrFlags & CGIF_FRAME_ATTR_USE_LOCAL_TABLE) ? pConfig->numLocalPaletteEntries : 0;
+    i = getAsyncBuffer(pGIF, sizeLCT);
+    if(i < 0) {
+      pAsync->callerResult = CGIF_EALLOC;
+      return pAsync->callerResult;
+    }
+    memcpy(pAsync->aBuffer[i].pImageData, pConfig->pImageData, (pRect) ? MULU16(pRect->width, pRect->height) : MULU16(pGIF->config.width, pGIF->config.height));
+    pFrame->config.pImageData = pAsync->aBuffer[i].pImageData;
+    if(sizeLCT) {
+      memcpy(pAsync->aBuffer[i].pLCT, pConfig->pLocalPalette, sizeLCT * 3);
+      pFrame->config.pLocalPalette = pAsync->aBuffer[i].pLCT;
+    }
+    if(pDirtyTiles) {
+      if(pAsync->aBuffer[i].pDirtyTiles == NULL) {
+        pAsync->aBuffer[i].pDirtyTiles = malloc(getNumTiles(pGIF));
+        if(pAsync->aBuffer[i].pDirtyTiles == NULL) {
+          pAsync->callerResult = CGIF_EALLOC; // buffer is freed by cgif_close
+          return pAsync->callerResult;
+        }
+      }
+      memcpy(pAsync->aBuffer[i].pDirtyTiles, pDirtyTiles, getNumTiles(pGIF));
+      pFrame->pDirtyTiles = pAsync->aBuffer[i].pDirtyTiles;
+    }
+    pFrame->pReleaseFn      = releaseAsyncBuffer;
+    pFrame->pReleaseContext = &pAsync->aBuffer[i];
+  }
+  if(pRect) {
+    pFrame->rect = *pRect;
+  } else {
+    memset(&pFrame->rect, 0, sizeof(DimResult));
+  }
+  ATOMIC_STORE(&pAsync->ringHead, head + 1);
+  wakeAsync(pAsync);
+  *pIsQueued = 1;
+  return CGIF_OK;
+}
+#endif
+
+/* queue a new GIF frame: directly or via the encoder thread (CGIF_GEN_ASYNC_ENCODING set) */
+static int queueFrame(CGIF* pGIF, CGIF_FrameConfig* pConfig, int isBorrowed, cgif_release_fn* pReleaseFn, void* pReleaseContext, const DimResult* pRect, const uint8_t* pDirtyTiles, int* pIsQueued) {
+  if(pGIF->isFinished) {
+    return CGIF_ERROR; // error: output handed over already (cgif_take_output)
+  }
+#ifdef CGIF_ASYNC
+  if(pGIF->config.genFlags & CGIF_GEN_ASYNC_ENCODING) {
+    if(pGIF->pAsync || startAsync(pGIF)) {
+      return addFrameAsync(pGIF, pConfig, isBorrowed, pReleaseFn, pReleaseContext, pRect, pDirtyTiles, pIsQueued);
+    }
+    pGIF->config.genFlags &= ~CGIF_GEN_ASYNC_ENCODING; // no encoder thread: add frames synchronously
+  }
+#endif
+  return addFrame(pGIF, pConfig, isBorrowed, pReleaseFn, pReleaseContext, pRect, pDirtyTiles, pIsQueued);
+}
+
+/* queue a new GIF frame (deep copy of image data and LCT) */
+int cgif_addframe(CGIF* pGIF, CGIF_FrameConfig* pConfig) {
+  int isQueued = 0;
+
+  return queueFrame(pGIF, pConfig, 0, NULL, NULL, NULL, NULL, &isQueued);
+}
+
+/* queue a new GIF frame without copying it: image data and LCT are released via pReleaseFn once cgif is done with them */
+int cgif_addframe_borrow(CGIF* pGIF, CGIF_FrameConfig* pConfig, cgif_release_fn* pReleaseFn, void* pReleaseContext) {
+  int isQueued = 0;
+  int r;
+
+  r = queueFrame(pGIF, pConfig, 1, pReleaseFn, pReleaseContext, NULL, NULL, &isQueued);
+  // frame was not queued (merged with the previous one or error): release it right away
+  if(!isQueued && pReleaseFn) {
+    pReleaseFn(pReleaseContext, pConfig->pImageData, pConfig->pLocalPalette);
+  }
+  return r;
+}
+
+/* queue a new GIF frame given as a patch (left/top/width/height) of the frame before: only the patch is copied and searched for changes */
+int cgif_addframe_rect(CGIF* pGIF, CGIF_FrameConfig* pConfig, uint16_t left, uint16_t top, uint16_t width, uint16_t height) {
+  const DimResult rect     = { width, height, top, left };
+  int             isQueued = 0;
+
+  return queueFrame(pGIF, pConfig, 0, NULL, NULL, &rect, NULL, &isQueued);
+}
+
+/* queue a new GIF frame with the tiles that might differ from the frame before: the other tiles are neither hashed nor compared */
+int cgif_addframe_tiles(CGIF* pGIF, CGIF_FrameConfig* pConfig, const uint8_t* pDirtyTiles) {
+  int isQueued = 0;
+
+  return queueFrame(pGIF, pConfig, 0, NULL, NULL, NULL, pDirtyTiles, &isQueued);
+}
+
+/* estimate the size of the LZW-encoded image data (bytes) without running the full LZW encoding */
+cgif_result cgif_estimate_size(const uint8_t* pImageData, uint16_t width, uint16_t height, uint16_t numColors, uint32_t* pSize) {
+  return cgif_raw_estimatesize(pImageData, width, height, numColors, pSize);
+}
+
+/* write the remaining frames and close the raw GIF stream (memory output: keep the output data) */
+static void finishGIF(CGIF* pGIF) {
+  CGIF_Frame* pCanvas;
   int         r;
-  cgif_result result;
 
+  pGIF->isFinished = 1;
+#ifdef CGIF_ASYNC
+  // the encoder thread adds the remaining frames of the ring first
+  if(pGIF->pAsync) {
+    stopAsync(pGIF);
+  }
+#endif
+  // no frame written so far: the GIF header is not written yet (CGIF_GEN_HOIST_GLOBAL_TABLE)
+  if(pGIF->pGIFRaw == NULL) {
+    r = (pGIF->curResult == CGIF_OK) ? hoistGlobalTable(pGIF) : createRawGIF(pGIF);
+    if(r != CGIF_OK) {
+      pGIF->curResult = r;
+    }
+  }
   // check for previous errors
   if(pGIF->curResult != CGIF_OK) {
-    goto CGIF_CLOSE_Cleanup;
+    goto CGIF_FINISH_Cleanup;
   }
 
   // flush all remaining frames in queue
-  for(int i = 1; i < SIZE_FRAME_QUEUE; ++i) {
+  // pCanvas: frame the canvas is made of (skips frames with DISPOSAL_METHOD_PREVIOUS)
+  pCanvas = pGIF->aFrames[0];
+  for(int i = 1; i < pGIF->sizeFrameQueue; ++i) {
     if(pGIF->aFrames[i] != NULL) {
-      r = flushFrame(pGIF, pGIF->aFrames[i], pGIF->aFrames[i - 1]);
+      chooseDisposal(pGIF, pGIF->aFrames[i], pCanvas, (i + 1 < pGIF->sizeFrameQueue) ? pGIF->aFrames[i + 1] : NULL);
+      r = flushFrame(pGIF, pGIF->aFrames[i], pCanvas);
       if(r != CGIF_OK) {
         pGIF->curResult = r;
         break;
       }
+      if(pGIF->aFrames[i]->disposalMethod != DISPOSAL_METHOD_PREVIOUS) {
+        pCanvas = pGIF->aFrames[i];
+      }
     }
   }
 
   // cleanup
-CGIF_CLOSE_Cleanup:
-  r = cgif_raw_close(pGIF->pGIFRaw); // close raw GIF stream
-  // check for errors
-  if(r != CGIF_OK) {
-    pGIF->curResult = r;
+CGIF_FINISH_Cleanup:
+  if(pGIF->pGIFRaw) {
+    // memory output: the raw GIF stream hands its output data over (written completely)
+    if(pGIF->curResult == CGIF_OK && (pGIF->config.genFlags & CGIF_GEN_MEMORY_OUTPUT)) {
+      r = cgif_raw_takeoutput(pGIF->pGIFRaw, &pGIF->pOutput, &pGIF->sizeOutput);
+      if(r != CGIF_OK) {
+        pGIF->curResult = r;
+      }
+    }
+    r = cgif_raw_close(pGIF->pGIFRaw); // close raw GIF stream
+    pGIF->pGIFRaw = NULL;
+    // check for errors
+    if(r != CGIF_OK) {
+      pGIF->curResult = r;
+    }
   }
+}
+
+/* memory output: write the remaining frames and hand the GIF over to the caller (no copy) */
+int cgif_take_output(CGIF* pGIF, uint8_t** ppData, size_t* pSize) {
+  cgif_result result;
 
+  *ppData = NULL;
+  *pSize  = 0;
+  if(!(pGIF->config.genFlags & CGIF_GEN_MEMORY_OUTPUT) || pGIF->isFinished) {
+    return CGIF_ERROR; // error: no memory output or handed over already
+  }
+  finishGIF(pGIF);
+  result = pGIF->curResult;
+  if(result == CGIF_OK) {
+    *ppData       = pGIF->pOutput;
+    *pSize        = pGIF->sizeOutput;
+    pGIF->pOutput = NULL;
+  }
+  // catch internal value CGIF_PENDING
+  if(result == CGIF_PENDING) {
+    result = CGIF_ERROR;
+  }
+  return result;
+}
+
+/* close the GIF-file and free allocated space */
+int cgif_close(CGIF* pGIF) {
+  int         r;
+  cgif_result result;
+
+  if(!pGIF->isFinished) {
+    finishGIF(pGIF);
+  }
+  // write the rest of the output buffer
+  if(pGIF->pOutBuf && flushOutput(pGIF)) {
+    pGIF->curResult = CGIF_EWRITE;
+  }
+#ifdef CGIF_ASYNC
+  // wait for the writer thread (the file is closed after the last write)
+  if(pGIF->pWriter && stopWriter(pGIF)) {
+    pGIF->curResult = CGIF_EWRITE;
+  }
+#endif
   if(pGIF->pFile) {
     r = fclose(pGIF->pFile); // we are done at this point => close the file
     if(r) {
       pGIF->curResult = CGIF_ECLOSE; // error: fclose failed
     }
   }
-  for(int i = 0; i < SIZE_FRAME_QUEUE; ++i) {
-    freeFrame(pGIF->aFrames[i]);
+  for(int i = 0; i < pGIF->sizeFrameQueue; ++i) {
+    freeFrame(pGIF, pGIF->aFrames[i]);
+  }
+#ifdef CGIF_ASYNC
+  if(pGIF->pAsync) {
+    freeAsync(pGIF->pAsync);
   }
+#endif
 
   result = pGIF->curResult;
   freeCGIF(pGIF);
@@ -1,3 +1,4 @@
+#include <math.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -33,6 +34,12 @@
 #define MAX_DICT_LEN    (1uL << MAX_CODE_LEN) // maximum length of the dictionary
 #define BLOCK_SIZE      0xFF                  // number of bytes in one block of the image data
 
+#define EST_MAX_FULL_PIXEL (1uL << 16)        // size estimation: frames up to this number of pixels are not sampled
+#define EST_STRIPE_ROWS    (8)                // size estimation: number of rows per sampled stripe
+#define EST_SAMPLE_RATE    (8)                // size estimation: one out of EST_SAMPLE_RATE stripes is sampled
+
+#define MAX_OUTPUT_HINT    (1uL << 24)        // memory output: maximum size of the buffer allocated up front without a size hint
+
 #define MULU16(a, b) (((uint32_t)a) * ((uint32_t)b)) // helper macro to correctly multiply two U16's without default signed int promotion
 
 typedef struct {
@@ -47,11 +54,24 @@ typedef struct {
   uint16_t*       pTreeListIdx;   // LZW tree list: child LZW index per node
   uint16_t*       pTreeMap;   // LZW dictionary tree as map (backup to pTreeList in case more than 1 child is present)
   uint16_t*       pLZWData;   // pointer to LZW data
-  const uint8_t*  pImageData; // pointer to image data
+  uint32_t        sizeLZWData; // number of LZW codes pLZWData can hold (grows on demand)
+  uint32_t        maxLZWData;  // upper bound of the number of LZW codes of the frame
+  const uint8_t*  pImageData; // pointer to image data (pixel source: the row read last)
+  const CGIFRaw_FrameConfig* pSrcConfig; // frame given as pixel source: rows are read on demand (NULL: pImageData holds all pixels)
+  uint8_t*        pRow;       // pixel source: row buffer
+  uint8_t*        pRowAlt;    // pixel source (isFlexTrans): alternative index per pixel of pRow (own color of the pixels replaced by transIndex)
+  uint32_t        rowStart;   // position of the first pixel in pImageData
+  uint32_t        rowEnd;     // position after the last pixel in pImageData
+  uint16_t        srcRow;     // pixel source: next row to be read
+  uint8_t         pass;       // pixel source: interlace pass of srcRow
   uint32_t        numPixel;   // number of pixels per frame
   uint32_t        LZWPos;     // position of the current LZW code
+  uint32_t        markPixel;  // size estimation: position in image data at which LZWPosMark is taken (0: none)
+  uint32_t        LZWPosMark; // size estimation: LZW position when markPixel was reached
   uint16_t        dictPos;    // currrent position in dictionary, we need to store 0-4096 -- so there are at least 13 bits needed here
   uint16_t        mapPos;     // current position in LZW tree mapping table
+  uint8_t         startColor; // color of the first pixel of the next LZW string (if hasStart)
+  uint8_t         hasStart;   // 1: the next LZW string starts with startColor instead of the pixel read (alternative index chosen), 0 otherwise
 } LZWGenState;
 
 /* converts host U16 to little-endian (LE) U16 */
@@ -122,10 +142,109 @@ static void add_child(LZWGenState* pContext, const uint16_t parentIndex, const u
   ++(pContext->dictPos); // increase current position in the dictionary
 }
 
+/* read row y of a frame given as pixel source: crop it out of the image and replace the pixels equal to the frame before by transIndex */
+static void readSrcRow(const CGIFRaw_FrameConfig* pConfig, uint32_t y, uint8_t* pOut) {
+  const CGIFRaw_PixelSrc* pSrc       = pConfig->pSrc;
+  const uint32_t          offset     = MULU16(pConfig->top + y, pSrc->stride) + pConfig->left;
+  const uint8_t*          pCurRow    = pSrc->pImageData + offset;
+  const uint8_t*          pBefRow    = (pSrc->pBefImageData) ? pSrc->pBefImageData + offset : NULL;
+  const uint8_t*          pMap       = pSrc->pMap;
+  const uint32_t*         pIDCur     = pSrc->pIDCur; // local copies: pOut might alias the pixel source otherwise
+  const uint32_t*         pIDBef     = pSrc->pIDBef;
+  const uint16_t          width      = pConfig->width;
+  const uint8_t           transIndex = pConfig->transIndex;
+
+  if(pBefRow == NULL && pMap == NULL) {
+    memcpy(pOut, pCurRow, width);
+  } else if(pBefRow == NULL) {
+    for(uint16_t x = 0; x < width; ++x) {
+      pOut[x] = pMap[pCurRow[x]];
+    }
+  } else if(pMap == NULL) {
+    for(uint16_t x = 0; x < width; ++x) {
+      const uint32_t idCur = pIDCur[pCurRow[x]];
+      pOut[x] = ((idCur == pIDBef[pBefRow[x]]) | (idCur == CGIF_RAW_PIXEL_ID_ANY)) ? transIndex : pCurRow[x];
+    }
+  } else {
+    for(uint16_t x = 0; x < width; ++x) {
+      const uint32_t idCur = pIDCur[pCurRow[x]];
+      pOut[x] = ((idCur == pIDBef[pBefRow[x]]) | (idCur == CGIF_RAW_PIXEL_ID_ANY)) ? transIndex : pMap[pCurRow[x]];
+    }
+  }
+}
+
+/* read the alternative indices of row y (see CGIFRaw_PixelSrc.isFlexTrans): the own color of the pixels that are equal to the frame before,
+   pOut holds the row as read by readSrcRow */
+static void readSrcRowAlt(const CGIFRaw_FrameConfig* pConfig, uint32_t y, const uint8_t* pOut, uint8_t* pOutAlt) {
+  const CGIFRaw_PixelSrc* pSrc    = pConfig->pSrc;
+  const uint32_t          offset  = MULU16(pConfig->top + y, pSrc->stride) + pConfig->left;
+  const uint8_t*          pCurRow = pSrc->pImageData + offset;
+  const uint8_t*          pBefRow = pSrc->pBefImageData + offset;
+
+  for(uint16_t x = 0; x < pConfig->width; ++x) {
+    const uint32_t idCur = pSrc->pIDCur[pCurRow[x]];
+    pOutAlt[x] = (idCur == pSrc->pIDBef[pBefRow[x]] && idCur != CGIF_RAW_PIXEL_ID_ANY) ? pCurRow[x] : pOut[x];
+  }
+}
+
+/* read the next row of the pixel source (in interlaced order, if required) */
+static void lzw_read_row(LZWGenState* pContext) {
+  static const uint8_t       aStart[4] = { 0, 4, 2, 1 }; // first row of each interlace pass
+  static const uint8_t       aStep[4]  = { 8, 8, 4, 2 }; // row step of each interlace pass
+  const CGIFRaw_FrameConfig* pConfig   = pContext->pSrcConfig;
+
+  readSrcRow(pConfig, pContext->srcRow, pContext->pRow);
+  if(pContext->pRowAlt) {
+    readSrcRowAlt(pConfig, pContext->srcRow, pContext->pRow, pContext->pRowAlt);
+  }
+  pContext->rowStart = pContext->rowEnd;
+  pContext->rowEnd  += pConfig->width;
+  if(pConfig->attrFlags & CGIF_RAW_FRAME_ATTR_INTERLACED) {
+    pContext->srcRow += aStep[pContext->pass];
+    while(pContext->srcRow >= pConfig->height && pContext->pass < 3) {
+      ++(pContext->pass);
+      pContext->srcRow = aStart[pContext->pass];
+    }
+  } else {
+    ++(pContext->srcRow);
+  }
+}
+
+/* get the color index of the pixel at pos (pixels are read in order) */
+static uint8_t lzw_get_pixel(LZWGenState* pContext, uint32_t pos) {
+  if(pos >= pContext->rowEnd) {
+    lzw_read_row(pContext);
+  }
+  return pContext->pImageData[pos - pContext->rowStart];
+}
+
+/* find the child of parentIndex for the given color (0: none) */
+static uint16_t lzw_find_child(const LZWGenState* pContext, uint16_t parentIndex, uint8_t color, const uint16_t initDictLen) {
+  const uint16_t mapPos = pContext->pTreeListMap[parentIndex];
+
+  if(pContext->pTreeListIdx[parentIndex] && pContext->pTreeListColor[parentIndex] == color) {
+    return pContext->pTreeListIdx[parentIndex];
+  }
+  return (mapPos) ? pContext->pTreeMap[(mapPos - 1) * initDictLen + color] : 0;
+}
+
+/* flexible transparency: color of the first pixel of the next LZW string (pixel pos).
+   the own color is preferred: it continues the content around the changed pixels (and the transparent index still extends the string, see lzw_crawl_tree) */
+static uint8_t lzw_flex_start(LZWGenState* pContext, uint32_t pos, uint8_t nextColor, const uint16_t initDictLen) {
+  const uint8_t alt = pContext->pRowAlt[pos - pContext->rowStart];
+
+  if(alt != nextColor && alt < initDictLen) {
+    pContext->startColor = alt;
+    pContext->hasStart   = 1;
+    return alt;
+  }
+  return nextColor;
+}
+
 /* find next LZW code representing the longest pixel sequence that is still in the dictionary*/
 static int lzw_crawl_tree(LZWGenState* pContext, uint32_t* pStrPos, uint16_t parentIndex, const uint16_t initDictLen) {
   uint16_t* pTreeInit;
-  uint32_t  strPos;
+  uint32_t  strPos, end;
   uint16_t  nextParent;
   uint16_t  mapPos;
 
@@ -138,10 +257,16 @@ static int lzw_crawl_tree(LZWGenState* pContext, uint32_t* pStrPos, uint16_t par
   // the initial nodes (0-255 max) have more children on average.
   // use the mapping approach right from the start for these nodes.
   if(strPos < (pContext->numPixel - 1)) {
-    if(pContext->pImageData[strPos + 1] >= initDictLen) {
+    const uint8_t nextColor = lzw_get_pixel(pContext, strPos + 1);
+    if(nextColor >= initDictLen) {
       return CGIF_EINDEX; // error: index in image data out-of-bounds
     }
-    nextParent = pTreeInit[parentIndex * initDictLen + pContext->pImageData[strPos + 1]];
+    nextParent = pTreeInit[parentIndex * initDictLen + nextColor];
+    if(!nextParent && pContext->pRowAlt) {
+      // flexible transparency: the alternative index of the pixel might extend the string
+      const uint8_t alt = pContext->pRowAlt[strPos + 1 - pContext->rowStart];
+      nextParent = (alt < initDictLen) ? pTreeInit[parentIndex * initDictLen + alt] : 0;
+    }
     if(nextParent) {
       parentIndex = nextParent;
       ++strPos;
@@ -149,7 +274,8 @@ static int lzw_crawl_tree(LZWGenState* pContext, uint32_t* pStrPos, uint16_t par
       pContext->pLZWData[pContext->LZWPos] = parentIndex; // write last LZW code in LZW data
       ++(pContext->LZWPos);
       if(pContext->dictPos < MAX_DICT_LEN) {
-        pTreeInit[parentIndex * initDictLen + pContext->pImageData[strPos + 1]] = pContext->dictPos;
+        const uint8_t startColor = (pContext->pRowAlt) ? lzw_flex_start(pContext, strPos + 1, nextColor, initDictLen) : nextColor;
+        pTreeInit[parentIndex * initDictLen + startColor] = pContext->dictPos;
         ++(pContext->dictPos);
       } else {
         resetDict(pContext, initDictLen);
@@ -160,12 +286,20 @@ static int lzw_crawl_tree(LZWGenState* pContext, uint32_t* pStrPos, uint16_t par
     }
   }
   // inner loop for codes > initDictLen
+  // the pixels up to end are in pImageData: the next row of a pixel source is read only once they are used up
+  end = ((pContext->rowEnd < pContext->numPixel) ? pContext->rowEnd : pContext->numPixel) - 1;
   while(strPos < (pContext->numPixel - 1)) {
-    if(pContext->pImageData[strPos + 1] >= initDictLen) {
+    uint8_t nextColor;
+    if(strPos == end) {
+      lzw_read_row(pContext);
+      end = ((pContext->rowEnd < pContext->numPixel) ? pContext->rowEnd : pContext->numPixel) - 1;
+    }
+    nextColor = pContext->pImageData[strPos + 1 - pContext->rowStart];
+    if(nextColor >= initDictLen) {
       return CGIF_EINDEX;  // error: index in image data out-of-bounds
     }
     // first try to find child in LZW list
-    if(pContext->pTreeListIdx[parentIndex] && pContext->pTreeListColor[parentIndex] == pContext->pImageData[strPos + 1]) {
+    if(pContext->pTreeListIdx[parentIndex] && pContext->pTreeListColor[parentIndex] == nextColor) {
       parentIndex = pContext->pTreeListIdx[parentIndex];
       ++strPos;
       continue;
@@ -173,7 +307,17 @@ static int lzw_crawl_tree(LZWGenState* pContext, uint32_t* pStrPos, uint16_t par
     // not found child yet? try to look into the LZW mapping table
     mapPos = pContext->pTreeListMap[parentIndex];
     if(mapPos) {
-      nextParent = pContext->pTreeMap[(mapPos - 1) * initDictLen + pContext->pImageData[strPos + 1]];
+      nextParent = pContext->pTreeMap[(mapPos - 1) * initDictLen + nextColor];
+      if(nextParent) {
+        parentIndex = nextParent;
+        ++strPos;
+        continue;
+      }
+    }
+    // flexible transparency: the alternative index of the pixel might extend the string
+    if(pContext->pRowAlt) {
+      const uint8_t alt = pContext->pRowAlt[strPos + 1 - pContext->rowStart];
+      nextParent = (alt != nextColor && alt < initDictLen) ? lzw_find_child(pContext, parentIndex, alt, initDictLen) : 0;
       if(nextParent) {
         parentIndex = nextParent;
         ++strPos;
@@ -184,7 +328,10 @@ static int lzw_crawl_tree(LZWGenState* pContext, uint32_t* pStrPos, uint16_t par
     pContext->pLZWData[pContext->LZWPos] = parentIndex; // write last LZW code in LZW data
     ++(pContext->LZWPos);
     if(pContext->dictPos < MAX_DICT_LEN) { // if LZW-dictionary is not full yet
-      add_child(pContext, parentIndex, pContext->dictPos, initDictLen, pContext->pImageData[strPos + 1]); // add new LZW code to dictionary
+      if(pContext->pRowAlt) {
+        nextColor = lzw_flex_start(pContext, strPos + 1, nextColor, initDictLen);
+      }
+      add_child(pContext, parentIndex, pContext->dictPos, initDictLen, nextColor); // add new LZW code to dictionary
     } else {
       // the dictionary reached its maximum code => reset it (not required by GIF-standard but mostly done like this)
       resetDict(pContext, initDictLen);
@@ -200,6 +347,19 @@ static int lzw_crawl_tree(LZWGenState* pContext, uint32_t* pStrPos, uint16_t par
   return CGIF_OK;
 }
 
+/* double the size of the LZW data buffer (up to maxLZWData) */
+static int lzw_grow_data(LZWGenState* pContext) {
+  const uint32_t size = (pContext->sizeLZWData > pContext->maxLZWData / 2) ? pContext->maxLZWData : pContext->sizeLZWData * 2;
+  uint16_t*      pNew = realloc(pContext->pLZWData, sizeof(uint16_t) * (size_t)size);
+
+  if(pNew == NULL) {
+    return CGIF_EALLOC;
+  }
+  pContext->pLZWData    = pNew;
+  pContext->sizeLZWData = size;
+  return CGIF_OK;
+}
+
 /* generate LZW-codes that compress the image data*/
 static int lzw_generate(LZWGenState* pContext, uint16_t initDictLen) {
   uint32_t strPos;
@@ -209,7 +369,21 @@ static int lzw_generate(LZWGenState* pContext, uint16_t initDictLen) {
   strPos = 0;                                                                          // start at beginning of the image data
   resetDict(pContext, initDictLen);                                            // reset dictionary and issue clear-code at first
   while(strPos < pContext->numPixel) {                                                 // while there are still image data to be encoded
-    parentIndex  = pContext->pImageData[strPos];                                       // start at root node
+    // each step adds at most two codes (LZW code + clear code), keep one more for the termination code
+    if(pContext->LZWPos + 3 > pContext->sizeLZWData && pContext->sizeLZWData < pContext->maxLZWData) {
+      r = lzw_grow_data(pContext);
+      if(r != CGIF_OK) {
+        return r;
+      }
+    }
+    if(strPos < pContext->markPixel) {
+      pContext->LZWPosMark = pContext->LZWPos;                                         // remember LZW position (needed for the size estimation)
+    }
+    parentIndex  = lzw_get_pixel(pContext, strPos);                                    // start at root node
+    if(pContext->hasStart) {
+      parentIndex        = pContext->startColor;                                       // flexible transparency: alternative index chosen for this pixel
+      pContext->hasStart = 0;
+    }
     // get longest sequence that is still in dictionary, return new position in image data
     r = lzw_crawl_tree(pContext, &strPos, (uint16_t)parentIndex, initDictLen);
     if(r != CGIF_OK) {
@@ -297,13 +471,29 @@ static uint32_t create_byte_list_block(uint8_t *byteList, uint8_t *byteListBlock
   return numBlock *(BLOCK_SIZE + 1);                                                            // index of last entry in byteListBlock
 }
 
-/* create all LZW raster data in GIF-format */
-static int LZW_GenerateStream(LZWResult* pResult, const uint32_t numPixel, const uint8_t* pImageData, const uint16_t initDictLen, const uint8_t initCodeLen){
+/* free the LZW generation state */
+static void lzw_free_state(LZWGenState* pContext) {
+  if(pContext) {
+    free(pContext->pLZWData);
+    free(pContext->pTreeInit);
+    free(pContext->pTreeListMap);
+    free(pContext->pTreeListColor);
+    free(pContext->pTreeListIdx);
+    free(pContext->pTreeMap);
+    free(pContext->pRow);
+    free(pContext->pRowAlt);
+    free(pContext);
+  }
+}
+
+/* allocate the LZW generation state and generate the LZW codes for the given image data
+   pSrcConfig: frame given as pixel source (pImageData is not used), NULL: none */
+static int lzw_run(LZWGenState** ppContext, const uint32_t numPixel, const uint8_t* pImageData, const CGIFRaw_FrameConfig* pSrcConfig, const uint16_t initDictLen, const uint32_t markPixel) {
   LZWGenState* pContext;
-  uint32_t     lzwPos, bytePos, entriesPerCycle, maxResets;
-  uint32_t     bytePosBlock;
+  uint32_t     entriesPerCycle, maxResets;
   int          r;
   // TBD recycle LZW tree list and map (if possible) to decrease the number of allocs
+  *ppContext           = NULL;
   pContext             = malloc(sizeof(LZWGenState));
   if(pContext == NULL) {
     return CGIF_EALLOC;
@@ -312,37 +502,78 @@ static int LZW_GenerateStream(LZWResult* pResult, const uint32_t numPixel, const
   pContext->pTreeInit  = malloc((initDictLen * sizeof(uint16_t)) * initDictLen);
   if(pContext->pTreeInit == NULL) {
     r = CGIF_EALLOC;
-    goto LZWGENERATE_Cleanup;
+    goto LZWRUN_Cleanup;
   }
   pContext->pTreeListMap   = malloc(sizeof(uint16_t) * MAX_DICT_LEN);
   pContext->pTreeListColor = malloc(sizeof(uint8_t) * MAX_DICT_LEN);
   pContext->pTreeListIdx   = malloc(sizeof(uint16_t) * MAX_DICT_LEN);
   if(pContext->pTreeListMap == NULL || pContext->pTreeListColor == NULL || pContext->pTreeListIdx == NULL) {
     r = CGIF_EALLOC;
-    goto LZWGENERATE_Cleanup;
+    goto LZWRUN_Cleanup;
   }
   pContext->pTreeMap   = malloc(((MAX_DICT_LEN / 2) + 1) * (initDictLen * sizeof(uint16_t)));
   if(pContext->pTreeMap == NULL) {
     r = CGIF_EALLOC;
-    goto LZWGENERATE_Cleanup;
+    goto LZWRUN_Cleanup;
   }
   pContext->numPixel   = numPixel;
   pContext->pImageData = pImageData;
+  pContext->rowEnd     = numPixel;
+  pContext->markPixel  = markPixel;
+  if(pSrcConfig) {
+    // one row at a time instead of the whole (cropped) frame
+    pContext->pRow = malloc(pSrcConfig->width);
+    if(pContext->pRow == NULL) {
+      r = CGIF_EALLOC;
+      goto LZWRUN_Cleanup;
+    }
+    pContext->pSrcConfig = pSrcConfig;
+    pContext->pImageData = pContext->pRow;
+    pContext->rowEnd     = 0;
+    if(pSrcConfig->pSrc->isFlexTrans && pSrcConfig->pSrc->pBefImageData) {
+      pContext->pRowAlt = malloc(pSrcConfig->width);
+      if(pContext->pRowAlt == NULL) {
+        r = CGIF_EALLOC;
+        goto LZWRUN_Cleanup;
+      }
+    }
+  }
   // Buffer must hold at max (conservative upper bound): 1 initial clear + numPixel data codes + N reset clears + 1 termination
   // where N = max dictionary resets = numPixel / (MAX_DICT_LEN - initDictLen - 2)
   entriesPerCycle = MAX_DICT_LEN - initDictLen - 2; // maximum added number of dictionary entries per cycle: -2 to account for start and end code
   maxResets = numPixel / entriesPerCycle;
-  pContext->pLZWData   = malloc(sizeof(uint16_t) * ((size_t)numPixel + 2 + maxResets));
+  pContext->maxLZWData = numPixel + 2 + maxResets;
+  // most frames need far fewer codes than pixels: start small and grow on demand (see lzw_generate)
+  pContext->sizeLZWData = (pContext->maxLZWData / 8 > MAX_DICT_LEN) ? pContext->maxLZWData / 8 : pContext->maxLZWData;
+  pContext->pLZWData   = malloc(sizeof(uint16_t) * (size_t)pContext->sizeLZWData);
   if(pContext->pLZWData == NULL) {
     r = CGIF_EALLOC;
-    goto LZWGENERATE_Cleanup;
+    goto LZWRUN_Cleanup;
   }
   pContext->LZWPos     = 0;
 
   // actually generate the LZW sequence.
   r = lzw_generate(pContext, initDictLen);
   if(r != CGIF_OK) {
-    goto LZWGENERATE_Cleanup;
+    goto LZWRUN_Cleanup;
+  }
+  *ppContext = pContext;
+  return CGIF_OK;
+LZWRUN_Cleanup:
+  lzw_free_state(pContext);
+  return r;
+}
+
+/* create all LZW raster data in GIF-format */
+static int LZW_GenerateStream(LZWResult* pResult, const uint32_t numPixel, const uint8_t* pImageData, const CGIFRaw_FrameConfig* pSrcConfig, const uint16_t initDictLen, const uint8_t initCodeLen){
+  LZWGenState* pContext;
+  uint32_t     lzwPos, bytePos;
+  uint32_t     bytePosBlock;
+  int          r;
+
+  r = lzw_run(&pContext, numPixel, pImageData, pSrcConfig, initDictLen, 0);
+  if(r != CGIF_OK) {
+    return r;
   }
   lzwPos = pContext->LZWPos;
 
@@ -352,27 +583,153 @@ static int LZW_GenerateStream(LZWResult* pResult, const uint32_t numPixel, const
   uint64_t MaxByteListLen = MAX_CODE_LEN * lzwPos / 8ull + 2ull + 1ull; // conservative upper bound
   uint64_t MaxByteListBlockLen = MAX_CODE_LEN * lzwPos * (BLOCK_SIZE + 1ull) / 8ull / BLOCK_SIZE + 2ull + 1ull +1ull; // conservative upper bound
   byteList      = malloc(MaxByteListLen);
+  if(byteList == NULL) {
+    lzw_free_state(pContext);
+    return CGIF_EALLOC;
+  }
+  bytePos       = create_byte_list(byteList,lzwPos, pContext->pLZWData, initDictLen, initCodeLen);
+  lzw_free_state(pContext); // LZW codes are not needed anymore: lower peak memory
   byteListBlock = malloc(MaxByteListBlockLen);
-  if(byteList == NULL || byteListBlock == NULL) {
+  if(byteListBlock == NULL) {
     free(byteList);
-    free(byteListBlock);
-    r = CGIF_EALLOC;
-    goto LZWGENERATE_Cleanup;
+    return CGIF_EALLOC;
   }
-  bytePos       = create_byte_list(byteList,lzwPos, pContext->pLZWData, initDictLen, initCodeLen);
   bytePosBlock  = create_byte_list_block(byteList, byteListBlock, bytePos+1);
   free(byteList);
   pResult->sizeRasterData = bytePosBlock + 1; // save
   pResult->pRasterData    = byteListBlock;
-LZWGENERATE_Cleanup:
-  free(pContext->pLZWData);
-  free(pContext->pTreeInit);
-  free(pContext->pTreeListMap);
-  free(pContext->pTreeListColor);
-  free(pContext->pTreeListIdx);
-  free(pContext->pTreeMap);
-  free(pContext);
-  return r;
+  return CGIF_OK;
+}
+
+/* count the number of bits needed for the given LZW codes (same code length progression as create_byte_list) */
+static uint64_t count_code_bits(const uint16_t* lzwStr, uint32_t lzwPos, uint16_t initDictLen, uint8_t initCodeLen, uint32_t* pNumClear) {
+  uint64_t numBits    = 0;
+  uint32_t dictPos    = 1;
+  uint16_t n          = 2 * initDictLen;
+  uint8_t  lzwCodeLen = initCodeLen;
+
+  for(uint32_t i = 0; i < lzwPos; ++i) {
+    if((lzwCodeLen < MAX_CODE_LEN) && ((uint32_t)(n - (initDictLen)) == dictPos)) {
+      ++lzwCodeLen;
+      n *= 2;
+    }
+    numBits += lzwCodeLen;
+    ++dictPos;
+    if(lzwStr[i] == initDictLen) { // clear code: reset code length
+      ++(*pNumClear);
+      lzwCodeLen = initCodeLen;
+      n          = 2 * initDictLen;
+      dictPos    = 1;
+    }
+  }
+  return numBits;
+}
+
+/* number of bits needed for numCodes LZW codes, assuming that the dictionary is reset (clear code) each time it is full */
+static uint64_t calc_code_bits(uint64_t numCodes, uint16_t initDictLen, uint8_t initCodeLen) {
+  const uint32_t codesPerCycle = MAX_DICT_LEN - initDictLen - 2 + 1; // data codes + clear code per dictionary cycle
+  uint64_t       bitsPerCycle  = 0;
+  uint64_t       numBits       = 0;
+  uint64_t       numRest;
+  uint16_t       n             = 2 * initDictLen;
+  uint8_t        lzwCodeLen    = initCodeLen;
+
+  numRest = numCodes % codesPerCycle;
+  for(uint32_t dictPos = 1; dictPos <= codesPerCycle; ++dictPos) {
+    if((lzwCodeLen < MAX_CODE_LEN) && ((uint32_t)(n - (initDictLen)) == dictPos)) {
+      ++lzwCodeLen;
+      n *= 2;
+    }
+    bitsPerCycle += lzwCodeLen;
+    if(dictPos == numRest) {
+      numBits = bitsPerCycle; // bits of the last (incomplete) cycle
+    }
+  }
+  return numBits + (numCodes / codesPerCycle) * bitsPerCycle;
+}
+
+/* estimate the size of the LZW raster data (incl. sub-block structure) by encoding a sample of row stripes
+   pSrcConfig: frame given as pixel source (pImageData is not used), NULL: none */
+static int LZW_EstimateStream(uint32_t* pSize, const uint16_t width, const uint16_t height, const uint8_t* pImageData, const CGIFRaw_FrameConfig* pSrcConfig, const uint16_t initDictLen, const uint8_t initCodeLen) {
+  LZWGenState*   pContext;
+  uint8_t*       pSample;
+  const uint8_t* pData;
+  uint64_t       numBits, numBytes;
+  double         numCodes, growth, pixelsPerCycle;
+  uint32_t       numSample, numClear;
+  const uint32_t numPixel = MULU16(width, height);
+  const uint32_t codesPerCycle = MAX_DICT_LEN - initDictLen - 2 + 1;
+  int            r;
+
+  pSample = NULL;
+  if((numPixel <= EST_MAX_FULL_PIXEL || height <= EST_STRIPE_ROWS * EST_SAMPLE_RATE) && pSrcConfig) {
+    // small frame: the exact LZW sequence is cheap enough (read all rows of the pixel source)
+    pSample = malloc(numPixel);
+    if(pSample == NULL) {
+      return CGIF_EALLOC;
+    }
+    for(uint32_t y = 0; y < height; ++y) {
+      readSrcRow(pSrcConfig, y, pSample + MULU16(y, width));
+    }
+    pData     = pSample;
+    numSample = numPixel;
+  } else if(numPixel <= EST_MAX_FULL_PIXEL || height <= EST_STRIPE_ROWS * EST_SAMPLE_RATE) {
+    // small frame: the exact LZW sequence is cheap enough
+    pData     = pImageData;
+    numSample = numPixel;
+  } else {
+    // take every EST_SAMPLE_RATE-th stripe of EST_STRIPE_ROWS rows.
+    // the stripes keep the horizontal and (short range) vertical correlation the LZW dictionary builds on.
+    pSample = malloc(numPixel / EST_SAMPLE_RATE + (uint32_t)width * EST_STRIPE_ROWS);
+    if(pSample == NULL) {
+      return CGIF_EALLOC;
+    }
+    numSample = 0;
+    for(uint32_t y = 0; y < height; y += EST_STRIPE_ROWS * EST_SAMPLE_RATE) {
+      const uint32_t numRows = (height - y < EST_STRIPE_ROWS) ? height - y : EST_STRIPE_ROWS;
+      if(pSrcConfig) {
+        for(uint32_t i = 0; i < numRows; ++i) {
+          readSrcRow(pSrcConfig, y + i, pSample + numSample + i * width);
+        }
+      } else {
+        memcpy(pSample + numSample, pImageData + MULU16(y, width), numRows * width);
+      }
+      numSample += numRows * width;
+    }
+    pData = pSample;
+  }
+  r = lzw_run(&pContext, numSample, pData, NULL, initDictLen, numSample / 2);
+  free(pSample);
+  if(r != CGIF_OK) {
+    return r;
+  }
+  numClear = 0;
+  numBits  = count_code_bits(pContext->pLZWData, pContext->LZWPos, initDictLen, initCodeLen, &numClear);
+  // scale up to the full frame:
+  // the number of codes grows linearly with the number of pixels once the dictionary is reset regularly,
+  // but sub-linearly for highly redundant data as long as the dictionary is not full (LZW strings keep on growing).
+  // in that case, the growth exponent is taken from the codes needed for the first half and the whole sample.
+  if(numSample < numPixel) {
+    if(numClear == 1 && pContext->LZWPosMark && pContext->LZWPos > pContext->LZWPosMark) {
+      growth         = log((double)pContext->LZWPos / pContext->LZWPosMark) / log(2.0);
+      growth         = (growth < 0.5) ? 0.5 : (growth > 1.0) ? 1.0 : growth;
+      pixelsPerCycle = numSample * pow((double)codesPerCycle / pContext->LZWPos, 1.0 / growth);
+      if(numPixel <= pixelsPerCycle) {
+        numCodes = pContext->LZWPos * pow((double)numPixel / numSample, growth);
+      } else {
+        numCodes = codesPerCycle * (numPixel / pixelsPerCycle);
+      }
+      numBits = calc_code_bits((uint64_t)numCodes, initDictLen, initCodeLen);
+    } else {
+      numBits = numBits * numPixel / numSample;
+    }
+  }
+  lzw_free_state(pContext);
+  numBytes = (numBits + 7) / 8;
+  // add one length byte per sub-block and the block terminator
+  numBytes += (numBytes + BLOCK_SIZE - 1) / BLOCK_SIZE + 1;
+  *pSize = (numBytes > UINT32_MAX) ? UINT32_MAX : (uint32_t)numBytes;
+  return CGIF_OK;
 }
 
 /* initialize the header of the GIF */
@@ -442,15 +799,45 @@ static void initAppExtBlock(uint8_t* pAppExt, uint16_t numLoops) {
   memcpy(pAppExt + APPEXT_NETSCAPE_OFFSET_LOOPS, &netscapeLE, sizeof(uint16_t));
 }
 
-/* write numBytes dummy bytes */
-static int writeDummyBytes(cgif_write_fn* pWriteFn, void* pContext, int numBytes) {
-  int rWrite              = 0;
-  const uint8_t dummyByte = 0;
+/* memory output: make room for numBytes more bytes (the buffer doubles until they fit). returns 0 on success or -1 on error. */
+static int reserveOutput(CGIFRaw* pGIF, size_t numBytes) {
+  uint8_t* pNew;
+  size_t   capNew;
+
+  if(pGIF->sizeOutput + numBytes <= pGIF->capOutput) {
+    return 0;
+  }
+  capNew = pGIF->capOutput;
+  while(capNew < pGIF->sizeOutput + numBytes) {
+    capNew *= 2;
+  }
+  pNew = realloc(pGIF->pOutput, capNew);
+  if(pNew == NULL) {
+    return -1;
+  }
+  pGIF->pOutput   = pNew;
+  pGIF->capOutput = capNew;
+  return 0;
+}
 
-  for(int i = 0; i < numBytes; ++i) {
-    rWrite |= pWriteFn(pContext, &dummyByte, 1);
+/* write output data: appended to the memory output or passed to pWriteFn. returns 0 on success or -1 on error. */
+static int writeOutput(CGIFRaw* pGIF, const uint8_t* pData, size_t numBytes) {
+  if(pGIF->config.attrFlags & CGIF_RAW_ATTR_MEMORY_OUTPUT) {
+    if(reserveOutput(pGIF, numBytes)) {
+      return -1;
+    }
+    memcpy(pGIF->pOutput + pGIF->sizeOutput, pData, numBytes);
+    pGIF->sizeOutput += numBytes;
+    return 0;
   }
-  return rWrite;
+  return pGIF->config.pWriteFn(pGIF->config.pContext, pData, numBytes);
+}
+
+/* write numBytes dummy bytes (padding of a color table, less than 256 * 3 bytes) */
+static int writeDummyBytes(CGIFRaw* pGIF, int numBytes) {
+  static const uint8_t aDummyBytes[256 * 3] = {0};
+
+  return (numBytes) ? writeOutput(pGIF, aDummyBytes, numBytes) : 0;
 }
 
 CGIFRaw* cgif_raw_newgif(const CGIFRaw_Config* pConfig) {
@@ -467,29 +854,45 @@ CGIFRaw* cgif_raw_newgif(const CGIFRaw_Config* pConfig) {
     return NULL;
   }
   memcpy(&(pGIF->config), pConfig, sizeof(CGIFRaw_Config));
+  pGIF->pOutput    = NULL;
+  pGIF->sizeOutput = 0;
+  pGIF->capOutput  = 0;
+  pGIF->isFinished = 0;
+  // memory output: start with the size hint (default: headers + one frame of width x height bytes, up to MAX_OUTPUT_HINT)
+  if(pConfig->attrFlags & CGIF_RAW_ATTR_MEMORY_OUTPUT) {
+    const uint32_t numPixel = MULU16(pConfig->width, pConfig->height);
+    const size_t   sizeHint = (pConfig->sizeOutputHint) ? pConfig->sizeOutputHint : SIZE_MAIN_HEADER + 256 * 3 + SIZE_APP_EXT + ((numPixel < MAX_OUTPUT_HINT) ? numPixel : MAX_OUTPUT_HINT);
+    pGIF->pOutput = malloc(sizeHint);
+    if(pGIF->pOutput == NULL) {
+      free(pGIF);
+      return NULL;
+    }
+    pGIF->capOutput = sizeHint;
+  }
   // initiate all sections we can at this stage:
   // - main GIF header
   // - global color table (GCT), if required
   // - netscape application extension (for animation), if required
   initMainHeader(pConfig, aHeader);
-  rWrite = pConfig->pWriteFn(pConfig->pContext, aHeader, SIZE_MAIN_HEADER);
+  rWrite = writeOutput(pGIF, aHeader, SIZE_MAIN_HEADER);
 
   // GCT required? => write it.
   if(pConfig->sizeGCT) {
-    rWrite |= pConfig->pWriteFn(pConfig->pContext, pConfig->pGCT, pConfig->sizeGCT * 3);
+    rWrite |= writeOutput(pGIF, pConfig->pGCT, pConfig->sizeGCT * 3);
     uint8_t pow2GCT             = calcNextPower2Ex(pConfig->sizeGCT);
     pow2GCT                     = (pow2GCT < 1) ? 1 : pow2GCT; // minimum size is 2^1
     const uint16_t numBytesLeft = ((1 << pow2GCT) - pConfig->sizeGCT) * 3;
-    rWrite |= writeDummyBytes(pConfig->pWriteFn, pConfig->pContext, numBytesLeft);
+    rWrite |= writeDummyBytes(pGIF, numBytesLeft);
   }
   // GIF should be animated? => init & write app extension header ("NETSCAPE2.0")
   // No loop? Don't write NETSCAPE extension.
   if((pConfig->attrFlags & CGIF_RAW_ATTR_IS_ANIMATED) && !(pConfig->attrFlags & CGIF_RAW_ATTR_NO_LOOP)) {
     initAppExtBlock(aAppExt, pConfig->numLoops);
-    rWrite |= pConfig->pWriteFn(pConfig->pContext, aAppExt, SIZE_APP_EXT);
+    rWrite |= writeOutput(pGIF, aAppExt, SIZE_APP_EXT);
   }
   // check for write errors
   if(rWrite) {
+    free(pGIF->pOutput);
     free(pGIF);
     return NULL;
   }
@@ -500,71 +903,43 @@ CGIFRaw* cgif_raw_newgif(const CGIFRaw_Config* pConfig) {
   return pGIF;
 }
 
-/* add new frame to the raw GIF stream */
-cgif_result cgif_raw_addframe(CGIFRaw* pGIF, const CGIFRaw_FrameConfig* pConfig) {
-  uint8_t    aFrameHeader[SIZE_FRAME_HEADER];
-  uint8_t    aGraphicExt[SIZE_GRAPHIC_EXT];
+/* compute the initial LZW code length needed for the given frame */
+static uint8_t calcFrameInitCodeLen(const CGIFRaw* pGIF, const CGIFRaw_FrameConfig* pConfig) {
+  uint16_t numEffColors; // number of effective colors
+
+  numEffColors = (pConfig->sizeLCT) ? pConfig->sizeLCT : pGIF->config.sizeGCT; // local or global color table in use
+  // transparency in use? we might need to increase numEffColors
+  if((pGIF->config.attrFlags & (CGIF_RAW_ATTR_IS_ANIMATED)) && (pConfig->attrFlags & (CGIF_RAW_FRAME_ATTR_HAS_TRANS)) && pConfig->transIndex >= numEffColors) {
+    numEffColors = pConfig->transIndex + 1;
+  }
+  return calcInitCodeLen(numEffColors);
+}
+
+/* LZW-encode a frame without writing it (pGIF is not modified, so this function might be called from multiple threads at the same time) */
+cgif_result cgif_raw_encodeframe(const CGIFRaw* pGIF, const CGIFRaw_FrameConfig* pConfig, CGIFRaw_EncFrame* pEncFrame) {
   LZWResult  encResult;
-  int        r, rWrite;
-  const int  useLCT = pConfig->sizeLCT; // LCT stands for "local color table"
+  int        r;
   const int  isInterlaced = (pConfig->attrFlags & CGIF_RAW_FRAME_ATTR_INTERLACED) ? 1 : 0;
-  uint16_t   numEffColors; // number of effective colors
   uint16_t   initDictLen;
-  uint8_t    pow2LCT, initCodeLen;
+  uint8_t    initCodeLen;
 
-  if(pGIF->curResult != CGIF_OK && pGIF->curResult != CGIF_PENDING) {
-    return pGIF->curResult; // return previous error
-  }
   // check for invalid LCT size
   if(pConfig->sizeLCT > 256) {
-    pGIF->curResult = CGIF_ERROR; // invalid LCT size
-    return pGIF->curResult;
-  }
-
-  rWrite = 0;
-  // set frame header to a clean state
-  memset(aFrameHeader, 0, SIZE_FRAME_HEADER);
-  // set needed fields in frame header
-  aFrameHeader[0] = ','; // set frame seperator
-  if(useLCT) {
-    pow2LCT = calcNextPower2Ex(pConfig->sizeLCT);
-    pow2LCT = (pow2LCT < 1) ? 1 : pow2LCT; // minimum size is 2^1
-    IMAGE_PACKED_FIELD(aFrameHeader)  = (1 << 7);
-    // set size of local color table (0-7 in header + 1)
-    IMAGE_PACKED_FIELD(aFrameHeader) |= ((pow2LCT- 1) << 0);
-    numEffColors = pConfig->sizeLCT;
-  } else {
-    numEffColors = pGIF->config.sizeGCT; // global color table in use
+    return CGIF_ERROR; // invalid LCT size
   }
-  // encode frame interlaced?
-  IMAGE_PACKED_FIELD(aFrameHeader) |= (isInterlaced << 6);
-
-  // transparency in use? we might need to increase numEffColors
-  if((pGIF->config.attrFlags & (CGIF_RAW_ATTR_IS_ANIMATED)) && (pConfig->attrFlags & (CGIF_RAW_FRAME_ATTR_HAS_TRANS)) && pConfig->transIndex >= numEffColors) {
-    numEffColors = pConfig->transIndex + 1;
-  }
-
   // calculate initial code length and initial dict length
-  initCodeLen = calcInitCodeLen(numEffColors);
+  initCodeLen = calcFrameInitCodeLen(pGIF, pConfig);
   initDictLen = 1uL << (initCodeLen - 1);
-  const uint8_t initialCodeSize = initCodeLen - 1;
-
-  const uint16_t frameWidthLE  = hU16toLE(pConfig->width);
-  const uint16_t frameHeightLE = hU16toLE(pConfig->height);
-  const uint16_t frameTopLE    = hU16toLE(pConfig->top);
-  const uint16_t frameLeftLE   = hU16toLE(pConfig->left);
-  memcpy(aFrameHeader + IMAGE_OFFSET_WIDTH,  &frameWidthLE,  sizeof(uint16_t));
-  memcpy(aFrameHeader + IMAGE_OFFSET_HEIGHT, &frameHeightLE, sizeof(uint16_t));
-  memcpy(aFrameHeader + IMAGE_OFFSET_TOP,    &frameTopLE,    sizeof(uint16_t));
-  memcpy(aFrameHeader + IMAGE_OFFSET_LEFT,   &frameLeftLE,   sizeof(uint16_t));
   // apply interlaced pattern
   // TBD creating a copy of pImageData is not ideal, but changes on the LZW encoding would
   // be necessary otherwise.
-  if(isInterlaced) {
+  if(pConfig->pSrc) {
+    // rows are read from the pixel source while encoding (in interlaced order, if required)
+    r = LZW_GenerateStream(&encResult, MULU16(pConfig->width, pConfig->height), NULL, pConfig, initDictLen, initCodeLen);
+  } else if(isInterlaced) {
     uint8_t* pInterlaced = malloc(MULU16(pConfig->width, pConfig->height));
     if(pInterlaced == NULL) {
-      pGIF->curResult = CGIF_EALLOC;
-      return pGIF->curResult;
+      return CGIF_EALLOC;
     }
     uint8_t* p = pInterlaced;
     // every 8th row (starting with row 0)
@@ -587,22 +962,103 @@ cgif_result cgif_raw_addframe(CGIFRaw* pGIF, const CGIFRaw_FrameConfig* pConfig)
       memcpy(p, pConfig->pImageData + i * pConfig->width, pConfig->width);
       p += pConfig->width;
     }
-    r = LZW_GenerateStream(&encResult, MULU16(pConfig->width, pConfig->height), pInterlaced, initDictLen, initCodeLen);
+    r = LZW_GenerateStream(&encResult, MULU16(pConfig->width, pConfig->height), pInterlaced, NULL, initDictLen, initCodeLen);
     free(pInterlaced);
   } else {
-    r = LZW_GenerateStream(&encResult, MULU16(pConfig->width, pConfig->height), pConfig->pImageData, initDictLen, initCodeLen);
+    r = LZW_GenerateStream(&encResult, MULU16(pConfig->width, pConfig->height), pConfig->pImageData, NULL, initDictLen, initCodeLen);
   }
-
-  // generate LZW raster data (actual image data)
   // check for errors
   if(r != CGIF_OK) {
-    pGIF->curResult = r;
     return r;
   }
+  pEncFrame->pRasterData    = encResult.pRasterData;
+  pEncFrame->sizeRasterData = encResult.sizeRasterData;
+  pEncFrame->initCodeLen    = initCodeLen;
+  return CGIF_OK;
+}
+
+/* estimate the size of the LZW raster data of a frame at a fraction of the cost of cgif_raw_encodeframe() (the interlaced pattern is not taken into account) */
+cgif_result cgif_raw_estimateframe(const CGIFRaw* pGIF, const CGIFRaw_FrameConfig* pConfig, uint32_t* pSize) {
+  uint8_t initCodeLen;
+
+  // check for invalid LCT size
+  if(pConfig->sizeLCT > 256) {
+    return CGIF_ERROR; // invalid LCT size
+  }
+  initCodeLen = calcFrameInitCodeLen(pGIF, pConfig);
+  return LZW_EstimateStream(pSize, pConfig->width, pConfig->height, pConfig->pImageData, (pConfig->pSrc) ? pConfig : NULL, 1uL << (initCodeLen - 1), initCodeLen);
+}
+
+/* estimate the size of the LZW raster data for image data with numColors colors (see cgif_raw_estimateframe) */
+cgif_result cgif_raw_estimatesize(const uint8_t* pImageData, uint16_t width, uint16_t height, uint16_t numColors, uint32_t* pSize) {
+  uint8_t initCodeLen;
+
+  if(numColors > 256 || !width || !height) {
+    return CGIF_ERROR;
+  }
+  initCodeLen = calcInitCodeLen(numColors);
+  return LZW_EstimateStream(pSize, width, height, pImageData, NULL, 1uL << (initCodeLen - 1), initCodeLen);
+}
+
+/* free the raster data of an encoded frame that is not written */
+void cgif_raw_freeframe(CGIFRaw_EncFrame* pEncFrame) {
+  free(pEncFrame->pRasterData);
+  pEncFrame->pRasterData    = NULL;
+  pEncFrame->sizeRasterData = 0;
+}
+
+/* write a frame encoded by cgif_raw_encodeframe() to the raw GIF stream (frees the raster data of pEncFrame) */
+cgif_result cgif_raw_writeframe(CGIFRaw* pGIF, const CGIFRaw_FrameConfig* pConfig, CGIFRaw_EncFrame* pEncFrame) {
+  uint8_t    aFrameHeader[SIZE_FRAME_HEADER];
+  uint8_t    aGraphicExt[SIZE_GRAPHIC_EXT];
+  int        rWrite;
+  const int  useLCT = pConfig->sizeLCT; // LCT stands for "local color table"
+  const int  isInterlaced = (pConfig->attrFlags & CGIF_RAW_FRAME_ATTR_INTERLACED) ? 1 : 0;
+  uint8_t    pow2LCT = 0;
+
+  if(pGIF->curResult != CGIF_OK && pGIF->curResult != CGIF_PENDING) {
+    cgif_raw_freeframe(pEncFrame);
+    return pGIF->curResult; // return previous error
+  }
+  if(pGIF->isFinished) {
+    cgif_raw_freeframe(pEncFrame);
+    return CGIF_ERROR; // error: output handed over already
+  }
+
+  rWrite = 0;
+  // set frame header to a clean state
+  memset(aFrameHeader, 0, SIZE_FRAME_HEADER);
+  // set needed fields in frame header
+  aFrameHeader[0] = ','; // set frame seperator
+  if(useLCT) {
+    pow2LCT = calcNextPower2Ex(pConfig->sizeLCT);
+    pow2LCT = (pow2LCT < 1) ? 1 : pow2LCT; // minimum size is 2^1
+    IMAGE_PACKED_FIELD(aFrameHeader)  = (1 << 7);
+    // set size of local color table (0-7 in header + 1)
+    IMAGE_PACKED_FIELD(aFrameHeader) |= ((pow2LCT- 1) << 0);
+  }
+  // encode frame interlaced?
+  IMAGE_PACKED_FIELD(aFrameHeader) |= (isInterlaced << 6);
+  const uint8_t initialCodeSize = pEncFrame->initCodeLen - 1;
+
+  const uint16_t frameWidthLE  = hU16toLE(pConfig->width);
+  const uint16_t frameHeightLE = hU16toLE(pConfig->height);
+  const uint16_t frameTopLE    = hU16toLE(pConfig->top);
+  const uint16_t frameLeftLE   = hU16toLE(pConfig->left);
+  memcpy(aFrameHeader + IMAGE_OFFSET_WIDTH,  &frameWidthLE,  sizeof(uint16_t));
+  memcpy(aFrameHeader + IMAGE_OFFSET_HEIGHT, &frameHeightLE, sizeof(uint16_t));
+  memcpy(aFrameHeader + IMAGE_OFFSET_TOP,    &frameTopLE,    sizeof(uint16_t));
+  memcpy(aFrameHeader + IMAGE_OFFSET_LEFT,   &frameLeftLE,   sizeof(uint16_t));
 
   // check whether the Graphic Control Extension is required or not:
   // It's required for animations and frames with transparency.
   int needsGraphicCtrlExt = (pGIF->config.attrFlags & CGIF_RAW_ATTR_IS_ANIMATED) | (pConfig->attrFlags & CGIF_RAW_FRAME_ATTR_HAS_TRANS);
+  // memory output: grow the buffer once per frame (the headers and the encoded LZW data are copied into it below)
+  if((pGIF->config.attrFlags & CGIF_RAW_ATTR_MEMORY_OUTPUT) && reserveOutput(pGIF, ((needsGraphicCtrlExt) ? SIZE_GRAPHIC_EXT : 0) + SIZE_FRAME_HEADER + ((useLCT) ? (3uL << pow2LCT) : 0) + 1 + pEncFrame->sizeRasterData)) {
+    pGIF->curResult = CGIF_EALLOC;
+    cgif_raw_freeframe(pEncFrame);
+    return pGIF->curResult;
+  }
   // do things for animation / transparency, if required.
   if(needsGraphicCtrlExt) {
     memset(aGraphicExt, 0, SIZE_GRAPHIC_EXT);
@@ -619,18 +1075,18 @@ cgif_result cgif_raw_addframe(CGIFRaw* pGIF, const CGIFRaw_FrameConfig* pConfig)
     const uint16_t delayLE = hU16toLE(pConfig->delay);
     memcpy(aGraphicExt + GEXT_OFFSET_DELAY, &delayLE, sizeof(uint16_t));
     // write Graphic Control Extension
-    rWrite |= pGIF->config.pWriteFn(pGIF->config.pContext, aGraphicExt, SIZE_GRAPHIC_EXT);
+    rWrite |= writeOutput(pGIF, aGraphicExt, SIZE_GRAPHIC_EXT);
   }
 
   // write frame
-  rWrite |= pGIF->config.pWriteFn(pGIF->config.pContext, aFrameHeader, SIZE_FRAME_HEADER);
+  rWrite |= writeOutput(pGIF, aFrameHeader, SIZE_FRAME_HEADER);
   if(useLCT) {
-    rWrite |= pGIF->config.pWriteFn(pGIF->config.pContext, pConfig->pLCT, pConfig->sizeLCT * 3);
+    rWrite |= writeOutput(pGIF, pConfig->pLCT, pConfig->sizeLCT * 3);
     const uint16_t numBytesLeft = ((1 << pow2LCT) - pConfig->sizeLCT) * 3;
-    rWrite |= writeDummyBytes(pGIF->config.pWriteFn, pGIF->config.pContext, numBytesLeft);
+    rWrite |= writeDummyBytes(pGIF, numBytesLeft);
   }
-  rWrite |= pGIF->config.pWriteFn(pGIF->config.pContext, &initialCodeSize, 1);
-  rWrite |= pGIF->config.pWriteFn(pGIF->config.pContext, encResult.pRasterData, encResult.sizeRasterData);
+  rWrite |= writeOutput(pGIF, &initialCodeSize, 1);
+  rWrite |= writeOutput(pGIF, pEncFrame->pRasterData, pEncFrame->sizeRasterData);
 
   // check for write errors
   if(rWrite) {
@@ -639,20 +1095,59 @@ cgif_result cgif_raw_addframe(CGIFRaw* pGIF, const CGIFRaw_FrameConfig* pConfig)
     pGIF->curResult = CGIF_OK;
   }
   // cleanup
-  free(encResult.pRasterData);
+  cgif_raw_freeframe(pEncFrame);
   return pGIF->curResult;
 }
 
+/* add new frame to the raw GIF stream */
+cgif_result cgif_raw_addframe(CGIFRaw* pGIF, const CGIFRaw_FrameConfig* pConfig) {
+  CGIFRaw_EncFrame encFrame;
+  cgif_result      r;
+
+  if(pGIF->curResult != CGIF_OK && pGIF->curResult != CGIF_PENDING) {
+    return pGIF->curResult; // return previous error
+  }
+  // generate LZW raster data (actual image data)
+  r = cgif_raw_encodeframe(pGIF, pConfig, &encFrame);
+  // check for errors
+  if(r != CGIF_OK) {
+    pGIF->curResult = r;
+    return r;
+  }
+  return cgif_raw_writeframe(pGIF, pConfig, &encFrame);
+}
+
+/* write the trailer of the GIF (once) */
+static void writeTrailer(CGIFRaw* pGIF) {
+  if(!pGIF->isFinished && writeOutput(pGIF, (const uint8_t*) ";", 1)) { // write term symbol
+    pGIF->curResult = (pGIF->config.attrFlags & CGIF_RAW_ATTR_MEMORY_OUTPUT) ? CGIF_EALLOC : CGIF_EWRITE;
+  }
+  pGIF->isFinished = 1;
+}
+
+/* memory output: write the trailer and hand the output data over to the caller (no copy). the data is kept (and freed by cgif_raw_close) on error */
+cgif_result cgif_raw_takeoutput(CGIFRaw* pGIF, uint8_t** ppData, size_t* pSize) {
+  *ppData = NULL;
+  *pSize  = 0;
+  if(!(pGIF->config.attrFlags & CGIF_RAW_ATTR_MEMORY_OUTPUT) || pGIF->pOutput == NULL) {
+    return CGIF_ERROR; // error: no memory output or handed over already
+  }
+  writeTrailer(pGIF);
+  if(pGIF->curResult != CGIF_OK) {
+    return pGIF->curResult;
+  }
+  *ppData       = pGIF->pOutput;
+  *pSize        = pGIF->sizeOutput;
+  pGIF->pOutput = NULL;
+  return CGIF_OK;
+}
+
 cgif_result cgif_raw_close(CGIFRaw* pGIF) {
-  int         rWrite;
   cgif_result result;
 
-  rWrite = pGIF->config.pWriteFn(pGIF->config.pContext, (unsigned char*) ";", 1); // write term symbol
-  // check for write errors
-  if(rWrite) {
-    pGIF->curResult = CGIF_EWRITE;
-  }
+  writeTrailer(pGIF);
   result = pGIF->curResult;
+  free(pGIF->pOutput);
   free(pGIF);
   return result;
 }
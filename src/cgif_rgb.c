@@ -374,14 +374,16 @@ static treeNode* create_decision_tree(uint8_t* pPalette,  uint32_t* pFrequDense,
 }
 
 /* get image with max 256 color indices using Floyd-Steinberg dithering */
-static void get_quantized_dithered_image(uint8_t* pImageData, float* pImageDataRGBfloat, uint8_t* pPalette256, treeNode* root, uint32_t numPixel, uint32_t width, uint8_t dithering, uint8_t transIndex, cgif_chan_fmt fmtChan, uint8_t* pBef, cgif_chan_fmt befFmtChan, int hasAlpha) {
+static void get_quantized_dithered_image(uint8_t* pImageData, const uint8_t* pImageDataRGB, float* pRowsRGBfloat, uint8_t* pPalette256, treeNode* root, uint32_t numPixel, uint32_t width, uint8_t dithering, uint8_t transIndex, cgif_chan_fmt fmtChan, uint8_t* pBef, cgif_chan_fmt befFmtChan, int hasAlpha) {
   // pImageData: image with (max 256) color indices (length: numPixel)
-  // pImageDataRGBfloat: image with RGB colors (length: 3*numPixel) must be signed to avoid overflow due to error passing, float only needed because of 0.9 factor
+  // pImageDataRGB: image with RGB colors (length: fmtChan*numPixel)
+  // pRowsRGBfloat: rolling buffer of 3 rows with RGB colors + passed errors (length: 3*3*width), must be signed to avoid overflow due to error passing, float only needed because of 0.9 factor
   // pPalette256: quantized color palette (indexed by node->colIdx), only used if dithering is on
   // root: root node of the decision tree for color quantization
   // numPixel, width: size of the image
   // dithering: 0 (no dithering), 1: Floyd-Steinberg dithering, else: Sierra dithering
-  uint32_t i;
+  const uint32_t height = numPixel / width;
+  uint32_t i, x, y;
   uint8_t k;
   int err; // color errors
   /*
@@ -391,83 +393,103 @@ static void get_quantized_dithered_image(uint8_t* pImageData, float* pImageDataR
   const double factor = 0.90; // Has to be a double to force double-precision arithmetic - otherwise we might get rounding specific differences between platforms (eg. macOS Clang)
   if(!dithering) {
     for(i = 0; i < numPixel; ++i) {
+      float rgb[3];
       if(hasAlpha) {
-        if(pImageDataRGBfloat[fmtChan * i + 3] == 0) {
+        if(pImageDataRGB[fmtChan * i + 3] == 0) {
           pImageData[i] = transIndex;
           continue;
         }
       } else {
         // do the transparency trick
-        float* p = pImageDataRGBfloat;
-        if(pBef && p[i * fmtChan] == pBef[i * befFmtChan] && p[i * fmtChan + 1] == pBef[i * befFmtChan + 1] && p[i * fmtChan + 2] == pBef[i * befFmtChan + 2]) {
+        if(pBef && memcmp(&pImageDataRGB[fmtChan * i], &pBef[befFmtChan * i], 3) == 0) {
           pImageData[i] = transIndex;
           continue;
         }
       }
-      pImageData[i] = get_leave_node_index(root, &pImageDataRGBfloat[fmtChan * i]);  // use decision tree to get indices for new colors
+      for(k = 0; k < 3; ++k) {
+        rgb[k] = pImageDataRGB[fmtChan * i + k];
+      }
+      pImageData[i] = get_leave_node_index(root, rgb);  // use decision tree to get indices for new colors
     }
   } else {
-    for(i = 0; i < numPixel; ++i) {
-      if(fmtChan == CGIF_CHAN_FMT_RGBA) {
-        if(pImageDataRGBfloat[fmtChan * i + 3] == 0) {
-          pImageData[i] = transIndex;
-          continue;
+    // errors are passed up to two rows ahead: only the current row and the next two rows are kept (row y in pRowsRGBfloat + 3 * width * (y % 3))
+    for(y = 0; y < height && y < 2; ++y) {
+      for(x = 0; x < 3 * width; ++x) {
+        pRowsRGBfloat[3 * width * y + x] = pImageDataRGB[fmtChan * (y * width + x / 3) + x % 3];
+      }
+    }
+    for(y = 0; y < height; ++y) {
+      float* pRow0 = pRowsRGBfloat + 3 * width * (y % 3);       // current row
+      float* pRow1 = pRowsRGBfloat + 3 * width * ((y + 1) % 3); // next row
+      float* pRow2 = pRowsRGBfloat + 3 * width * ((y + 2) % 3); // row after next
+      if(y + 2 < height) {
+        for(x = 0; x < 3 * width; ++x) {
+          pRow2[x] = pImageDataRGB[fmtChan * ((y + 2) * width + x / 3) + x % 3];
         }
       }
-      // TBD add the transparency trick
+      for(x = 0; x < width; ++x) {
+        i = y * width + x;
+        if(fmtChan == CGIF_CHAN_FMT_RGBA) {
+          if(pImageDataRGB[fmtChan * i + 3] == 0) {
+            pImageData[i] = transIndex;
+            continue;
+          }
+        }
+        // TBD add the transparency trick
 
-      // restrict color + error to 0-255 interval
-      for(k = 0; k<3; ++k) {
-        pImageDataRGBfloat[fmtChan * i + k] = MAX(0,MIN(pImageDataRGBfloat[fmtChan * i + k], 255)); // cut to 0-255 before
-      }
+        // restrict color + error to 0-255 interval
+        for(k = 0; k<3; ++k) {
+          pRow0[3 * x + k] = MAX(0,MIN(pRow0[3 * x + k], 255)); // cut to 0-255 before
+        }
 
-      pImageData[i] = get_leave_node_index(root, &pImageDataRGBfloat[fmtChan * i]);  // use decision tree to get indices for new colors
-      for(k = 0; k<3; ++k) {
-        err = pImageDataRGBfloat[fmtChan * i + k] - pPalette256[3 * pImageData[i] + k]; // compute color error
+        pImageData[i] = get_leave_node_index(root, &pRow0[3 * x]);  // use decision tree to get indices for new colors
+        for(k = 0; k<3; ++k) {
+          err = pRow0[3 * x + k] - pPalette256[3 * pImageData[i] + k]; // compute color error
 
-        //diffuse error with Floyd-Steinberg dithering.
-        if(dithering == 1) {
-          if(i % width < width-1){
-            pImageDataRGBfloat[fmtChan * (i+1) + k] += factor * (7*err >> 4);
-          }
-          if(i < numPixel - width){
-            pImageDataRGBfloat[fmtChan * (i+width) + k] += factor * (5*err >> 4);
-            if(i % width > 0){
-              pImageDataRGBfloat[fmtChan * (i+width-1) + k] += factor * (3*err >> 4);
+          //diffuse error with Floyd-Steinberg dithering.
+          if(dithering == 1) {
+            if(x < width-1){
+              pRow0[3 * (x+1) + k] += factor * (7*err >> 4);
             }
-            if(i % width < width-1){
-              pImageDataRGBfloat[fmtChan * (i+width+1) + k] += factor * (1*err >> 4);
-            }
-          }
-        } else {
-          // Sierra dithering
-          if(i % width < width-1){
-            pImageDataRGBfloat[fmtChan * (i+1) + k] += factor * (5*err >> 5);
-            if(i % width < width-2){
-              pImageDataRGBfloat[fmtChan * (i+2) + k] += factor * (3*err >> 5);
-            }
-          }
-          if(i < numPixel - width){
-            pImageDataRGBfloat[fmtChan * (i+width) + k] += factor * (5*err >> 5);
-            if(i % width > 0){
-              pImageDataRGBfloat[fmtChan * (i+width-1) + k] += factor * (4*err >> 5);
-              if(i % width > 1){
-                pImageDataRGBfloat[fmtChan * (i+width-2) + k] += factor * (2*err >> 5);
+            if(y < height-1){
+              pRow1[3 * x + k] += factor * (5*err >> 4);
+              if(x > 0){
+                pRow1[3 * (x-1) + k] += factor * (3*err >> 4);
+              }
+              if(x < width-1){
+                pRow1[3 * (x+1) + k] += factor * (1*err >> 4);
               }
             }
-            if(i % width < width-1){
-              pImageDataRGBfloat[fmtChan * (i+width+1) + k] += factor * (4*err >> 5);
-              if(i % width < width-2){
-                pImageDataRGBfloat[fmtChan * (i+width+2) + k] += factor * (2*err >> 5);
+          } else {
+            // Sierra dithering
+            if(x < width-1){
+              pRow0[3 * (x+1) + k] += factor * (5*err >> 5);
+              if(x < width-2){
+                pRow0[3 * (x+2) + k] += factor * (3*err >> 5);
               }
             }
-            if(i < numPixel - 2*width){
-              pImageDataRGBfloat[fmtChan * (i+2*width) + k] += factor * (3*err >> 5);
-              if(i % width > 0){
-                pImageDataRGBfloat[fmtChan * (i+2*width-1) + k] += factor * (2*err >> 5);
+            if(y < height-1){
+              pRow1[3 * x + k] += factor * (5*err >> 5);
+              if(x > 0){
+                pRow1[3 * (x-1) + k] += factor * (4*err >> 5);
+                if(x > 1){
+                  pRow1[3 * (x-2) + k] += factor * (2*err >> 5);
+                }
+              }
+              if(x < width-1){
+                pRow1[3 * (x+1) + k] += factor * (4*err >> 5);
+                if(x < width-2){
+                  pRow1[3 * (x+2) + k] += factor * (2*err >> 5);
+                }
               }
-              if(i % width < width-1){
-                pImageDataRGBfloat[fmtChan * (i+2*width+1) + k] += factor * (2*err >> 5);
+              if(y < height-2){
+                pRow2[3 * x + k] += factor * (3*err >> 5);
+                if(x > 0){
+                  pRow2[3 * (x-1) + k] += factor * (2*err >> 5);
+                }
+                if(x < width-1){
+                  pRow2[3 * (x+1) + k] += factor * (2*err >> 5);
+                }
               }
             }
           }
@@ -542,17 +564,17 @@ static int quantize_and_dither(colHashTable* colhash, const uint8_t* pImageDataR
     if(root == NULL) {
       return -1;
     }
-    float* pImageDataRGBfloat = malloc(fmtChan * numPixel * sizeof(float)); // TBD fmtChan + only when hasAlpha
-    if(pImageDataRGBfloat == NULL) {
-      free_decision_tree(root);
-      return -1;
-    }
-    for(uint32_t i = 0; i < fmtChan * numPixel; ++i){
-      pImageDataRGBfloat[i] = pImageDataRGB[i];
+    float* pRowsRGBfloat = NULL; // rows with the passed errors (dithering only)
+    if(dithering) {
+      pRowsRGBfloat = malloc(3 * 3 * width * sizeof(float));
+      if(pRowsRGBfloat == NULL) {
+        free_decision_tree(root);
+        return -1;
+      }
     }
     uint8_t transIndex = colMax;
-    get_quantized_dithered_image(pImageData, pImageDataRGBfloat, pPalette256, root, numPixel, width, dithering, transIndex, fmtChan, pBef, befFmtChan, hasAlpha); // do color quantization and dithering
-    free(pImageDataRGBfloat); // RGB image is not needed anymore
+    get_quantized_dithered_image(pImageData, pImageDataRGB, pRowsRGBfloat, pPalette256, root, numPixel, width, dithering, transIndex, fmtChan, pBef, befFmtChan, hasAlpha); // do color quantization and dithering
+    free(pRowsRGBfloat);
     free_decision_tree(root); // tree for color quantization is not needed anymore
     colhash->cnt = colMax;
   } else { // no color-quantization is needed if the number of colors is small enough
@@ -588,6 +610,7 @@ CGIFrgb* cgif_rgb_newgif(const CGIFrgb_Config* pConfig) {
   idxConfig.width     = pConfig->width;
   idxConfig.height    = pConfig->height;
   idxConfig.attrFlags = CGIF_ATTR_IS_ANIMATED | CGIF_ATTR_NO_GLOBAL_TABLE;
+  idxConfig.genFlags  = pConfig->genFlags & (CGIF_GEN_HOIST_GLOBAL_TABLE | CGIF_GEN_LOW_MEMORY); // each frame comes with its own local color table
   pGIFrgb->pGIF       = cgif_newgif(&idxConfig);
   if(pGIFrgb->pGIF == NULL) {
     free(pGIFrgb);
@@ -598,14 +621,20 @@ CGIFrgb* cgif_rgb_newgif(const CGIFrgb_Config* pConfig) {
   return pGIFrgb;  
 }
 
+/* release a frame handed over to cgif_addframe_borrow (image data and LCT are in one block) */
+static void releaseFrame(void* pContext, uint8_t* pImageData, uint8_t* pLocalPalette) {
+  (void)pContext;
+  (void)pLocalPalette;
+  free(pImageData);
+}
+
 cgif_result cgif_rgb_addframe(CGIFrgb* pGIF, const CGIFrgb_FrameConfig* pConfig) {
-  uint8_t          aPalette[256 * 3];
-  memset(aPalette, 0, 256 * 3);       // quantize_and_dither does not necessarily fill/use all palette entries (-> initialize aPalette to avoid underfined behaviour)
+  uint8_t*         aPalette;
   CGIF_FrameConfig fConfig     = {0};
-  uint8_t* pNewBef;
   const uint16_t   imageWidth  = pGIF->config.width;
   const uint16_t   imageHeight = pGIF->config.height;
   const uint32_t   numPixel    = MULU16(imageWidth, imageHeight);
+  const int        isLowMemory = (pGIF->config.genFlags & CGIF_GEN_LOW_MEMORY) ? 1 : 0;
   int              hasAlpha;
   // check for previous errors
   if(pGIF->curResult != CGIF_OK && pGIF->curResult != CGIF_PENDING) {
@@ -616,19 +645,15 @@ cgif_result cgif_rgb_addframe(CGIFrgb* pGIF, const CGIFrgb_FrameConfig* pConfig)
     pGIF->curResult = CGIF_ERROR;
     return CGIF_ERROR;
   }
-  pNewBef = malloc(pConfig->fmtChan * MULU16(imageWidth, imageHeight));
-  if(pNewBef == NULL) {
-    pGIF->curResult = CGIF_EALLOC;
-    return pGIF->curResult;
-  }
-  memcpy(pNewBef, pConfig->pImageData, pConfig->fmtChan * MULU16(imageWidth, imageHeight));
-  fConfig.pLocalPalette = aPalette;
-  fConfig.pImageData    = malloc(pGIF->config.width * (uint32_t)pGIF->config.height);
+  // the indexed frame is handed over to cgif without a copy (cgif_addframe_borrow): image data + LCT in one block
+  fConfig.pImageData    = malloc(numPixel + 256 * 3);
   if(fConfig.pImageData == NULL) {
-    free(pNewBef);
     pGIF->curResult = CGIF_EALLOC;
     return pGIF->curResult;
   }
+  aPalette              = fConfig.pImageData + numPixel;
+  memset(aPalette, 0, 256 * 3);       // quantize_and_dither does not necessarily fill/use all palette entries (-> initialize aPalette to avoid underfined behaviour)
+  fConfig.pLocalPalette = aPalette;
   fConfig.delay         = pConfig->delay;
   fConfig.attrFlags     = CGIF_FRAME_ATTR_USE_LOCAL_TABLE;
   if(pConfig->attrFlags & CGIF_RGB_FRAME_ATTR_INTERLACED) {
@@ -637,7 +662,6 @@ cgif_result cgif_rgb_addframe(CGIFrgb* pGIF, const CGIFrgb_FrameConfig* pConfig)
 
   colHashTable* colhash = get_color_histogram(pConfig->pImageData, numPixel, pConfig->fmtChan, &hasAlpha);
   if(colhash == NULL) {
-    free(pNewBef);
     free(fConfig.pImageData);
     pGIF->curResult = CGIF_EALLOC;
     return pGIF->curResult;
@@ -646,27 +670,37 @@ cgif_result cgif_rgb_addframe(CGIFrgb* pGIF, const CGIFrgb_FrameConfig* pConfig)
   const int sizeLCT = quantize_and_dither(colhash, pConfig->pImageData, numPixel, pGIF->config.width, pConfig->fmtChan, fConfig.pImageData, aPalette, 8, bDither, hasAlpha, pGIF->pBefImageData, pGIF->befFmtChan);
   free_col_hash_table(colhash);
   if(sizeLCT < 0) {
-    free(pNewBef);
     free(fConfig.pImageData);
     pGIF->curResult = CGIF_EALLOC;
     return pGIF->curResult;
   }
+  // keep a copy of the frame for the transparency trick of the next frame (reusing the buffer, if possible)
+  // low memory: no copy, cgif compares the quantized colors with the frame before instead
+  if(!isLowMemory) {
+    if(pGIF->pBefImageData == NULL || pGIF->befFmtChan != pConfig->fmtChan) {
+      free(pGIF->pBefImageData);
+      pGIF->pBefImageData = malloc(pConfig->fmtChan * numPixel);
+      if(pGIF->pBefImageData == NULL) {
+        free(fConfig.pImageData);
+        pGIF->curResult = CGIF_EALLOC;
+        return pGIF->curResult;
+      }
+      pGIF->befFmtChan = pConfig->fmtChan;
+    }
+    memcpy(pGIF->pBefImageData, pConfig->pImageData, pConfig->fmtChan * numPixel);
+  }
 
   fConfig.numLocalPaletteEntries = sizeLCT;
   if(hasAlpha) {
     fConfig.attrFlags   |= CGIF_FRAME_ATTR_HAS_ALPHA;
     fConfig.transIndex   = sizeLCT;
+  } else if(isLowMemory) {
+    fConfig.genFlags     = CGIF_FRAME_GEN_USE_TRANSPARENCY | CGIF_FRAME_GEN_USE_DIFF_WINDOW;
   } else {
     fConfig.attrFlags |= CGIF_FRAME_ATTR_HAS_SET_TRANS;
     fConfig.transIndex = sizeLCT;
   }
-  cgif_result r = cgif_addframe(pGIF->pGIF, &fConfig);
-  free(pGIF->pBefImageData);
-  pGIF->pBefImageData = pNewBef;
-  pGIF->befFmtChan    = pConfig->fmtChan;
-
-  // cleanup
-  free(fConfig.pImageData);
+  cgif_result r = cgif_addframe_borrow(pGIF->pGIF, &fConfig, releaseFrame, NULL);
   pGIF->curResult = r;
   return r;
 }
@@ -0,0 +1,180 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "cgif.h"
+#include "test_output.h"
+
+#define WIDTH      100
+#define HEIGHT     100
+#define NUM_FRAMES 60
+#define POOL_SIZE  4   // cgif holds at most 3 frames at a time
+
+typedef struct {
+  uint8_t* aBuffer[POOL_SIZE];
+  int      aInUse[POOL_SIZE];
+  int      numReleased;
+  int      error;
+} FramePool;
+
+static void releaseFn(void* pContext, uint8_t* pImageData, uint8_t* pLocalPalette) {
+  FramePool* pPool = (FramePool*)pContext;
+  int        i;
+  (void)pLocalPalette;
+
+  for(i = 0; i < POOL_SIZE; ++i) {
+    if(pPool->aBuffer[i] == pImageData) {
+      if(!pPool->aInUse[i]) {
+        pPool->error = 1; // released twice
+      }
+      pPool->aInUse[i] = 0;
+      pPool->numReleased++;
+      return;
+    }
+  }
+  pPool->error = 1; // unknown buffer
+}
+
+static uint8_t* acquireBuffer(FramePool* pPool) {
+  int i;
+  for(i = 0; i < POOL_SIZE; ++i) {
+    if(!pPool->aInUse[i]) {
+      pPool->aInUse[i] = 1;
+      return pPool->aBuffer[i];
+    }
+  }
+  return NULL;
+}
+
+/* render frame f of a moving square (every 10th frame is repeated to hit the identical frame path) */
+static void renderFrame(uint8_t* pImageData, int f) {
+  int x, y, pos;
+
+  pos = (f - f / 10) % (WIDTH - 20);
+  memset(pImageData, 0, WIDTH * HEIGHT);
+  for(y = 30; y < 50; ++y) {
+    for(x = pos; x < pos + 20; ++x) {
+      pImageData[y * WIDTH + x] = 1 + (x + y) % 2;
+    }
+  }
+}
+
+static void initGIFConfig(CGIF_Config* pConfig, uint8_t* pPalette, ByteBuffer* pOut) {
+  memset(pConfig, 0, sizeof(CGIF_Config));
+  pConfig->width                   = WIDTH;
+  pConfig->height                  = HEIGHT;
+  pConfig->pGlobalPalette          = pPalette;
+  pConfig->numGlobalPaletteEntries = 3;
+  pConfig->attrFlags               = CGIF_ATTR_IS_ANIMATED;
+  pConfig->pWriteFn                = writeFn;
+  pConfig->pContext                = pOut;
+}
+
+static void initFrameConfig(CGIF_FrameConfig* pConfig, uint8_t* pImageData) {
+  memset(pConfig, 0, sizeof(CGIF_FrameConfig));
+  pConfig->delay      = 5;
+  pConfig->pImageData = pImageData;
+  pConfig->genFlags   = CGIF_FRAME_GEN_USE_TRANSPARENCY | CGIF_FRAME_GEN_USE_DIFF_WINDOW;
+}
+
+/* create the animation by copying every frame (reference output) */
+static int createCopy(uint8_t* pPalette, ByteBuffer* pOut) {
+  CGIF*            pGIF;
+  CGIF_Config      gConfig;
+  CGIF_FrameConfig fConfig;
+  uint8_t*         pImageData;
+  int              f;
+  cgif_result      r;
+
+  initGIFConfig(&gConfig, pPalette, pOut);
+  pGIF = cgif_newgif(&gConfig);
+  if(pGIF == NULL) {
+    return 1;
+  }
+  pImageData = malloc(WIDTH * HEIGHT);
+  for(f = 0; f < NUM_FRAMES; ++f) {
+    renderFrame(pImageData, f);
+    initFrameConfig(&fConfig, pImageData);
+    cgif_addframe(pGIF, &fConfig);
+  }
+  free(pImageData);
+  r = cgif_close(pGIF);
+  return (r == CGIF_OK) ? 0 : 1;
+}
+
+/* create the same animation by lending buffers from a small frame pool */
+static int createBorrow(uint8_t* pPalette, ByteBuffer* pOut, FramePool* pPool) {
+  CGIF*            pGIF;
+  CGIF_Config      gConfig;
+  CGIF_FrameConfig fConfig;
+  uint8_t*         pImageData;
+  int              f;
+  cgif_result      r;
+
+  initGIFConfig(&gConfig, pPalette, pOut);
+  pGIF = cgif_newgif(&gConfig);
+  if(pGIF == NULL) {
+    return 1;
+  }
+  for(f = 0; f < NUM_FRAMES; ++f) {
+    pImageData = acquireBuffer(pPool);
+    if(pImageData == NULL) {
+      fputs("frame pool exhausted: frames are not released in time\n", stderr);
+      cgif_close(pGIF);
+      return 1;
+    }
+    renderFrame(pImageData, f);
+    initFrameConfig(&fConfig, pImageData);
+    cgif_addframe_borrow(pGIF, &fConfig, releaseFn, pPool);
+  }
+  r = cgif_close(pGIF);
+  return (r == CGIF_OK) ? 0 : 1;
+}
+
+int main(void) {
+  FramePool  pool;
+  ByteBuffer outCopy   = {NULL, 0};
+  ByteBuffer outBorrow = {NULL, 0};
+  int        i, r;
+  uint8_t    aPalette[] = {
+    0xFF, 0xFF, 0xFF, // white
+    0x00, 0x00, 0xFF, // blue
+    0xFF, 0x00, 0x00, // red
+  };
+
+  memset(&pool, 0, sizeof(pool));
+  for(i = 0; i < POOL_SIZE; ++i) {
+    pool.aBuffer[i] = malloc(WIDTH * HEIGHT);
+  }
+  r  = createCopy(aPalette, &outCopy);
+  r |= createBorrow(aPalette, &outBorrow, &pool);
+  if(r) {
+    fputs("failed to create GIF\n", stderr);
+  }
+  // each borrowed frame must be released exactly once
+  if(!r && (pool.error || pool.numReleased != NUM_FRAMES)) {
+    fprintf(stderr, "invalid release of borrowed frames (released: %d, expected: %d)\n", pool.numReleased, NUM_FRAMES);
+    r = 1;
+  }
+  for(i = 0; i < POOL_SIZE; ++i) {
+    if(pool.aInUse[i]) {
+      fputs("borrowed frame not released by cgif_close\n", stderr);
+      r = 1;
+    }
+  }
+  // zero-copy mode must not change the output
+  if(!r && (outCopy.sizeData != outBorrow.sizeData || memcmp(outCopy.pData, outBorrow.pData, outCopy.sizeData))) {
+    fputs("output of cgif_addframe_borrow differs from cgif_addframe\n", stderr);
+    r = 1;
+  }
+  if(!r && !writeFile("addframe_borrow.gif", &outBorrow)) {
+    r = 1;
+  }
+  for(i = 0; i < POOL_SIZE; ++i) {
+    free(pool.aBuffer[i]);
+  }
+  free(outCopy.pData);
+  free(outBorrow.pData);
+  return r;
+}
@@ -0,0 +1,202 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "cgif.h"
+#include "test_output.h"
+
+#define WIDTH      160
+#define HEIGHT     120
+#define NUM_FRAMES 40
+#define MARGIN     6   // the loose patch is larger than the changed area by this amount (each side)
+
+typedef struct {
+  uint16_t left, top, width, height;
+} Rect;
+
+static const uint8_t aPalette[] = {
+  0xFF, 0xFF, 0xFF, // white
+  0x00, 0x00, 0x00, // black
+  0xC0, 0xC0, 0xC0, // grey
+  0xFF, 0x00, 0x00, // red
+  0x00, 0x00, 0xFF, // blue
+};
+
+/* render frame f: a square moving over stripes, a blinking dot (every 7th frame is repeated) */
+static void renderFrame(uint8_t* pImageData, int f) {
+  f -= f / 7;
+  for(int y = 0; y < HEIGHT; ++y) {
+    for(int x = 0; x < WIDTH; ++x) {
+      pImageData[y * WIDTH + x] = (y / 8) % 2 * 2;
+    }
+  }
+  for(int y = 50; y < 70; ++y) {
+    for(int x = 3 * f; x < 3 * f + 20; ++x) {
+      pImageData[y * WIDTH + x] = 3 + (x + y) % 2;
+    }
+  }
+  if(f % 3 == 0) {
+    pImageData[10 * WIDTH + 150] = 1;
+  }
+}
+
+/* bounding box of the pixels that differ (returns 0 if the frames are equal) */
+static int getChangedRect(const uint8_t* pCur, const uint8_t* pBef, Rect* pRect) {
+  int left = WIDTH, right = -1, top = HEIGHT, bottom = -1;
+
+  for(int y = 0; y < HEIGHT; ++y) {
+    for(int x = 0; x < WIDTH; ++x) {
+      if(pCur[y * WIDTH + x] != pBef[y * WIDTH + x]) {
+        left   = (x < left) ? x : left;
+        right  = (x > right) ? x : right;
+        top    = (y < top) ? y : top;
+        bottom = (y > bottom) ? y : bottom;
+      }
+    }
+  }
+  if(right < 0) {
+    return 0;
+  }
+  pRect->left   = left;
+  pRect->top    = top;
+  pRect->width  = right + 1 - left;
+  pRect->height = bottom + 1 - top;
+  return 1;
+}
+
+/* copy the patch pRect out of the full frame */
+static void copyPatch(uint8_t* pPatch, const uint8_t* pImageData, const Rect* pRect) {
+  for(int y = 0; y < pRect->height; ++y) {
+    memcpy(pPatch + y * pRect->width, pImageData + (pRect->top + y) * WIDTH + pRect->left, pRect->width);
+  }
+}
+
+static CGIF* newGIF(uint32_t genFlags, ByteBuffer* pOut) {
+  CGIF_Config gConfig;
+
+  memset(&gConfig, 0, sizeof(CGIF_Config));
+  gConfig.width                   = WIDTH;
+  gConfig.height                  = HEIGHT;
+  gConfig.pGlobalPalette          = (uint8_t*)aPalette;
+  gConfig.numGlobalPaletteEntries = sizeof(aPalette) / 3;
+  gConfig.attrFlags               = CGIF_ATTR_IS_ANIMATED;
+  gConfig.genFlags                = genFlags;
+  gConfig.pWriteFn                = writeFn;
+  gConfig.pContext                = pOut;
+  return cgif_newgif(&gConfig);
+}
+
+/* create the animation: full frames (useRect == 0), loose patches (useRect == 1) or exact patches (useRect == 2) */
+static cgif_result createGIF(uint32_t genFlags, int useRect, ByteBuffer* pOut) {
+  CGIF*            pGIF;
+  CGIF_FrameConfig fConfig;
+  uint8_t          aImageData[WIDTH * HEIGHT];
+  uint8_t          aBefore[WIDTH * HEIGHT];
+  uint8_t          aPatch[WIDTH * HEIGHT];
+  Rect             rect;
+
+  pGIF = newGIF(genFlags, pOut);
+  if(pGIF == NULL) {
+    return CGIF_ERROR;
+  }
+  for(int f = 0; f < NUM_FRAMES; ++f) {
+    renderFrame(aImageData, f);
+    memset(&fConfig, 0, sizeof(CGIF_FrameConfig));
+    fConfig.delay    = 5;
+    fConfig.genFlags = CGIF_FRAME_GEN_USE_TRANSPARENCY | CGIF_FRAME_GEN_USE_DIFF_WINDOW;
+    if(f == 0 || !useRect) {
+      fConfig.pImageData = aImageData;
+      cgif_addframe(pGIF, &fConfig);
+    } else {
+      if(!getChangedRect(aImageData, aBefore, &rect)) {
+        rect.left   = 0; // unchanged frame: any patch
+        rect.top    = 0;
+        rect.width  = 1;
+        rect.height = 1;
+      }
+      if(useRect == 1) {
+        const int left = (rect.left > MARGIN) ? rect.left - MARGIN : 0;
+        const int top  = (rect.top > MARGIN) ? rect.top - MARGIN : 0;
+        rect.width   = ((rect.left + rect.width + MARGIN < WIDTH) ? rect.left + rect.width + MARGIN : WIDTH) - left;
+        rect.height  = ((rect.top + rect.height + MARGIN < HEIGHT) ? rect.top + rect.height + MARGIN : HEIGHT) - top;
+        rect.left    = left;
+        rect.top     = top;
+      } else {
+        fConfig.attrFlags = CGIF_FRAME_ATTR_EXACT_RECT;
+      }
+      copyPatch(aPatch, aImageData, &rect);
+      fConfig.pImageData = aPatch;
+      cgif_addframe_rect(pGIF, &fConfig, rect.left, rect.top, rect.width, rect.height);
+    }
+    memcpy(aBefore, aImageData, sizeof(aBefore));
+  }
+  return cgif_close(pGIF);
+}
+
+/* add a patch to a new GIF (pFirst: first frame, NULL: the patch is the first frame) */
+static cgif_result addInvalidRect(const uint8_t* pFirst, uint32_t attrFlags, uint16_t left, uint16_t top, uint16_t width, uint16_t height) {
+  ByteBuffer       out = {NULL, 0};
+  CGIF*            pGIF;
+  CGIF_FrameConfig fConfig;
+  uint8_t          aPatch[WIDTH * HEIGHT];
+  uint8_t          aLCT[3] = { 0x00, 0x00, 0x00 };
+  cgif_result      r;
+
+  pGIF = newGIF(0, &out);
+  if(pGIF == NULL) {
+    return CGIF_ERROR;
+  }
+  memset(&fConfig, 0, sizeof(CGIF_FrameConfig));
+  memset(aPatch, 1, sizeof(aPatch));
+  if(pFirst) {
+    fConfig.pImageData = (uint8_t*)pFirst;
+    cgif_addframe(pGIF, &fConfig);
+  }
+  fConfig.pImageData             = aPatch;
+  fConfig.attrFlags              = attrFlags;
+  fConfig.pLocalPalette          = aLCT;
+  fConfig.numLocalPaletteEntries = 1;
+  cgif_addframe_rect(pGIF, &fConfig, left, top, width, height);
+  r = cgif_close(pGIF);
+  free(out.pData);
+  return r;
+}
+
+int main(void) {
+  ByteBuffer outFull = {NULL, 0};
+  ByteBuffer out     = {NULL, 0};
+  uint8_t    aFirst[WIDTH * HEIGHT];
+  int        r = 0;
+
+  if(createGIF(0, 0, &outFull) != CGIF_OK) {
+    fputs("failed to create GIF\n", stderr);
+    r = 1;
+  }
+  // patches (loose or exact): same output as the full frames (synchronous and with the encoder thread)
+  for(int useRect = 1; !r && useRect <= 2; ++useRect) {
+    for(int async = 0; !r && async < 2; ++async) {
+      free(out.pData);
+      out.pData    = NULL;
+      out.sizeData = 0;
+      if(createGIF(async ? CGIF_GEN_ASYNC_ENCODING : 0, useRect, &out) != CGIF_OK || !isEqual(&out, &outFull)) {
+        fprintf(stderr, "unexpected output with patches (exact: %d, async: %d)\n", useRect == 2, async);
+        r = 1;
+      }
+    }
+  }
+  // invalid patches: out of the frame, empty, without a frame before, with a local color table
+  renderFrame(aFirst, 0);
+  if(!r && (addInvalidRect(aFirst, 0, WIDTH - 10, 0, 11, 10) != CGIF_ERROR || addInvalidRect(aFirst, 0, 0, HEIGHT - 10, 10, 11) != CGIF_ERROR
+            || addInvalidRect(aFirst, 0, 0, 0, 0, 10) != CGIF_ERROR || addInvalidRect(NULL, 0, 0, 0, 10, 10) != CGIF_ERROR
+            || addInvalidRect(aFirst, CGIF_FRAME_ATTR_USE_LOCAL_TABLE, 0, 0, 10, 10) != CGIF_ERROR || addInvalidRect(aFirst, 0, 0, 0, WIDTH, HEIGHT) != CGIF_OK)) {
+    fputs("invalid patch accepted (or valid patch rejected)\n", stderr);
+    r = 1;
+  }
+  if(!r && !writeFile("addframe_rect.gif", &out)) {
+    r = 1;
+  }
+  free(outFull.pData);
+  free(out.pData);
+  return r;
+}
@@ -0,0 +1,152 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "cgif.h"
+#include "test_output.h"
+
+#define WIDTH      100
+#define HEIGHT     100
+#define NUM_FRAMES 60
+#define POOL_SIZE  16  // enough buffers for the ring of the encoder thread and the frame queue
+
+// output that fails once it grows beyond maxSize (simulated write error)
+typedef struct {
+  ByteBuffer buf;
+  size_t     maxSize;
+} LimitedBuffer;
+
+typedef struct {
+  uint8_t* aBuffer[POOL_SIZE];
+  int      aInUse[POOL_SIZE];
+  int      numReleased;
+  int      error;
+} FramePool;
+
+static int writeLimitedFn(void* pContext, const uint8_t* pData, const size_t numBytes) {
+  LimitedBuffer* pOut = (LimitedBuffer*)pContext;
+
+  if(pOut->buf.sizeData + numBytes > pOut->maxSize) {
+    return -1;
+  }
+  return writeFn(&pOut->buf, pData, numBytes);
+}
+
+/* called from the encoder thread (the calling thread reads the pool only after cgif_close) */
+static void releaseFn(void* pContext, uint8_t* pImageData, uint8_t* pLocalPalette) {
+  FramePool* pPool = (FramePool*)pContext;
+  (void)pLocalPalette;
+
+  for(int i = 0; i < POOL_SIZE; ++i) {
+    if(pPool->aBuffer[i] == pImageData) {
+      if(!pPool->aInUse[i]) {
+        pPool->error = 1; // released twice
+      }
+      pPool->aInUse[i] = 0;
+      pPool->numReleased++;
+      return;
+    }
+  }
+  pPool->error = 1; // unknown buffer
+}
+
+/* render frame f of a moving square (every 10th frame is repeated to hit the identical frame path) */
+static void renderFrame(uint8_t* pImageData, int f) {
+  int pos = (f - f / 10) % (WIDTH - 20);
+
+  memset(pImageData, 0, WIDTH * HEIGHT);
+  for(int y = 30; y < 50; ++y) {
+    for(int x = pos; x < pos + 20; ++x) {
+      pImageData[y * WIDTH + x] = 1 + (x + y) % 2;
+    }
+  }
+}
+
+/* create the animation: every third frame is borrowed from the pool (pPool == NULL: copy all frames) */
+static cgif_result createGIF(uint32_t genFlags, cgif_write_fn* pWriteFn, void* pContext, FramePool* pPool) {
+  CGIF*            pGIF;
+  CGIF_Config      gConfig;
+  CGIF_FrameConfig fConfig;
+  uint8_t          aImageData[WIDTH * HEIGHT];
+  uint8_t          aPalette[] = {
+    0xFF, 0xFF, 0xFF, // white
+    0x00, 0x00, 0xFF, // blue
+    0xFF, 0x00, 0x00, // red
+  };
+
+  memset(&gConfig, 0, sizeof(CGIF_Config));
+  gConfig.width                   = WIDTH;
+  gConfig.height                  = HEIGHT;
+  gConfig.pGlobalPalette          = aPalette;
+  gConfig.numGlobalPaletteEntries = 3;
+  gConfig.attrFlags               = CGIF_ATTR_IS_ANIMATED;
+  gConfig.genFlags                = genFlags;
+  gConfig.pWriteFn                = pWriteFn;
+  gConfig.pContext                = pContext;
+  pGIF = cgif_newgif(&gConfig);
+  if(pGIF == NULL) {
+    return CGIF_ERROR;
+  }
+  for(int f = 0; f < NUM_FRAMES; ++f) {
+    memset(&fConfig, 0, sizeof(CGIF_FrameConfig));
+    fConfig.delay    = 5;
+    fConfig.genFlags = CGIF_FRAME_GEN_USE_TRANSPARENCY | CGIF_FRAME_GEN_USE_DIFF_WINDOW;
+    if(pPool && f % 3 == 0) {
+      uint8_t* pBuffer = pPool->aBuffer[(f / 3) % POOL_SIZE];
+      pPool->aInUse[(f / 3) % POOL_SIZE] = 1;
+      renderFrame(pBuffer, f);
+      fConfig.pImageData = pBuffer;
+      cgif_addframe_borrow(pGIF, &fConfig, releaseFn, pPool);
+    } else {
+      renderFrame(aImageData, f);
+      fConfig.pImageData = aImageData;
+      cgif_addframe(pGIF, &fConfig); // aImageData is reused right away
+    }
+  }
+  return cgif_close(pGIF);
+}
+
+int main(void) {
+  FramePool     pool;
+  ByteBuffer    outSync  = {NULL, 0};
+  ByteBuffer    outAsync = {NULL, 0};
+  LimitedBuffer outError = {{NULL, 0}, 1000};
+  cgif_result   rError;
+  int           r = 0;
+
+  memset(&pool, 0, sizeof(pool));
+  for(int i = 0; i < POOL_SIZE; ++i) {
+    pool.aBuffer[i] = malloc(WIDTH * HEIGHT);
+  }
+  if(createGIF(0, writeFn, &outSync, NULL) != CGIF_OK || createGIF(CGIF_GEN_ASYNC_ENCODING, writeFn, &outAsync, &pool) != CGIF_OK) {
+    fputs("failed to create GIF\n", stderr);
+    r = 1;
+  }
+  // each borrowed frame must be released exactly once
+  if(!r && (pool.error || pool.numReleased != (NUM_FRAMES + 2) / 3)) {
+    fprintf(stderr, "invalid release of borrowed frames (released: %d, expected: %d)\n", pool.numReleased, (NUM_FRAMES + 2) / 3);
+    r = 1;
+  }
+  // the encoder thread must not change the output
+  if(!r && !isEqual(&outSync, &outAsync)) {
+    fputs("output with CGIF_GEN_ASYNC_ENCODING differs\n", stderr);
+    r = 1;
+  }
+  // write errors of the encoder thread are reported (at the latest by cgif_close)
+  rError = createGIF(CGIF_GEN_ASYNC_ENCODING, writeLimitedFn, &outError, NULL);
+  if(rError != CGIF_EWRITE) {
+    fprintf(stderr, "write error not reported (result: %d)\n", rError);
+    r = 1;
+  }
+  if(!r && !writeFile("async_encoding.gif", &outAsync)) {
+    r = 1;
+  }
+  for(int i = 0; i < POOL_SIZE; ++i) {
+    free(pool.aBuffer[i]);
+  }
+  free(outSync.pData);
+  free(outAsync.pData);
+  free(outError.buf.pData);
+  return r;
+}
@@ -0,0 +1,132 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "cgif.h"
+#include "test_output.h"
+
+#define WIDTH      120
+#define HEIGHT     90
+#define NUM_FRAMES 30
+#define NUM_COLORS 64
+
+static uint8_t aPalette[NUM_COLORS * 3];
+
+static uint32_t nextRand(uint32_t* pSeed) {
+  *pSeed = *pSeed * 1103515245 + 12345;
+  return (*pSeed >> 16) & 0x7FFF;
+}
+
+/* reference: distance of two colors of the palette (same definition as the color tolerance of cgif) */
+static int isNear(uint8_t a, uint8_t b, uint16_t tolerance, int isPerceptual) {
+  const int dR = aPalette[a * 3] - aPalette[b * 3];
+  const int dG = aPalette[a * 3 + 1] - aPalette[b * 3 + 1];
+  const int dB = aPalette[a * 3 + 2] - aPalette[b * 3 + 2];
+  if(isPerceptual) {
+    const int rMean = (aPalette[a * 3] + aPalette[b * 3]) / 2;
+    return (((512 + rMean) * dR * dR) >> 8) + 4 * dG * dG + (((767 - rMean) * dB * dB) >> 8) <= 9 * tolerance * tolerance;
+  }
+  return abs(dR) <= tolerance && abs(dG) <= tolerance && abs(dB) <= tolerance;
+}
+
+/* frame f of a "video": a box moving over a gradient, every pixel is off by one shade now and then (sensor noise).
+   frames 10-14 show the same scene (noise only) */
+static void renderFrame(uint8_t* pImageData, int f, uint32_t* pSeed) {
+  const int pos = (f >= 10 && f < 15) ? 10 : f;
+  for(int y = 0; y < HEIGHT; ++y) {
+    for(int x = 0; x < WIDTH; ++x) {
+      uint8_t c = (x / 4) % 30 * 2; // even colors: the gradient, odd colors: one shade brighter
+      if(x >= 3 * pos && x < 3 * pos + 12 && y >= 30 && y < 50) {
+        c = 62;
+      }
+      pImageData[y * WIDTH + x] = c + (nextRand(pSeed) % 5 == 0);
+    }
+  }
+}
+
+/* create the animation: with tolerance, or snapped by the reference model (pixels within the tolerance of the frame before get its color) */
+static cgif_result createGIF(uint16_t tolerance, uint32_t genFlags, int isModel, ByteBuffer* pOut) {
+  CGIF*            pGIF;
+  CGIF_Config      gConfig;
+  CGIF_FrameConfig fConfig;
+  uint8_t          aImageData[WIDTH * HEIGHT];
+  uint8_t          aBefore[WIDTH * HEIGHT];
+  const int        isPerceptual = (genFlags & CGIF_GEN_PERCEPTUAL_TOLERANCE) ? 1 : 0;
+  uint32_t         seed = 7;
+
+  memset(&gConfig, 0, sizeof(CGIF_Config));
+  gConfig.width                   = WIDTH;
+  gConfig.height                  = HEIGHT;
+  gConfig.pGlobalPalette          = aPalette;
+  gConfig.numGlobalPaletteEntries = NUM_COLORS;
+  gConfig.attrFlags               = CGIF_ATTR_IS_ANIMATED;
+  gConfig.genFlags                = genFlags;
+  gConfig.colorTolerance          = (isModel) ? 0 : tolerance;
+  gConfig.pWriteFn                = writeFn;
+  gConfig.pContext                = pOut;
+  pGIF = cgif_newgif(&gConfig);
+  if(pGIF == NULL) {
+    return CGIF_ERROR;
+  }
+  for(int f = 0; f < NUM_FRAMES; ++f) {
+    renderFrame(aImageData, f, &seed);
+    if(isModel && f > 0) {
+      for(int i = 0; i < WIDTH * HEIGHT; ++i) {
+        aImageData[i] = isNear(aImageData[i], aBefore[i], tolerance, isPerceptual) ? aBefore[i] : aImageData[i];
+      }
+    }
+    // identical frames are merged: the frame before stays the reference
+    if(f == 0 || memcmp(aImageData, aBefore, sizeof(aBefore))) {
+      memcpy(aBefore, aImageData, sizeof(aBefore));
+    }
+    memset(&fConfig, 0, sizeof(CGIF_FrameConfig));
+    fConfig.pImageData = aImageData;
+    fConfig.delay      = 4;
+    fConfig.genFlags   = CGIF_FRAME_GEN_USE_TRANSPARENCY | CGIF_FRAME_GEN_USE_DIFF_WINDOW;
+    cgif_addframe(pGIF, &fConfig);
+  }
+  return cgif_close(pGIF);
+}
+
+int main(void) {
+  ByteBuffer exact = {NULL, 0};
+  ByteBuffer ref   = {NULL, 0};
+  ByteBuffer out   = {NULL, 0};
+  int        r = 0;
+
+  // gradient of greyish colors: one shade is a step of 2 (+1 in red)
+  for(int c = 0; c < NUM_COLORS; ++c) {
+    aPalette[c * 3]     = 40 + c * 2 + c % 2;
+    aPalette[c * 3 + 1] = 40 + c * 2;
+    aPalette[c * 3 + 2] = 60 + c * 2;
+  }
+  if(createGIF(0, 0, 0, &exact) != CGIF_OK) {
+    fputs("failed to create GIF\n", stderr);
+    r = 1;
+  }
+  // same output as the snapped frames without tolerance (max channel delta and perceptual distance, also with the encoder thread)
+  for(int mode = 0; !r && mode < 4; ++mode) {
+    const uint16_t tolerance    = (mode % 2) ? 5 : 3;
+    const int      isPerceptual = mode >= 2;
+    const uint32_t genFlags     = ((isPerceptual) ? CGIF_GEN_PERCEPTUAL_TOLERANCE : 0) | ((mode == 1) ? CGIF_GEN_ASYNC_ENCODING : 0);
+    free(ref.pData);
+    free(out.pData);
+    memset(&ref, 0, sizeof(ref));
+    memset(&out, 0, sizeof(out));
+    if(createGIF(tolerance, genFlags, 1, &ref) != CGIF_OK || createGIF(tolerance, genFlags, 0, &out) != CGIF_OK || !isEqual(&out, &ref)) {
+      fprintf(stderr, "unexpected output with color tolerance %d (perceptual: %d)\n", tolerance, isPerceptual);
+      r = 1;
+    } else if(out.sizeData >= exact.sizeData) {
+      fprintf(stderr, "color tolerance %d (perceptual: %d) does not decrease the size: %d vs. %d bytes\n", tolerance, isPerceptual, (int)out.sizeData, (int)exact.sizeData);
+      r = 1;
+    }
+    if(!r && mode == 0 && !writeFile("color_tolerance.gif", &out)) {
+      r = 1;
+    }
+  }
+  free(exact.pData);
+  free(ref.pData);
+  free(out.pData);
+  return r;
+}
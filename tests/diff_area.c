@@ -0,0 +1,176 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "cgif.h"
+#include "cgif_raw.h"
+
+#define NUM_RUNS 2000
+
+/* compile the sources directly to test the (static) diff area detection */
+#include "../src/cgif_raw.c"
+/* avoid duplicate static function name */
+#define calcNextPower2Ex cgif_calcNextPower2Ex
+#include "../src/cgif.c"
+#undef calcNextPower2Ex
+
+static uint32_t nextRand(uint32_t* pSeed) {
+  *pSeed = *pSeed * 1103515245 + 12345;
+  return (*pSeed >> 16) & 0x7FFF;
+}
+
+/* reference: compare given pixel indices using the correct local or global color table; returns 0 if the two pixels are RGB equal */
+static int cmpPixelRef(const CGIF* pGIF, const CGIF_FrameConfig* pCur, const CGIF_FrameConfig* pBef, const uint8_t iCur, const uint8_t iBef) {
+  if((pCur->attrFlags & CGIF_FRAME_ATTR_HAS_SET_TRANS) && iCur == pCur->transIndex) {
+    return 0; // identical
+  }
+  if((pBef->attrFlags & CGIF_FRAME_ATTR_HAS_SET_TRANS) && iBef == pBef->transIndex) {
+    return 1; // cannot compare
+  }
+  const uint16_t sizeCTBef = (pBef->attrFlags & CGIF_FRAME_ATTR_USE_LOCAL_TABLE) ? pBef->numLocalPaletteEntries : pGIF->config.numGlobalPaletteEntries;
+  const uint16_t sizeCTCur = (pCur->attrFlags & CGIF_FRAME_ATTR_USE_LOCAL_TABLE) ? pCur->numLocalPaletteEntries : pGIF->config.numGlobalPaletteEntries;
+  if((iBef >= sizeCTBef) || (iCur >= sizeCTCur)) {
+    return 1; // out-of-bounds
+  }
+  const uint8_t* pBefCT = (pBef->attrFlags & CGIF_FRAME_ATTR_USE_LOCAL_TABLE) ? pBef->pLocalPalette : pGIF->config.pGlobalPalette;
+  const uint8_t* pCurCT = (pCur->attrFlags & CGIF_FRAME_ATTR_USE_LOCAL_TABLE) ? pCur->pLocalPalette : pGIF->config.pGlobalPalette;
+  return memcmp(pBefCT + iBef * 3, pCurCT + iCur * 3, 3) ? 1 : 0;
+}
+
+/* check the pixel equivalence table against the reference for all index pairs; returns 0 on success */
+static int checkPixelEqTable(const CGIF* pGIF, const CGIF_FrameConfig* pCur, const CGIF_FrameConfig* pBef) {
+  PixelEqTable eqTable;
+
+  initPixelEqTable(pGIF, pCur, pBef, &eqTable);
+  for(int iCur = 0; iCur < 256; ++iCur) {
+    for(int iBef = 0; iBef < 256; ++iBef) {
+      if(cmpPixel(&eqTable, iCur, iBef) != cmpPixelRef(pGIF, pCur, pBef, iCur, iBef)) {
+        fprintf(stderr, "pixel equivalence table mismatch (iCur: %d, iBef: %d)\n", iCur, iBef);
+        return 1;
+      }
+    }
+  }
+  return 0;
+}
+
+/* reference: bounding box of all pixels that differ (by RGB value) */
+static int getDiffAreaRef(CGIF* pGIF, CGIF_FrameConfig* pCur, CGIF_FrameConfig* pBef, DimResult* pResult) {
+  const uint16_t width  = pGIF->config.width;
+  const uint16_t height = pGIF->config.height;
+  int            top = height, bottom = -1, left = width, right = -1;
+
+  for(int y = 0; y < height; ++y) {
+    for(int x = 0; x < width; ++x) {
+      const uint32_t i = MULU16(y, width) + x;
+      if(cmpPixelRef(pGIF, pCur, pBef, pCur->pImageData[i], pBef->pImageData[i])) {
+        top    = (y < top)    ? y : top;
+        bottom = (y > bottom) ? y : bottom;
+        left   = (x < left)   ? x : left;
+        right  = (x > right)  ? x : right;
+      }
+    }
+  }
+  if(bottom < 0) {
+    return 0;
+  }
+  pResult->top    = top;
+  pResult->left   = left;
+  pResult->height = bottom + 1 - top;
+  pResult->width  = right + 1 - left;
+  return 1;
+}
+
+int main(void) {
+  CGIF             gif;
+  CGIF_FrameConfig cur, bef;
+  DimResult        res, ref;
+  PixelEqTable     eqTable;
+  uint8_t          aLCT[256 * 3];
+  uint8_t*         pCurData;
+  uint8_t*         pBefData;
+  uint32_t         seed = 1;
+  int              r, rRef, cmpIndices;
+  uint8_t          aPalette[4 * 3] = {
+    0x00, 0x00, 0x00,
+    0xFF, 0xFF, 0xFF,
+    0xFF, 0x00, 0x00,
+    0x00, 0x00, 0x00, // same color as index 0
+  };
+
+  memset(&gif, 0, sizeof(gif));
+  gif.config.pGlobalPalette          = aPalette;
+  gif.config.numGlobalPaletteEntries = 4;
+
+  // pixel equivalence tables: duplicate colors, out-of-bounds indices and user-provided transparency
+  for(int i = 0; i < 256 * 3; ++i) {
+    aLCT[i] = nextRand(&seed) % 4; // lots of duplicate colors
+  }
+  memset(&cur, 0, sizeof(cur));
+  memset(&bef, 0, sizeof(bef));
+  if(checkPixelEqTable(&gif, &cur, &bef)) {
+    return 1;
+  }
+  for(int t = 0; t < 16; ++t) {
+    cur.attrFlags              = (t & 1) ? CGIF_FRAME_ATTR_USE_LOCAL_TABLE : 0;
+    cur.attrFlags             |= (t & 2) ? CGIF_FRAME_ATTR_HAS_SET_TRANS : 0;
+    bef.attrFlags              = (t & 4) ? CGIF_FRAME_ATTR_USE_LOCAL_TABLE : 0;
+    bef.attrFlags             |= (t & 8) ? CGIF_FRAME_ATTR_HAS_SET_TRANS : 0;
+    cur.pLocalPalette          = aLCT;
+    cur.numLocalPaletteEntries = 1 + nextRand(&seed) % 256;
+    cur.transIndex             = nextRand(&seed) % 256;
+    bef.pLocalPalette          = aLCT + 3 * (nextRand(&seed) % 8);
+    bef.numLocalPaletteEntries = 1 + nextRand(&seed) % 248;
+    bef.transIndex             = nextRand(&seed) % 256;
+    if(checkPixelEqTable(&gif, &cur, &bef)) {
+      return 1;
+    }
+  }
+  for(int run = 0; run < NUM_RUNS; ++run) {
+    // odd sizes to cover the scalar tails of the vectorized paths
+    const uint16_t width  = 1 + nextRand(&seed) % 200;
+    const uint16_t height = 1 + nextRand(&seed) % 50;
+    const uint32_t size   = MULU16(width, height);
+    const int      numDiffs = nextRand(&seed) % 4;
+
+    gif.config.width  = width;
+    gif.config.height = height;
+    pCurData = malloc(size);
+    pBefData = malloc(size);
+    for(uint32_t i = 0; i < size; ++i) {
+      pBefData[i] = nextRand(&seed) % 3;
+    }
+    memcpy(pCurData, pBefData, size);
+    for(int d = 0; d < numDiffs; ++d) {
+      const uint32_t i = nextRand(&seed) % size;
+      pCurData[i] = (pCurData[i] + 1 + nextRand(&seed) % 2) % 3;
+    }
+    memset(&cur, 0, sizeof(cur));
+    memset(&bef, 0, sizeof(bef));
+    cur.pImageData = pCurData;
+    bef.pImageData = pBefData;
+    // every other run: compare RGB values through a local color table with a duplicate color
+    cmpIndices = run % 2;
+    if(!cmpIndices) {
+      for(uint32_t i = 0; i < size; ++i) {
+        if(pCurData[i] == 0 && nextRand(&seed) % 2) {
+          pCurData[i] = 3;
+        }
+      }
+      cur.attrFlags              = CGIF_FRAME_ATTR_USE_LOCAL_TABLE;
+      cur.pLocalPalette          = aPalette;
+      cur.numLocalPaletteEntries = 4;
+    }
+    initPixelEqTable(&gif, &cur, &bef, &eqTable);
+    r    = getDiffArea(&gif, &cur, &bef, &res, cmpIndices ? NULL : &eqTable);
+    rRef = getDiffAreaRef(&gif, &cur, &bef, &ref);
+    free(pCurData);
+    free(pBefData);
+    if(r != rRef || (r && memcmp(&res, &ref, sizeof(DimResult)))) {
+      fprintf(stderr, "diff area mismatch (run %d, %dx%d): got %d (%d,%d %dx%d), expected %d (%d,%d %dx%d)\n", run, width, height,
+              r, res.left, res.top, res.width, res.height, rRef, ref.left, ref.top, ref.width, ref.height);
+      return 1;
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,88 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "cgif.h"
+
+#define WIDTH      320
+#define HEIGHT     240
+#define NUM_FRAMES 20
+
+/* Small helper functions to initialize GIF- and frame-configuration */
+static void initGIFConfig(CGIF_Config* pConfig, char* path, uint16_t width, uint16_t height, uint8_t* pPalette, uint16_t numColors) {
+  memset(pConfig, 0, sizeof(CGIF_Config));
+  pConfig->width                   = width;
+  pConfig->height                  = height;
+  pConfig->pGlobalPalette          = pPalette;
+  pConfig->numGlobalPaletteEntries = numColors;
+  pConfig->path                    = path;
+  pConfig->attrFlags               = CGIF_ATTR_IS_ANIMATED;
+}
+
+static void initFrameConfig(CGIF_FrameConfig* pConfig, uint8_t* pImageData, uint16_t delay) {
+  memset(pConfig, 0, sizeof(CGIF_FrameConfig));
+  pConfig->delay      = delay;
+  pConfig->pImageData = pImageData;
+  pConfig->genFlags   = CGIF_FRAME_GEN_USE_TRANSPARENCY | CGIF_FRAME_GEN_USE_DIFF_WINDOW | CGIF_FRAME_GEN_USE_DIFF_RECTS;
+}
+
+/* draw a filled box */
+static void drawBox(uint8_t* pImageData, int left, int top, int width, int height, uint8_t color) {
+  for(int y = top; y < top + height; ++y) {
+    memset(pImageData + y * WIDTH + left, color, width);
+  }
+}
+
+/* This is an example code that creates a GIF-animation of a "desktop" with a clock (top left) and a moving cursor (bottom right):
+   the two changed areas are encoded as separate rectangles instead of one large diff window. */
+int main(void) {
+  CGIF*            pGIF;
+  CGIF_Config      gConfig;
+  CGIF_FrameConfig fConfig;
+  uint8_t*         pImageData;
+  cgif_result      r;
+  uint8_t          aPalette[] = {
+    0xC0, 0xC0, 0xC0, // grey
+    0x00, 0x00, 0x80, // dark blue
+    0xFF, 0xFF, 0xFF, // white
+    0x00, 0x00, 0x00, // black
+  };
+
+  initGIFConfig(&gConfig, "diff_rects.gif", WIDTH, HEIGHT, aPalette, 4);
+  pGIF = cgif_newgif(&gConfig);
+  if(pGIF == NULL) {
+    fputs("failed to create new GIF via cgif_newgif()\n", stderr);
+    return 1;
+  }
+  pImageData = malloc(WIDTH * HEIGHT);
+  for(int f = 0; f < NUM_FRAMES; ++f) {
+    // background: some windows
+    memset(pImageData, 0, WIDTH * HEIGHT);
+    for(int y = 0; y < HEIGHT; ++y) {
+      for(int x = 0; x < WIDTH; ++x) {
+        if(((x / 40) + (y / 30)) % 3 == 0) {
+          pImageData[y * WIDTH + x] = 1 + ((x ^ y) & 1);
+        }
+      }
+    }
+    // clock: a seven-segment like digit changes every frame
+    drawBox(pImageData, 4, 4, 24, 12, 3);
+    drawBox(pImageData, 6 + 2 * (f % 8), 6, 2, 8, 2);
+    // cursor
+    drawBox(pImageData, 250 + f, 180 + f / 2, 5, 8, 3);
+    initFrameConfig(&fConfig, pImageData, 10);
+    r = cgif_addframe(pGIF, &fConfig);
+    if(r != CGIF_OK) {
+      break;
+    }
+  }
+  free(pImageData);
+  r = cgif_close(pGIF);
+  // check for errors
+  if(r != CGIF_OK) {
+    fprintf(stderr, "failed to create GIF. error code: %d\n", r);
+    return 2;
+  }
+  return 0;
+}
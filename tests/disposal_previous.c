@@ -0,0 +1,146 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "cgif.h"
+#include "test_output.h"
+
+#define WIDTH      120
+#define HEIGHT     80
+#define NUM_FRAMES 24
+
+static const uint8_t aPalette[] = {
+  0xFF, 0xFF, 0xFF, // white
+  0x00, 0x00, 0x00, // black
+  0x20, 0x80, 0x20, // green
+  0xFF, 0xFF, 0xC0, // light yellow
+  0x80, 0x80, 0x80, // grey
+};
+
+/* render frame f: a progress bar that grows slowly, a tooltip that shows up every other frame */
+static void renderFrame(uint8_t* pImageData, int f) {
+  memset(pImageData, 0, WIDTH * HEIGHT);
+  for(int y = 60; y < 70; ++y) {
+    for(int x = 10; x < 10 + 4 * f; ++x) {
+      pImageData[y * WIDTH + x] = 2;
+    }
+  }
+  if(f % 2) {
+    for(int y = 10; y < 40; ++y) {
+      for(int x = 20; x < 100; ++x) {
+        pImageData[y * WIDTH + x] = (y == 10 || y == 39 || x == 20 || x == 99) ? 1 : (((x + y) % 7) ? 3 : 4);
+      }
+    }
+  }
+}
+
+/* decodeGIF callback: compare the canvas with the rendered frame */
+static int checkFrame(void* pContext, const uint32_t* aCanvas, int iFrame) {
+  uint8_t aExpected[WIDTH * HEIGHT];
+  (void)pContext;
+
+  if(iFrame >= NUM_FRAMES) {
+    return -1;
+  }
+  renderFrame(aExpected, iFrame);
+  for(int i = 0; i < WIDTH * HEIGHT; ++i) {
+    const uint8_t c = aExpected[i];
+    if(aCanvas[i] != (((uint32_t)aPalette[3 * c] << 16) | ((uint32_t)aPalette[3 * c + 1] << 8) | aPalette[3 * c + 2])) {
+      fprintf(stderr, "frame %d does not match\n", iFrame);
+      return -1;
+    }
+  }
+  return 0;
+}
+
+/* compare each displayed frame with the rendered frames (reference decoder).
+   returns the number of frames with DISPOSAL_METHOD_PREVIOUS or -1 on mismatch */
+static int checkGIF(const ByteBuffer* pGIF) {
+  const uint8_t* p    = pGIF->pData;
+  const uint8_t* pEnd = pGIF->pData + pGIF->sizeData;
+  int            numPrevious = 0;
+
+  if(decodeGIF(pGIF, checkFrame, NULL) != NUM_FRAMES) {
+    return -1;
+  }
+  // count the graphic control extensions with disposal method 3 (the GIF is valid: decoded above)
+  p += 13 + 3 * (2 << (p[10] & 7)); // skip header and global color table
+  while(p < pEnd && *p != ';') {
+    if(p[0] == '!') {
+      numPrevious += (p[1] == 0xF9 && ((p[3] >> 2) & 7) == 3);
+      p += 2;
+    } else {
+      p += 10 + ((p[9] & 0x80) ? 3 * (2 << (p[9] & 7)) : 0) + 1; // image descriptor, local color table and LZW code size
+    }
+    while(p < pEnd && *p) {
+      p += *p + 1;
+    }
+    ++p;
+  }
+  return numPrevious;
+}
+
+/* create the animation (genFlags: CGIF_GEN_* flags of the GIF) */
+static int createGIF(uint32_t genFlags, ByteBuffer* pOut) {
+  CGIF*            pGIF;
+  CGIF_Config      gConfig;
+  CGIF_FrameConfig fConfig;
+  uint8_t          aImageData[WIDTH * HEIGHT];
+
+  memset(&gConfig, 0, sizeof(CGIF_Config));
+  gConfig.width                   = WIDTH;
+  gConfig.height                  = HEIGHT;
+  gConfig.pGlobalPalette          = (uint8_t*)aPalette;
+  gConfig.numGlobalPaletteEntries = sizeof(aPalette) / 3;
+  gConfig.attrFlags               = CGIF_ATTR_IS_ANIMATED;
+  gConfig.genFlags                = genFlags;
+  gConfig.pWriteFn                = writeFn;
+  gConfig.pContext                = pOut;
+  pGIF = cgif_newgif(&gConfig);
+  if(pGIF == NULL) {
+    return 1;
+  }
+  for(int f = 0; f < NUM_FRAMES; ++f) {
+    renderFrame(aImageData, f);
+    memset(&fConfig, 0, sizeof(CGIF_FrameConfig));
+    fConfig.pImageData = aImageData;
+    fConfig.delay      = 10;
+    fConfig.genFlags   = CGIF_FRAME_GEN_USE_TRANSPARENCY | CGIF_FRAME_GEN_USE_DIFF_WINDOW;
+    cgif_addframe(pGIF, &fConfig);
+  }
+  return (cgif_close(pGIF) == CGIF_OK) ? 0 : 1;
+}
+
+int main(void) {
+  ByteBuffer outLeave    = {NULL, 0};
+  ByteBuffer outPrevious = {NULL, 0};
+  int        r, numPrevious;
+
+  r  = createGIF(0, &outLeave);
+  r |= createGIF(CGIF_GEN_OPTIM_DISPOSAL, &outPrevious);
+  if(r) {
+    fputs("failed to create GIF\n", stderr);
+  }
+  // both variants must show the rendered frames
+  if(!r && checkGIF(&outLeave) != 0) {
+    fputs("reference compositor: output without CGIF_GEN_OPTIM_DISPOSAL does not match\n", stderr);
+    r = 1;
+  }
+  numPrevious = r ? 0 : checkGIF(&outPrevious);
+  if(!r && numPrevious < 0) {
+    fputs("reference compositor: output with CGIF_GEN_OPTIM_DISPOSAL does not match\n", stderr);
+    r = 1;
+  }
+  // the tooltip frames restore the canvas: smaller diff windows for the frames after them
+  if(!r && (numPrevious == 0 || outPrevious.sizeData >= outLeave.sizeData)) {
+    fprintf(stderr, "disposal method not optimized (%d frames with DISPOSAL_METHOD_PREVIOUS, %d bytes vs. %d bytes)\n", numPrevious, (int)outPrevious.sizeData, (int)outLeave.sizeData);
+    r = 1;
+  }
+  if(!r && !writeFile("disposal_previous.gif", &outPrevious)) {
+    r = 1;
+  }
+  free(outLeave.pData);
+  free(outPrevious.pData);
+  return r;
+}
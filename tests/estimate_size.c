@@ -0,0 +1,108 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "cgif.h"
+#include "test_output.h"
+
+#define MAX_REL_ERROR (0.1) // maximum relative error of the estimation for sampled frames
+
+// pContext of the GIF: the output (first member, for writeFn) and the size of the LZW-encoded image data
+typedef struct {
+  ByteBuffer out;
+  uint32_t   sizeRasterData;
+} SizeContext;
+
+static void frameStatsFn(void* pContext, const CGIF_FrameStats* pStats) {
+  ((SizeContext*)pContext)->sizeRasterData = pStats->sizeRasterData;
+}
+
+static uint32_t nextRand(uint32_t* pSeed) {
+  *pSeed = *pSeed * 1103515245 + 12345;
+  return (*pSeed >> 16) & 0x7FFF;
+}
+
+/* get the real size of the LZW-encoded image data */
+static uint32_t getRealSize(uint8_t* pImageData, uint8_t* pPalette, uint16_t width, uint16_t height, uint16_t numColors) {
+  CGIF*            pGIF;
+  CGIF_Config      gConfig;
+  CGIF_FrameConfig fConfig;
+  SizeContext      ctx = {{NULL, 0}, 0};
+
+  memset(&gConfig, 0, sizeof(CGIF_Config));
+  memset(&fConfig, 0, sizeof(CGIF_FrameConfig));
+  gConfig.width                   = width;
+  gConfig.height                  = height;
+  gConfig.pGlobalPalette          = pPalette;
+  gConfig.numGlobalPaletteEntries = numColors;
+  gConfig.pWriteFn                = writeFn;
+  gConfig.pFrameStatsFn           = frameStatsFn;
+  gConfig.pContext                = &ctx;
+  fConfig.pImageData              = pImageData;
+  pGIF = cgif_newgif(&gConfig);
+  if(pGIF == NULL) {
+    return 0;
+  }
+  cgif_addframe(pGIF, &fConfig);
+  if(cgif_close(pGIF) != CGIF_OK) {
+    ctx.sizeRasterData = 0;
+  }
+  free(ctx.out.pData);
+  return ctx.sizeRasterData;
+}
+
+static int checkImage(const char* name, uint8_t* pImageData, uint16_t width, uint16_t height, uint16_t numColors, double maxRelError) {
+  uint8_t  aPalette[256 * 3];
+  uint32_t estSize, realSize;
+  double   relError;
+
+  memset(aPalette, 0, sizeof(aPalette));
+  realSize = getRealSize(pImageData, aPalette, width, height, numColors);
+  if(realSize == 0 || cgif_estimate_size(pImageData, width, height, numColors, &estSize) != CGIF_OK) {
+    fprintf(stderr, "%s: failed to get size\n", name);
+    return 1;
+  }
+  relError = ((double)estSize - realSize) / realSize;
+  if(relError > maxRelError || relError < -maxRelError) {
+    fprintf(stderr, "%s: estimated size %lu, real size %lu\n", name, (unsigned long)estSize, (unsigned long)realSize);
+    return 1;
+  }
+  return 0;
+}
+
+int main(void) {
+  uint8_t* pImageData;
+  uint32_t seed = 7;
+  uint32_t estSize;
+  int      v = 0;
+  int      r = 0;
+
+  pImageData = malloc(1000 * 1000);
+  if(pImageData == NULL) {
+    return 1;
+  }
+  // small frames are not sampled: the estimation must be exact
+  for(int i = 0; i < 100 * 100; ++i) {
+    pImageData[i] = nextRand(&seed) % 6;
+  }
+  r |= checkImage("noise6_100", pImageData, 100, 100, 6, 0.0);
+  // large frames: random walk (little redundancy) and horizontal stripes (high redundancy)
+  for(int i = 0; i < 1000 * 1000; ++i) {
+    v += (int)(nextRand(&seed) % 3) - 1;
+    v  = (v < 0) ? 0 : (v > 63) ? 63 : v;
+    pImageData[i] = v;
+  }
+  r |= checkImage("random_walk_1000", pImageData, 1000, 1000, 64, MAX_REL_ERROR);
+  for(int i = 0; i < 1000 * 1000; ++i) {
+    pImageData[i] = (i / 1000 / 7) % 4;
+  }
+  r |= checkImage("stripes_1000", pImageData, 1000, 1000, 4, MAX_REL_ERROR);
+  // invalid number of colors
+  if(cgif_estimate_size(pImageData, 1000, 1000, 257, &estSize) == CGIF_OK) {
+    fputs("expected error for 257 colors\n", stderr);
+    r = 1;
+  }
+  free(pImageData);
+  return r;
+}
@@ -0,0 +1,109 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "cgif.h"
+#include "test_output.h"
+
+#define WIDTH      120
+#define HEIGHT     90
+#define NUM_FRAMES 16
+#define NUM_COLORS 16
+
+static uint8_t aPalette[NUM_COLORS * 3];
+
+static uint32_t nextRand(uint32_t* pSeed) {
+  *pSeed = *pSeed * 1103515245 + 12345;
+  return (*pSeed >> 16) & 0x7FFF;
+}
+
+/* create the animation: diagonal stripes, a third of the pixels changes from frame to frame (scattered unchanged pixels in between).
+   with hasAlpha: the frames have an alpha channel (no flexible transparency) */
+static cgif_result createGIF(uint32_t frameGenFlags, uint32_t genFlags, int hasAlpha, ByteBuffer* pOut) {
+  CGIF*            pGIF;
+  CGIF_Config      gConfig;
+  CGIF_FrameConfig fConfig;
+  uint8_t          aImageData[WIDTH * HEIGHT];
+  uint32_t         seed = 3;
+
+  memset(&gConfig, 0, sizeof(CGIF_Config));
+  gConfig.width                   = WIDTH;
+  gConfig.height                  = HEIGHT;
+  gConfig.pGlobalPalette          = aPalette;
+  gConfig.numGlobalPaletteEntries = NUM_COLORS;
+  gConfig.attrFlags               = CGIF_ATTR_IS_ANIMATED;
+  gConfig.genFlags                = genFlags;
+  gConfig.pWriteFn                = writeFn;
+  gConfig.pContext                = pOut;
+  pGIF = cgif_newgif(&gConfig);
+  if(pGIF == NULL) {
+    return CGIF_ERROR;
+  }
+  for(int f = 0; f < NUM_FRAMES; ++f) {
+    for(int y = 0; y < HEIGHT; ++y) {
+      for(int x = 0; x < WIDTH; ++x) {
+        uint8_t c = ((x + y) / 12) % 8;
+        if(nextRand(&seed) % 3 == 0) {
+          c = (c + f) % (NUM_COLORS - 1);
+        }
+        aImageData[y * WIDTH + x] = (hasAlpha && x < 4) ? NUM_COLORS - 1 : c;
+      }
+    }
+    memset(&fConfig, 0, sizeof(CGIF_FrameConfig));
+    fConfig.pImageData = aImageData;
+    fConfig.delay      = 5;
+    fConfig.genFlags   = CGIF_FRAME_GEN_USE_TRANSPARENCY | CGIF_FRAME_GEN_USE_DIFF_WINDOW | frameGenFlags;
+    fConfig.attrFlags  = (f % 5 == 4) ? CGIF_FRAME_ATTR_INTERLACED : 0;
+    if(hasAlpha) {
+      fConfig.attrFlags |= CGIF_FRAME_ATTR_HAS_ALPHA;
+      fConfig.transIndex = NUM_COLORS - 1;
+    }
+    cgif_addframe(pGIF, &fConfig);
+  }
+  return cgif_close(pGIF);
+}
+
+int main(void) {
+  ByteBuffer ref   = {NULL, 0};
+  ByteBuffer out   = {NULL, 0};
+  ByteBuffer async = {NULL, 0};
+  int        r = 0;
+
+  for(int c = 0; c < NUM_COLORS; ++c) {
+    aPalette[c * 3]     = c * 16;
+    aPalette[c * 3 + 1] = 255 - c * 16;
+    aPalette[c * 3 + 2] = (c % 4) * 64;
+  }
+  // flexible transparency: smaller than always writing the transparent index (same with the encoder thread)
+  if(createGIF(0, 0, 0, &ref) != CGIF_OK || createGIF(CGIF_FRAME_GEN_USE_FLEX_TRANSPARENCY, 0, 0, &out) != CGIF_OK
+  || createGIF(CGIF_FRAME_GEN_USE_FLEX_TRANSPARENCY, CGIF_GEN_ASYNC_ENCODING, 0, &async) != CGIF_OK) {
+    fputs("failed to create GIF\n", stderr);
+    r = 1;
+  } else if(out.sizeData >= ref.sizeData || !isEqual(&out, &async)) {
+    fprintf(stderr, "unexpected output with flexible transparency: %d vs. %d bytes\n", (int)out.sizeData, (int)ref.sizeData);
+    r = 1;
+  }
+  if(!r && !writeFile("flex_transparency.gif", &out)) {
+    r = 1;
+  }
+  // frames with an alpha channel keep the transparent index (transIndex is a color of the frame)
+  for(int i = 0; !r && i < 2; ++i) {
+    ByteBuffer* pBuf = (i == 0) ? &ref : &out;
+    free(pBuf->pData);
+    pBuf->pData    = NULL;
+    pBuf->sizeData = 0;
+    if(createGIF((i == 0) ? 0 : CGIF_FRAME_GEN_USE_FLEX_TRANSPARENCY, 0, 1, pBuf) != CGIF_OK) {
+      fputs("failed to create GIF with alpha channel\n", stderr);
+      r = 1;
+    }
+  }
+  if(!r && !isEqual(&out, &ref)) {
+    fputs("unexpected output with flexible transparency and alpha channel\n", stderr);
+    r = 1;
+  }
+  free(ref.pData);
+  free(out.pData);
+  free(async.pData);
+  return r;
+}
@@ -0,0 +1,114 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "cgif.h"
+#include "cgif_raw.h"
+#include "test_output.h"
+
+#define WIDTH      64
+#define HEIGHT     64
+#define NUM_FRAMES 50
+#define NUM_WARMUP (2 * (SIZE_FRAME_QUEUE + 1)) // frames until each frame slot (default queue) has held a frame with and without LCT
+
+/* counting allocator */
+static int malloc_count;
+static int free_count;
+
+static void* cgif_test_malloc(size_t size) {
+  ++malloc_count;
+  return malloc(size);
+}
+
+static void cgif_test_free(void* p) {
+  if(p) {
+    ++free_count;
+  }
+  free(p);
+}
+
+/* count the allocations of the frame queue (cgif.c) only: cgif_raw.c uses the regular allocator */
+#include "../src/cgif_raw.c"
+/* avoid duplicate static function names */
+#define calcNextPower2Ex cgif_calcNextPower2Ex
+#define writeFile        cgif_writeFile
+#define malloc(s) cgif_test_malloc(s)
+#define free(p)   cgif_test_free(p)
+#include "../src/cgif.c"
+#undef free
+#undef malloc
+#undef writeFile
+#undef calcNextPower2Ex
+
+int main(void) {
+  CGIF*            pGIF;
+  CGIF_Config      gConfig;
+  CGIF_FrameConfig fConfig;
+  cgif_result      r;
+  ByteBuffer       out = {NULL, 0};
+  int              f, numWarmup;
+  uint8_t          aPalette[] = {
+    0x00, 0x00, 0x00, // black
+    0xFF, 0xFF, 0xFF, // white
+    0xFF, 0x00, 0x00, // red
+  };
+  uint8_t          aImageData[WIDTH * HEIGHT];
+
+  memset(&gConfig, 0, sizeof(gConfig));
+  gConfig.pWriteFn                = writeFn;
+  gConfig.pContext                = &out;
+  gConfig.width                   = WIDTH;
+  gConfig.height                  = HEIGHT;
+  gConfig.pGlobalPalette          = aPalette;
+  gConfig.numGlobalPaletteEntries = 3;
+  gConfig.attrFlags               = CGIF_ATTR_IS_ANIMATED;
+  pGIF = cgif_newgif(&gConfig);
+  if(pGIF == NULL) {
+    fputs("failed to create new GIF via cgif_newgif()\n", stderr);
+    return 1;
+  }
+
+  numWarmup = 0;
+  for(f = 0; f < NUM_FRAMES; ++f) {
+    memset(aImageData, f % 3, sizeof(aImageData));
+    memset(&fConfig, 0, sizeof(fConfig));
+    fConfig.pImageData = aImageData;
+    fConfig.delay      = 10;
+    // mix frames with and without local color table
+    if(f % 2) {
+      fConfig.attrFlags              = CGIF_FRAME_ATTR_USE_LOCAL_TABLE;
+      fConfig.pLocalPalette          = aPalette;
+      fConfig.numLocalPaletteEntries = 3;
+    }
+    if(f == NUM_WARMUP) {
+      numWarmup = malloc_count;
+    }
+    r = cgif_addframe(pGIF, &fConfig);
+    if(r != CGIF_OK) {
+      fprintf(stderr, "unexpected error from cgif_addframe: %d\n", r);
+      cgif_close(pGIF);
+      free(out.pData);
+      return 1;
+    }
+  }
+  // steady state: frame slots and their buffers are recycled
+  if(malloc_count != numWarmup) {
+    fprintf(stderr, "frame queue allocated memory in steady state (%d allocations for %d frames)\n", malloc_count - numWarmup, NUM_FRAMES - NUM_WARMUP);
+    cgif_close(pGIF);
+    free(out.pData);
+    return 1;
+  }
+
+  r = cgif_close(pGIF);
+  free(out.pData);
+  if(r != CGIF_OK) {
+    fprintf(stderr, "unexpected error from cgif_close: %d\n", r);
+    return 1;
+  }
+  if(malloc_count != free_count) {
+    fprintf(stderr, "memory leak in frame queue (malloc: %d, free: %d)\n", malloc_count, free_count);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,110 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "cgif.h"
+#include "test_output.h"
+
+#define WIDTH      120
+#define HEIGHT     80
+#define NUM_FRAMES 29 // not a multiple of the queue sizes: cgif_close flushes a partially filled queue
+
+static const uint8_t aPalette[] = {
+  0xFF, 0xFF, 0xFF, // white
+  0x00, 0x00, 0x00, // black
+  0x20, 0x80, 0x20, // green
+  0xFF, 0xFF, 0xC0, // light yellow
+};
+
+/* render frame f: a growing progress bar, a tooltip that shows up every other frame (every 5th frame is repeated) */
+static void renderFrame(uint8_t* pImageData, int f) {
+  f -= f / 5;
+  memset(pImageData, 0, WIDTH * HEIGHT);
+  for(int y = 60; y < 70; ++y) {
+    for(int x = 10; x < 10 + 4 * f; ++x) {
+      pImageData[y * WIDTH + x] = 2;
+    }
+  }
+  if(f % 2) {
+    for(int y = 10; y < 40; ++y) {
+      for(int x = 20; x < 100; ++x) {
+        pImageData[y * WIDTH + x] = (y == 10 || y == 39 || x == 20 || x == 99) ? 1 : 3;
+      }
+    }
+  }
+}
+
+/* create the animation with the given queue size (0: default) */
+static cgif_result createGIF(uint32_t genFlags, uint16_t sizeFrameQueue, ByteBuffer* pOut) {
+  CGIF*            pGIF;
+  CGIF_Config      gConfig;
+  CGIF_FrameConfig fConfig;
+  uint8_t          aImageData[WIDTH * HEIGHT];
+
+  memset(&gConfig, 0, sizeof(CGIF_Config));
+  gConfig.width                   = WIDTH;
+  gConfig.height                  = HEIGHT;
+  gConfig.pGlobalPalette          = (uint8_t*)aPalette;
+  gConfig.numGlobalPaletteEntries = sizeof(aPalette) / 3;
+  gConfig.attrFlags               = CGIF_ATTR_IS_ANIMATED;
+  gConfig.genFlags                = genFlags;
+  gConfig.pWriteFn                = writeFn;
+  gConfig.pContext                = pOut;
+  gConfig.sizeFrameQueue          = sizeFrameQueue;
+  pGIF = cgif_newgif(&gConfig);
+  if(pGIF == NULL) {
+    return CGIF_ERROR;
+  }
+  for(int f = 0; f < NUM_FRAMES; ++f) {
+    renderFrame(aImageData, f);
+    memset(&fConfig, 0, sizeof(CGIF_FrameConfig));
+    fConfig.pImageData = aImageData;
+    fConfig.delay      = 10;
+    fConfig.genFlags   = CGIF_FRAME_GEN_USE_TRANSPARENCY | CGIF_FRAME_GEN_USE_DIFF_WINDOW;
+    cgif_addframe(pGIF, &fConfig);
+  }
+  return cgif_close(pGIF);
+}
+
+int main(void) {
+  const uint16_t aSizes[] = { 3, 4, 8, 16 };
+  ByteBuffer     outRef      = {NULL, 0}; // default queue, without disposal optimization
+  ByteBuffer     outRefOptim = {NULL, 0}; // default queue, with disposal optimization
+  ByteBuffer     out         = {NULL, 0};
+  int            r = 0;
+
+  if(createGIF(0, 0, &outRef) != CGIF_OK || createGIF(CGIF_GEN_OPTIM_DISPOSAL, 0, &outRefOptim) != CGIF_OK) {
+    fputs("failed to create GIF\n", stderr);
+    r = 1;
+  }
+  // a queue of 2 frames has no lookahead: same output as without the disposal optimization
+  if(!r && (createGIF(CGIF_GEN_OPTIM_DISPOSAL, 2, &out) != CGIF_OK || !isEqual(&out, &outRef))) {
+    fputs("unexpected output with a queue of 2 frames\n", stderr);
+    r = 1;
+  }
+  // larger queues: same output as the default queue (synchronous and with the encoder thread)
+  for(size_t i = 0; !r && i < sizeof(aSizes) / sizeof(aSizes[0]); ++i) {
+    for(int async = 0; !r && async < 2; ++async) {
+      free(out.pData);
+      out.pData    = NULL;
+      out.sizeData = 0;
+      if(createGIF(CGIF_GEN_OPTIM_DISPOSAL | (async ? CGIF_GEN_ASYNC_ENCODING : 0), aSizes[i], &out) != CGIF_OK || !isEqual(&out, &outRefOptim)) {
+        fprintf(stderr, "unexpected output with a queue of %d frames (async: %d)\n", aSizes[i], async);
+        r = 1;
+      }
+    }
+  }
+  // invalid queue sizes
+  if(!r && (createGIF(0, 1, &out) != CGIF_ERROR || createGIF(0, 17, &out) != CGIF_ERROR)) {
+    fputs("invalid queue size accepted\n", stderr);
+    r = 1;
+  }
+  if(!r && !writeFile("frame_queue.gif", &outRefOptim)) {
+    r = 1;
+  }
+  free(outRef.pData);
+  free(outRefOptim.pData);
+  free(out.pData);
+  return r;
+}
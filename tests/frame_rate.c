@@ -0,0 +1,274 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "cgif.h"
+#include "test_output.h"
+
+#define WIDTH       150 // not a multiple of CGIF_TILE_SIZE
+#define HEIGHT      100
+#define NUM_FRAMES  30
+#define MIN_DELAY   4
+#define NUM_TILES_X ((WIDTH + CGIF_TILE_SIZE - 1) / CGIF_TILE_SIZE)
+#define NUM_TILES   (NUM_TILES_X * ((HEIGHT + CGIF_TILE_SIZE - 1) / CGIF_TILE_SIZE))
+
+typedef enum {
+  ADD_FULL,  // cgif_addframe
+  ADD_TILES, // cgif_addframe_tiles (dirty tiles relative to the frame added before)
+  ADD_RECT,  // cgif_addframe_rect (patch of the square)
+} AddMode;
+
+static const uint8_t aPalette[] = {
+  0xFF, 0xFF, 0xFF, // white
+  0x00, 0x00, 0x00, // black
+  0xFF, 0x00, 0x00, // red
+  0x00, 0x00, 0xFF, // blue
+};
+
+/* frame f: a square moving over stripes (the patch: rows 30-49, all columns) */
+static void renderFrame(uint8_t* pImageData, int f) {
+  for(int y = 0; y < HEIGHT; ++y) {
+    for(int x = 0; x < WIDTH; ++x) {
+      pImageData[y * WIDTH + x] = (x >= 4 * f && x < 4 * f + 10 && y >= 30 && y < 50) ? 2 + f % 2 : (x / 8) % 2;
+    }
+  }
+}
+
+static CGIF* newGIF(uint16_t minDelay, uint32_t genFlags, ByteBuffer* pOut) {
+  CGIF_Config gConfig;
+
+  memset(&gConfig, 0, sizeof(CGIF_Config));
+  gConfig.width                   = WIDTH;
+  gConfig.height                  = HEIGHT;
+  gConfig.pGlobalPalette          = (uint8_t*)aPalette;
+  gConfig.numGlobalPaletteEntries = sizeof(aPalette) / 3;
+  gConfig.attrFlags               = CGIF_ATTR_IS_ANIMATED;
+  gConfig.genFlags                = genFlags;
+  gConfig.minDelay                = minDelay;
+  gConfig.pWriteFn                = writeFn;
+  gConfig.pContext                = pOut;
+  return cgif_newgif(&gConfig);
+}
+
+/* add all frames with a delay of 1 (100 fps), capped to MIN_DELAY */
+static cgif_result createGIF(uint32_t genFlags, AddMode mode, ByteBuffer* pOut) {
+  CGIF*            pGIF;
+  CGIF_FrameConfig fConfig;
+  uint8_t          aImageData[WIDTH * HEIGHT];
+  uint8_t          aBefore[WIDTH * HEIGHT];
+  uint8_t          aDirty[NUM_TILES];
+
+  pGIF = newGIF(MIN_DELAY, genFlags, pOut);
+  if(pGIF == NULL) {
+    return CGIF_ERROR;
+  }
+  for(int f = 0; f < NUM_FRAMES; ++f) {
+    renderFrame(aImageData, f);
+    memset(&fConfig, 0, sizeof(CGIF_FrameConfig));
+    fConfig.pImageData = aImageData;
+    fConfig.delay      = 1;
+    fConfig.genFlags   = CGIF_FRAME_GEN_USE_TRANSPARENCY | CGIF_FRAME_GEN_USE_DIFF_WINDOW;
+    if(mode == ADD_RECT && f > 0) {
+      fConfig.pImageData = aImageData + 30 * WIDTH;
+      cgif_addframe_rect(pGIF, &fConfig, 0, 30, WIDTH, 20);
+    } else if(mode == ADD_TILES && f > 0) {
+      for(int t = 0; t < NUM_TILES; ++t) {
+        aDirty[t] = 0;
+      }
+      for(int i = 0; i < WIDTH * HEIGHT; ++i) {
+        if(aImageData[i] != aBefore[i]) {
+          aDirty[(i / WIDTH / CGIF_TILE_SIZE) * NUM_TILES_X + (i % WIDTH) / CGIF_TILE_SIZE] = 1;
+        }
+      }
+      cgif_addframe_tiles(pGIF, &fConfig, aDirty);
+    } else {
+      cgif_addframe(pGIF, &fConfig);
+    }
+    memcpy(aBefore, aImageData, sizeof(aBefore));
+  }
+  return cgif_close(pGIF);
+}
+
+/* reference: no frame rate cap, only every MIN_DELAY-th frame with a delay of MIN_DELAY
+   (the first of each group of frames (drop) or the last one (keep latest)) */
+static cgif_result createModel(int keepLatest, ByteBuffer* pOut) {
+  CGIF*            pGIF;
+  CGIF_FrameConfig fConfig;
+  uint8_t          aImageData[WIDTH * HEIGHT];
+
+  pGIF = newGIF(0, 0, pOut);
+  if(pGIF == NULL) {
+    return CGIF_ERROR;
+  }
+  for(int f = 0; f < NUM_FRAMES; f += MIN_DELAY) {
+    const int last = (f + MIN_DELAY < NUM_FRAMES) ? f + MIN_DELAY - 1 : NUM_FRAMES - 1;
+    renderFrame(aImageData, (keepLatest) ? last : f);
+    memset(&fConfig, 0, sizeof(CGIF_FrameConfig));
+    fConfig.pImageData = aImageData;
+    fConfig.delay      = last - f + 1;
+    fConfig.genFlags   = CGIF_FRAME_GEN_USE_TRANSPARENCY | CGIF_FRAME_GEN_USE_DIFF_WINDOW;
+    cgif_addframe(pGIF, &fConfig);
+  }
+  return cgif_close(pGIF);
+}
+
+/* a patch or user-provided transparency after a dropped frame builds on the dropped frame (it replaces the frame before):
+   same output as adding the dropped frame with both delays and the transparent frame (isSetTrans) resp. the patched frame with all three delays */
+static int checkBaseAfterDrop(int isSetTrans) {
+  CGIF*            pGIF;
+  CGIF_FrameConfig fConfig;
+  ByteBuffer       ref = {NULL, 0};
+  ByteBuffer       out = {NULL, 0};
+  uint8_t          aImageData[WIDTH * HEIGHT];
+  uint8_t          aPatch[10 * 10];
+  int              r = 1;
+
+  memset(aPatch, 3, sizeof(aPatch));
+  for(int isModel = 0; isModel < 2; ++isModel) {
+    pGIF = newGIF((isModel) ? 0 : MIN_DELAY, 0, (isModel) ? &ref : &out);
+    if(pGIF == NULL) {
+      return 0;
+    }
+    memset(&fConfig, 0, sizeof(CGIF_FrameConfig));
+    fConfig.pImageData = aImageData;
+    fConfig.delay      = 1;
+    fConfig.genFlags   = CGIF_FRAME_GEN_USE_TRANSPARENCY | CGIF_FRAME_GEN_USE_DIFF_WINDOW;
+    if(!isModel) {
+      renderFrame(aImageData, 0);
+      cgif_addframe(pGIF, &fConfig);
+    }
+    renderFrame(aImageData, 5);
+    fConfig.delay = (isModel) ? 2 : 1;
+    if(!isModel || isSetTrans) {
+      cgif_addframe(pGIF, &fConfig); // dropped (frame rate cap)
+    }
+    if(isSetTrans) {
+      // the square moves on, the rest is marked as unchanged (index 0)
+      renderFrame(aImageData, 6);
+      for(int i = 0; i < WIDTH * HEIGHT; ++i) {
+        aImageData[i] = (aImageData[i] >= 2) ? aImageData[i] : 0;
+      }
+      fConfig.attrFlags  = CGIF_FRAME_ATTR_HAS_SET_TRANS;
+      fConfig.transIndex = 0;
+      fConfig.delay      = 1;
+      cgif_addframe(pGIF, &fConfig);
+    } else if(isModel) {
+      for(int y = 0; y < 10; ++y) {
+        memcpy(aImageData + (35 + y) * WIDTH + 20, aPatch + y * 10, 10);
+      }
+      fConfig.delay = 3;
+      cgif_addframe(pGIF, &fConfig);
+    } else {
+      fConfig.pImageData = aPatch;
+      cgif_addframe_rect(pGIF, &fConfig, 20, 35, 10, 10);
+    }
+    if(cgif_close(pGIF) != CGIF_OK) {
+      r = 0;
+    }
+  }
+  r = r && isEqual(&out, &ref);
+  free(ref.pData);
+  free(out.pData);
+  return r;
+}
+
+/* a frame with an alpha channel added too early after a frame without one is not capped (it is added as is):
+   same output as without frame rate cap, also if user-provided transparency follows */
+static int checkAlphaAfterOpaque(void) {
+  CGIF*            pGIF;
+  CGIF_FrameConfig fConfig;
+  ByteBuffer       ref = {NULL, 0};
+  ByteBuffer       out = {NULL, 0};
+  uint8_t          aImageData[WIDTH * HEIGHT];
+  int              r = 1;
+
+  for(int isModel = 0; isModel < 2; ++isModel) {
+    pGIF = newGIF((isModel) ? 0 : MIN_DELAY, 0, (isModel) ? &ref : &out);
+    if(pGIF == NULL) {
+      return 0;
+    }
+    memset(&fConfig, 0, sizeof(CGIF_FrameConfig));
+    fConfig.pImageData = aImageData;
+    fConfig.delay      = 1;
+    fConfig.genFlags   = CGIF_FRAME_GEN_USE_TRANSPARENCY | CGIF_FRAME_GEN_USE_DIFF_WINDOW;
+    renderFrame(aImageData, 0);
+    cgif_addframe(pGIF, &fConfig);
+    // the square is transparent (index 2 as alpha channel)
+    renderFrame(aImageData, 2);
+    fConfig.attrFlags  = CGIF_FRAME_ATTR_HAS_ALPHA;
+    fConfig.transIndex = 2;
+    if(cgif_addframe(pGIF, &fConfig) != CGIF_OK) {
+      r = 0;
+    }
+    // the square moves on, the rest is marked as unchanged (index 0)
+    renderFrame(aImageData, 3);
+    for(int i = 0; i < WIDTH * HEIGHT; ++i) {
+      aImageData[i] = (aImageData[i] >= 2) ? aImageData[i] : 0;
+    }
+    fConfig.attrFlags  = CGIF_FRAME_ATTR_HAS_SET_TRANS;
+    fConfig.transIndex = 0;
+    if(cgif_addframe(pGIF, &fConfig) != CGIF_OK) {
+      r = 0;
+    }
+    if(cgif_close(pGIF) != CGIF_OK) {
+      r = 0;
+    }
+  }
+  r = r && isEqual(&out, &ref);
+  free(ref.pData);
+  free(out.pData);
+  return r;
+}
+
+int main(void) {
+  ByteBuffer ref = {NULL, 0};
+  ByteBuffer out = {NULL, 0};
+  int        r = 0;
+
+  // drop (full frames, dirty tiles) and keep latest (full frames, patches): same output as adding the kept frames only
+  // (synchronous and with the encoder thread)
+  for(int keepLatest = 0; !r && keepLatest < 2; ++keepLatest) {
+    free(ref.pData);
+    memset(&ref, 0, sizeof(ref));
+    if(createModel(keepLatest, &ref) != CGIF_OK) {
+      fputs("failed to create GIF\n", stderr);
+      r = 1;
+    }
+    for(int mode = 0; !r && mode < 4; ++mode) {
+      const AddMode  addMode  = (mode % 2 == 0) ? ADD_FULL : (keepLatest) ? ADD_RECT : ADD_TILES;
+      const uint32_t genFlags = ((keepLatest) ? CGIF_GEN_RATE_KEEP_LATEST : 0) | ((mode >= 2) ? CGIF_GEN_ASYNC_ENCODING : 0);
+      free(out.pData);
+      memset(&out, 0, sizeof(out));
+      if(createGIF(genFlags, addMode, &out) != CGIF_OK || !isEqual(&out, &ref)) {
+        fprintf(stderr, "unexpected output with frame rate cap (keep latest: %d, add mode: %d, async: %d)\n", keepLatest, (int)addMode, mode >= 2);
+        r = 1;
+      }
+    }
+    if(!r && !keepLatest && !writeFile("frame_rate.gif", &out)) {
+      r = 1;
+    }
+  }
+  // patches with dropped frames (no CGIF_GEN_RATE_KEEP_LATEST): they replace the frame before as well
+  if(!r) {
+    free(out.pData);
+    memset(&out, 0, sizeof(out));
+    if(createGIF(0, ADD_RECT, &out) != CGIF_OK || !isEqual(&out, &ref)) {
+      fputs("unexpected output with frame rate cap (patches without keep latest)\n", stderr);
+      r = 1;
+    }
+  }
+  for(int isSetTrans = 0; !r && isSetTrans < 2; ++isSetTrans) {
+    if(!checkBaseAfterDrop(isSetTrans)) {
+      fprintf(stderr, "unexpected output after a dropped frame (user-provided transparency: %d)\n", isSetTrans);
+      r = 1;
+    }
+  }
+  if(!r && !checkAlphaAfterOpaque()) {
+    fputs("unexpected output for an alpha channel added too early\n", stderr);
+    r = 1;
+  }
+  free(ref.pData);
+  free(out.pData);
+  return r;
+}
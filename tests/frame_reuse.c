@@ -0,0 +1,110 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "cgif.h"
+#include "test_output.h"
+
+#define WIDTH      100
+#define HEIGHT     100
+#define NUM_PHASES 4   // the animation loops through 4 different frames
+#define NUM_FRAMES 40
+
+// pContext of the GIF: the output (first member, for writeFn) and the number of reused frames
+typedef struct {
+  ByteBuffer buf;
+  int        numReused;
+} Output;
+
+static void frameStatsFn(void* pContext, const CGIF_FrameStats* pStats) {
+  Output* pOut = (Output*)pContext;
+  if(pStats->numVariants == 0) {
+    pOut->numReused++;
+  }
+}
+
+/* render phase p of a spinning bar on a striped background */
+static void renderFrame(uint8_t* pImageData, int p) {
+  int x, y;
+
+  for(y = 0; y < HEIGHT; ++y) {
+    for(x = 0; x < WIDTH; ++x) {
+      pImageData[y * WIDTH + x] = (y / 10) % 2;
+    }
+  }
+  for(int i = -20; i <= 20; ++i) {
+    switch(p) {
+      case 0: x = 50 + i; y = 50;     break;
+      case 1: x = 50 + i; y = 50 + i; break;
+      case 2: x = 50;     y = 50 + i; break;
+      default: x = 50 - i; y = 50 + i; break;
+    }
+    pImageData[y * WIDTH + x] = 2;
+  }
+}
+
+/* create the animation (genFlags: CGIF_GEN_* flags of the GIF) */
+static int createGIF(uint32_t genFlags, Output* pOut) {
+  CGIF*            pGIF;
+  CGIF_Config      gConfig;
+  CGIF_FrameConfig fConfig;
+  uint8_t          aImageData[WIDTH * HEIGHT];
+  uint8_t          aPalette[] = {
+    0xFF, 0xFF, 0xFF, // white
+    0xE0, 0xE0, 0xE0, // light grey
+    0xFF, 0x00, 0x00, // red
+  };
+
+  memset(&gConfig, 0, sizeof(CGIF_Config));
+  gConfig.width                   = WIDTH;
+  gConfig.height                  = HEIGHT;
+  gConfig.pGlobalPalette          = aPalette;
+  gConfig.numGlobalPaletteEntries = 3;
+  gConfig.attrFlags               = CGIF_ATTR_IS_ANIMATED;
+  gConfig.genFlags                = genFlags;
+  gConfig.pWriteFn                = writeFn;
+  gConfig.pFrameStatsFn           = frameStatsFn;
+  gConfig.pContext                = pOut;
+  pGIF = cgif_newgif(&gConfig);
+  if(pGIF == NULL) {
+    return 1;
+  }
+  for(int f = 0; f < NUM_FRAMES; ++f) {
+    renderFrame(aImageData, f % NUM_PHASES);
+    memset(&fConfig, 0, sizeof(CGIF_FrameConfig));
+    fConfig.pImageData = aImageData;
+    fConfig.delay      = 5 + f % 3; // the delay of a reused frame must be the one of the repeat
+    fConfig.genFlags   = CGIF_FRAME_GEN_USE_TRANSPARENCY | CGIF_FRAME_GEN_USE_DIFF_WINDOW;
+    cgif_addframe(pGIF, &fConfig);
+  }
+  return (cgif_close(pGIF) == CGIF_OK) ? 0 : 1;
+}
+
+int main(void) {
+  Output ref   = {{NULL, 0}, 0};
+  Output reuse = {{NULL, 0}, 0};
+  int    r;
+
+  r  = createGIF(0, &ref);
+  r |= createGIF(CGIF_GEN_REUSE_FRAMES, &reuse);
+  if(r) {
+    fputs("failed to create GIF\n", stderr);
+  }
+  // every frame after the first loop is a repeat of a frame pair that was encoded before
+  if(!r && (ref.numReused != 0 || reuse.numReused != NUM_FRAMES - NUM_PHASES - 1)) {
+    fprintf(stderr, "unexpected number of reused frames (%d, expected: %d)\n", reuse.numReused, NUM_FRAMES - NUM_PHASES - 1);
+    r = 1;
+  }
+  // reusing the encoding must not change the output
+  if(!r && !isEqual(&ref.buf, &reuse.buf)) {
+    fputs("output with CGIF_GEN_REUSE_FRAMES differs\n", stderr);
+    r = 1;
+  }
+  if(!r && !writeFile("frame_reuse.gif", &reuse.buf)) {
+    r = 1;
+  }
+  free(ref.buf.pData);
+  free(reuse.buf.pData);
+  return r;
+}
@@ -0,0 +1,88 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "cgif.h"
+
+#define WIDTH      128
+#define HEIGHT     128
+#define NUM_FRAMES 12
+
+/* Small helper functions to initialize GIF- and frame-configuration */
+static void initGIFConfig(CGIF_Config* pConfig, char* path, uint16_t width, uint16_t height, uint8_t* pPalette, uint16_t numColors) {
+  memset(pConfig, 0, sizeof(CGIF_Config));
+  pConfig->width                   = width;
+  pConfig->height                  = height;
+  pConfig->pGlobalPalette          = pPalette;
+  pConfig->numGlobalPaletteEntries = numColors;
+  pConfig->path                    = path;
+  pConfig->attrFlags               = CGIF_ATTR_IS_ANIMATED;
+}
+
+static void initFrameConfig(CGIF_FrameConfig* pConfig, uint8_t* pImageData, uint16_t delay, uint32_t genFlags) {
+  memset(pConfig, 0, sizeof(CGIF_FrameConfig));
+  pConfig->delay      = delay;
+  pConfig->pImageData = pImageData;
+  pConfig->genFlags   = genFlags;
+}
+
+/* This is an example code that creates a GIF-animation with a full color table (256 colors) and transparency optimization:
+   first, a box moves over a background that uses all colors (a free transparent index is found in the table).
+   then, sparse dots that use all colors appear in the box (a transparent index is freed by merging similar colors, lossy). */
+int main(void) {
+  CGIF*            pGIF;
+  CGIF_Config      gConfig;
+  CGIF_FrameConfig fConfig;
+  uint8_t*         pImageData;
+  uint8_t          aPalette[256 * 3];
+  int              cntDots = 0;
+  cgif_result      r;
+
+  // gradient: similar neighbouring colors
+  for(int i = 0; i < 256; ++i) {
+    aPalette[i * 3]     = i;
+    aPalette[i * 3 + 1] = 255 - i;
+    aPalette[i * 3 + 2] = (i * 3) & 0xFF;
+  }
+  initGIFConfig(&gConfig, "full_table_transparency.gif", WIDTH, HEIGHT, aPalette, 256);
+  pGIF = cgif_newgif(&gConfig);
+  if(pGIF == NULL) {
+    fputs("failed to create new GIF via cgif_newgif()\n", stderr);
+    return 1;
+  }
+  pImageData = malloc(WIDTH * HEIGHT);
+  for(int f = 0; f < NUM_FRAMES; ++f) {
+    uint32_t genFlags = CGIF_FRAME_GEN_USE_TRANSPARENCY | CGIF_FRAME_GEN_USE_DIFF_WINDOW;
+    // background: all 256 colors
+    for(int i = 0; i < WIDTH * HEIGHT; ++i) {
+      pImageData[i] = (i / 8) % 256;
+    }
+    for(int y = 32; y < 96; ++y) {
+      for(int x = 4 * f; x < 4 * f + 40; ++x) {
+        if(f < NUM_FRAMES / 2) {
+          pImageData[y * WIDTH + x] = 10 + (x + y) % 4;
+        } else {
+          // sparse dots of all colors (most pixels keep the background)
+          if((x + 3 * y + f) % 6 == 0) {
+            pImageData[y * WIDTH + x] = cntDots++ % 256;
+          }
+          genFlags |= CGIF_FRAME_GEN_USE_LOSSY_TRANSPARENCY;
+        }
+      }
+    }
+    initFrameConfig(&fConfig, pImageData, 10, genFlags);
+    r = cgif_addframe(pGIF, &fConfig);
+    if(r != CGIF_OK) {
+      break;
+    }
+  }
+  free(pImageData);
+  r = cgif_close(pGIF);
+  // check for errors
+  if(r != CGIF_OK) {
+    fprintf(stderr, "failed to create GIF. error code: %d\n", r);
+    return 2;
+  }
+  return 0;
+}
@@ -0,0 +1,162 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "cgif.h"
+#include "test_output.h"
+
+#define WIDTH      100
+#define HEIGHT     100
+#define NUM_FRAMES 30
+#define NUM_COLORS 8
+#define NEW_COLOR  20 // frames from here on use a color that is not in the global color table
+
+// pContext of the GIF: the output (first member, for writeFn) and the number of released frames
+typedef struct {
+  ByteBuffer buf;
+  int        numReleased;
+} Output;
+
+static const uint8_t aColors[] = {
+  0xFF, 0xFF, 0xFF, // white
+  0x00, 0x00, 0x00, // black
+  0xFF, 0x00, 0x00, // red
+  0x00, 0xFF, 0x00, // green
+  0x00, 0x00, 0xFF, // blue
+  0xFF, 0xFF, 0x00, // yellow
+  0x00, 0xFF, 0xFF, // cyan
+  0xFF, 0x00, 0xFF, // magenta
+  0x80, 0x80, 0x80, // grey (NEW_COLOR)
+};
+
+static void releaseFn(void* pContext, uint8_t* pImageData, uint8_t* pLocalPalette) {
+  ((Output*)pContext)->numReleased++;
+  free(pImageData);
+  free(pLocalPalette);
+}
+
+/* render frame f: each frame has its own local color table (same colors in a different order), a square moves over stripes.
+   every 4th frame marks the pixels of the stripes transparent (user-provided transparency). */
+static void renderFrame(uint8_t* pImageData, uint8_t* pLCT, uint16_t* pNumColors, int f) {
+  const uint16_t numColors = (f >= NEW_COLOR) ? NUM_COLORS + 1 : NUM_COLORS;
+
+  for(int i = 0; i < numColors; ++i) {
+    memcpy(pLCT + i * 3, aColors + ((i + f) % numColors) * 3, 3); // LCT index i: color (i + f) % numColors
+  }
+  for(int y = 0; y < HEIGHT; ++y) {
+    for(int x = 0; x < WIDTH; ++x) {
+      const int color = (x >= 2 * f && x < 2 * f + 30 && y >= 30 && y < 60) ? 2 + (x + y) % 6 : (y / 10) % 2 * ((f >= NEW_COLOR) ? 8 : 1);
+      if(f % 4 == 3 && (x < 2 * f - 2 || x >= 2 * f + 30 || y < 30 || y >= 60)) {
+        pImageData[y * WIDTH + x] = numColors; // stripes outside of the squares of this frame and the frame before: unchanged
+      } else {
+        pImageData[y * WIDTH + x] = (color + numColors - f % numColors) % numColors;
+      }
+    }
+  }
+  *pNumColors = numColors;
+}
+
+/* count the frames written with a local color table (returns -1 on error) */
+static int countLocalTables(const Output* pOut) {
+  const uint8_t* p    = pOut->buf.pData;
+  const uint8_t* pEnd = pOut->buf.pData + pOut->buf.sizeData;
+  int            cnt  = 0;
+
+  p += 13 + ((p[10] & 0x80) ? 3 * (2 << (p[10] & 7)) : 0); // skip header and global color table
+  while(p < pEnd && *p != ';') {
+    if(*p == '!') {
+      p += 2;
+    } else if(*p == ',') {
+      cnt += (p[9] & 0x80) ? 1 : 0;
+      p   += 11 + ((p[9] & 0x80) ? 3 * (2 << (p[9] & 7)) : 0);
+    } else {
+      return -1;
+    }
+    while(p < pEnd && *p) {
+      p += *p + 1;
+    }
+    ++p;
+  }
+  return cnt;
+}
+
+/* create the animation: every 5th frame is borrowed */
+static int createGIF(uint32_t genFlags, uint16_t sizeFrameQueue, Output* pOut) {
+  CGIF*            pGIF;
+  CGIF_Config      gConfig;
+  CGIF_FrameConfig fConfig;
+  uint8_t          aImageData[WIDTH * HEIGHT];
+  uint8_t          aLCT[(NUM_COLORS + 1) * 3];
+
+  memset(&gConfig, 0, sizeof(CGIF_Config));
+  gConfig.width          = WIDTH;
+  gConfig.height         = HEIGHT;
+  gConfig.attrFlags      = CGIF_ATTR_IS_ANIMATED | CGIF_ATTR_NO_GLOBAL_TABLE;
+  gConfig.genFlags       = genFlags;
+  gConfig.pWriteFn       = writeFn;
+  gConfig.pContext       = pOut;
+  gConfig.sizeFrameQueue = sizeFrameQueue;
+  pGIF = cgif_newgif(&gConfig);
+  if(pGIF == NULL) {
+    return 1;
+  }
+  for(int f = 0; f < NUM_FRAMES; ++f) {
+    memset(&fConfig, 0, sizeof(CGIF_FrameConfig));
+    fConfig.pImageData    = aImageData;
+    fConfig.pLocalPalette = aLCT;
+    fConfig.attrFlags     = CGIF_FRAME_ATTR_USE_LOCAL_TABLE;
+    fConfig.delay         = 5;
+    fConfig.genFlags      = CGIF_FRAME_GEN_USE_TRANSPARENCY | CGIF_FRAME_GEN_USE_DIFF_WINDOW;
+    if(f % 5 == 0) {
+      fConfig.pImageData    = malloc(WIDTH * HEIGHT);
+      fConfig.pLocalPalette = malloc(sizeof(aLCT));
+    }
+    renderFrame(fConfig.pImageData, fConfig.pLocalPalette, &fConfig.numLocalPaletteEntries, f);
+    if(f % 4 == 3) {
+      fConfig.attrFlags  |= CGIF_FRAME_ATTR_HAS_SET_TRANS;
+      fConfig.transIndex  = fConfig.numLocalPaletteEntries;
+    }
+    if(f % 5 == 0) {
+      cgif_addframe_borrow(pGIF, &fConfig, releaseFn, pOut);
+    } else {
+      cgif_addframe(pGIF, &fConfig);
+    }
+  }
+  return (cgif_close(pGIF) == CGIF_OK) ? 0 : 1;
+}
+
+int main(void) {
+  Output outLocal = {{NULL, 0}, 0};
+  Output outGCT   = {{NULL, 0}, 0};
+  Output outQueue = {{NULL, 0}, 0};
+  int    r;
+
+  r  = createGIF(0, 0, &outLocal);
+  r |= createGIF(CGIF_GEN_HOIST_GLOBAL_TABLE, 0, &outGCT);
+  r |= createGIF(CGIF_GEN_HOIST_GLOBAL_TABLE, 8, &outQueue);
+  if(r) {
+    fputs("failed to create GIF\n", stderr);
+  }
+  // each borrowed frame must be released exactly once (hoisted frames right away)
+  if(!r && (outLocal.numReleased != NUM_FRAMES / 5 || outGCT.numReleased != NUM_FRAMES / 5 || outQueue.numReleased != NUM_FRAMES / 5)) {
+    fputs("invalid release of borrowed frames\n", stderr);
+    r = 1;
+  }
+  // all frames before NEW_COLOR share the global color table
+  if(!r && (countLocalTables(&outLocal) != NUM_FRAMES || countLocalTables(&outGCT) != NUM_FRAMES - NEW_COLOR || countLocalTables(&outQueue) != NUM_FRAMES - NEW_COLOR)) {
+    fprintf(stderr, "unexpected number of local color tables (%d, %d, %d)\n", countLocalTables(&outLocal), countLocalTables(&outGCT), countLocalTables(&outQueue));
+    r = 1;
+  }
+  if(!r && outGCT.buf.sizeData >= outLocal.buf.sizeData) {
+    fprintf(stderr, "global color table not smaller (%d bytes vs. %d bytes)\n", (int)outGCT.buf.sizeData, (int)outLocal.buf.sizeData);
+    r = 1;
+  }
+  if(!r && !writeFile("global_table_hoisting.gif", &outGCT.buf)) {
+    r = 1;
+  }
+  free(outLocal.buf.pData);
+  free(outGCT.buf.pData);
+  free(outQueue.buf.pData);
+  return r;
+}
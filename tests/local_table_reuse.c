@@ -0,0 +1,142 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "cgif.h"
+#include "test_output.h"
+
+#define WIDTH      100
+#define HEIGHT     100
+#define NUM_FRAMES 24
+#define NUM_COLORS 16
+
+// pContext of the GIF: the output (first member, for writeFn) and the state of the released frames
+typedef struct {
+  ByteBuffer buf;
+  int        numReleased;
+  int        error;
+} Output;
+
+static void releaseFn(void* pContext, uint8_t* pImageData, uint8_t* pLocalPalette) {
+  Output* pOut = (Output*)pContext;
+  if(pImageData == NULL || pLocalPalette == NULL) {
+    pOut->error = 1; // buffers must be handed back as passed
+  }
+  pOut->numReleased++;
+  free(pImageData);
+  free(pLocalPalette);
+}
+
+/* count the frames written with a local color table (returns -1 on error) */
+static int countLocalTables(const Output* pOut) {
+  const uint8_t* p    = pOut->buf.pData;
+  const uint8_t* pEnd = pOut->buf.pData + pOut->buf.sizeData;
+  int            cnt  = 0;
+
+  p += 13 + ((p[10] & 0x80) ? 3 * (2 << (p[10] & 7)) : 0); // skip header and global color table
+  while(p < pEnd && *p != ';') {
+    if(*p == '!') {
+      p += 2;
+    } else if(*p == ',') {
+      cnt += (p[9] & 0x80) ? 1 : 0;
+      p   += 11 + ((p[9] & 0x80) ? 3 * (2 << (p[9] & 7)) : 0);
+    } else {
+      return -1;
+    }
+    while(p < pEnd && *p) {
+      p += *p + 1;
+    }
+    ++p;
+  }
+  return cnt;
+}
+
+/* render frame f (colors of the global color table): a square moving over a gradient.
+   the local color table of the frame is:
+   f % 3 == 0: the global color table (fixed-palette producer, borrowed frame)
+   f % 3 == 1: the global color table in reverse order (indices are remapped), with user-provided transparency every other time
+   f % 3 == 2: the global color table with the color of the square replaced (kept as local color table) */
+static void renderFrame(CGIF_FrameConfig* pConfig, const uint8_t* pGCT, int f) {
+  for(int c = 0; c < NUM_COLORS; ++c) {
+    const int iLCT = (f % 3 == 1) ? NUM_COLORS - 1 - c : c;
+    memcpy(pConfig->pLocalPalette + iLCT * 3, pGCT + c * 3, 3);
+  }
+  if(f % 3 == 2) {
+    pConfig->pLocalPalette[15 * 3] ^= 0x40; // color of the square
+  }
+  for(int y = 0; y < HEIGHT; ++y) {
+    for(int x = 0; x < WIDTH; ++x) {
+      const int c    = (x >= 3 * f && x < 3 * f + 20 && y >= 40 && y < 60) ? 15 : 1 + (x + y) / 15 % 14;
+      const int iLCT = (f % 3 == 1) ? NUM_COLORS - 1 - c : c;
+      pConfig->pImageData[y * WIDTH + x] = (f % 6 == 4 && (x < 3 * f - 3 || x >= 3 * f + 20)) ? NUM_COLORS : iLCT;
+    }
+  }
+  pConfig->numLocalPaletteEntries = NUM_COLORS;
+  pConfig->attrFlags              = CGIF_FRAME_ATTR_USE_LOCAL_TABLE;
+  if(f % 6 == 4) {
+    pConfig->attrFlags  |= CGIF_FRAME_ATTR_HAS_SET_TRANS; // pixels outside of the squares are unchanged
+    pConfig->transIndex  = NUM_COLORS;
+  }
+}
+
+int main(void) {
+  CGIF*            pGIF;
+  CGIF_Config      gConfig;
+  CGIF_FrameConfig fConfig;
+  Output           out = {{NULL, 0}, 0, 0};
+  uint8_t          aImageData[WIDTH * HEIGHT];
+  uint8_t          aLCT[NUM_COLORS * 3];
+  uint8_t          aGCT[NUM_COLORS * 3];
+  int              r = 0;
+
+  for(int c = 0; c < NUM_COLORS; ++c) {
+    aGCT[c * 3]     = c * 16;
+    aGCT[c * 3 + 1] = 255 - c * 16;
+    aGCT[c * 3 + 2] = 128;
+  }
+  memset(&gConfig, 0, sizeof(CGIF_Config));
+  gConfig.width                   = WIDTH;
+  gConfig.height                  = HEIGHT;
+  gConfig.pGlobalPalette          = aGCT;
+  gConfig.numGlobalPaletteEntries = NUM_COLORS;
+  gConfig.attrFlags               = CGIF_ATTR_IS_ANIMATED;
+  gConfig.pWriteFn                = writeFn;
+  gConfig.pContext                = &out;
+  pGIF = cgif_newgif(&gConfig);
+  if(pGIF == NULL) {
+    fputs("failed to create new GIF via cgif_newgif()\n", stderr);
+    return 1;
+  }
+  for(int f = 0; f < NUM_FRAMES; ++f) {
+    memset(&fConfig, 0, sizeof(CGIF_FrameConfig));
+    fConfig.pImageData    = (f % 3 == 0) ? malloc(WIDTH * HEIGHT) : aImageData;
+    fConfig.pLocalPalette = (f % 3 == 0) ? malloc(sizeof(aLCT)) : aLCT;
+    fConfig.delay         = 5;
+    fConfig.genFlags      = CGIF_FRAME_GEN_USE_TRANSPARENCY | CGIF_FRAME_GEN_USE_DIFF_WINDOW;
+    renderFrame(&fConfig, aGCT, f);
+    if(f % 3 == 0) {
+      cgif_addframe_borrow(pGIF, &fConfig, releaseFn, &out);
+    } else {
+      cgif_addframe(pGIF, &fConfig);
+    }
+  }
+  if(cgif_close(pGIF) != CGIF_OK) {
+    fputs("failed to create GIF\n", stderr);
+    r = 1;
+  }
+  if(!r && (out.error || out.numReleased != NUM_FRAMES / 3)) {
+    fputs("invalid release of borrowed frames\n", stderr);
+    r = 1;
+  }
+  // only the local color tables with a color that is not in the global color table are written
+  if(!r && countLocalTables(&out) != NUM_FRAMES / 3) {
+    fprintf(stderr, "unexpected number of local color tables (%d, expected: %d)\n", countLocalTables(&out), NUM_FRAMES / 3);
+    r = 1;
+  }
+  if(!r && !writeFile("local_table_reuse.gif", &out.buf)) {
+    r = 1;
+  }
+  free(out.buf.pData);
+  return r;
+}
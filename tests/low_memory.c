@@ -0,0 +1,144 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "cgif.h"
+#include "test_output.h"
+
+#define WIDTH      100
+#define HEIGHT     80
+#define NUM_FRAMES 12
+
+static const uint8_t aPalette[] = {
+  0xFF, 0xFF, 0xFF, // white
+  0x00, 0x00, 0x00, // black
+  0xFF, 0x00, 0x00, // red
+  0x00, 0x00, 0xFF, // blue
+};
+
+/* create the animation: a square moving over stripes. with hasTransparency: first color is transparent (global alpha channel),
+   otherwise every 3rd frame has an alpha channel (transparent border) */
+static cgif_result createGIF(uint32_t genFlags, uint16_t sizeFrameQueue, int hasTransparency, ByteBuffer* pOut) {
+  CGIF*            pGIF;
+  CGIF_Config      gConfig;
+  CGIF_FrameConfig fConfig;
+  uint8_t          aImageData[WIDTH * HEIGHT];
+
+  memset(&gConfig, 0, sizeof(CGIF_Config));
+  gConfig.width                   = WIDTH;
+  gConfig.height                  = HEIGHT;
+  gConfig.pGlobalPalette          = (uint8_t*)aPalette;
+  gConfig.numGlobalPaletteEntries = sizeof(aPalette) / 3;
+  gConfig.attrFlags               = CGIF_ATTR_IS_ANIMATED | ((hasTransparency) ? CGIF_ATTR_HAS_TRANSPARENCY : 0);
+  gConfig.genFlags                = genFlags;
+  gConfig.sizeFrameQueue          = sizeFrameQueue;
+  gConfig.pWriteFn                = writeFn;
+  gConfig.pContext                = pOut;
+  pGIF = cgif_newgif(&gConfig);
+  if(pGIF == NULL) {
+    return CGIF_ERROR;
+  }
+  for(int f = 0; f < NUM_FRAMES; ++f) {
+    const int hasAlpha = !hasTransparency && (f % 3 == 2);
+    for(int y = 0; y < HEIGHT; ++y) {
+      for(int x = 0; x < WIDTH; ++x) {
+        uint8_t c = 1 + (x / 8) % 2;
+        if(x >= 6 * f && x < 6 * f + 10 && y >= 30 && y < 40) {
+          c = 3;
+        } else if(hasAlpha && (x < 5 || y < 5)) {
+          c = 0;
+        }
+        aImageData[y * WIDTH + x] = c;
+      }
+    }
+    memset(&fConfig, 0, sizeof(CGIF_FrameConfig));
+    fConfig.pImageData = aImageData;
+    fConfig.delay      = 5;
+    fConfig.genFlags   = CGIF_FRAME_GEN_USE_TRANSPARENCY | CGIF_FRAME_GEN_USE_DIFF_WINDOW;
+    if(hasAlpha) {
+      fConfig.attrFlags  = CGIF_FRAME_ATTR_HAS_ALPHA;
+      fConfig.transIndex = 0;
+    }
+    cgif_addframe(pGIF, &fConfig);
+  }
+  return cgif_close(pGIF);
+}
+
+/* create an RGBA animation (moving square, transparent border in every 4th frame) */
+static cgif_result createRGB(uint32_t genFlags) {
+  CGIFrgb*            pGIF;
+  CGIFrgb_Config      gConfig;
+  CGIFrgb_FrameConfig fConfig;
+  ByteBuffer          out = {NULL, 0};
+  uint8_t*            pImageData = malloc(WIDTH * HEIGHT * 4);
+  cgif_result         r;
+
+  if(pImageData == NULL) {
+    return CGIF_EALLOC;
+  }
+  memset(&gConfig, 0, sizeof(gConfig));
+  gConfig.width    = WIDTH;
+  gConfig.height   = HEIGHT;
+  gConfig.genFlags = genFlags;
+  gConfig.pWriteFn = writeFn;
+  gConfig.pContext = &out;
+  pGIF = cgif_rgb_newgif(&gConfig);
+  if(pGIF == NULL) {
+    free(pImageData);
+    return CGIF_ERROR;
+  }
+  for(int f = 0; f < NUM_FRAMES; ++f) {
+    for(int i = 0; i < WIDTH * HEIGHT; ++i) {
+      const int x = i % WIDTH, y = i / WIDTH;
+      const int isSquare = (x >= 6 * f && x < 6 * f + 10 && y >= 30 && y < 40);
+      pImageData[i * 4]     = (isSquare) ? 0 : x * 2;
+      pImageData[i * 4 + 1] = (isSquare) ? 0 : y * 3;
+      pImageData[i * 4 + 2] = (isSquare) ? 255 : (x + y);
+      pImageData[i * 4 + 3] = (f % 4 == 3 && x < 5) ? 0 : 255;
+    }
+    memset(&fConfig, 0, sizeof(fConfig));
+    fConfig.pImageData = pImageData;
+    fConfig.fmtChan    = CGIF_CHAN_FMT_RGBA;
+    fConfig.delay      = 5;
+    cgif_rgb_addframe(pGIF, &fConfig);
+  }
+  r = cgif_rgb_close(pGIF);
+  free(pImageData);
+  free(out.pData);
+  return r;
+}
+
+int main(void) {
+  ByteBuffer ref = {NULL, 0};
+  ByteBuffer out = {NULL, 0};
+  int        r = 0;
+
+  // without lookahead (no CGIF_GEN_OPTIM_DISPOSAL): same output as the default frame queue,
+  // also with an alpha channel (the disposal method of the frame before is changed before it is written)
+  for(int hasTransparency = 0; !r && hasTransparency < 2; ++hasTransparency) {
+    for(int mode = 0; !r && mode < 3; ++mode) {
+      const uint32_t genFlags = (mode == 1) ? CGIF_GEN_LOW_MEMORY : (mode == 2) ? CGIF_GEN_LOW_MEMORY | CGIF_GEN_ASYNC_ENCODING : 0;
+      ByteBuffer*    pBuf     = (mode == 0) ? &ref : &out;
+      free(pBuf->pData);
+      pBuf->pData    = NULL;
+      pBuf->sizeData = 0;
+      // sizeFrameQueue is ignored in low memory mode
+      if(createGIF(genFlags, (mode == 0) ? 0 : 8, hasTransparency, pBuf) != CGIF_OK || (mode && !isEqual(&out, &ref))) {
+        fprintf(stderr, "unexpected output in low memory mode (transparency: %d, async: %d)\n", hasTransparency, mode == 2);
+        r = 1;
+      }
+    }
+    if(!r && !hasTransparency && !writeFile("low_memory.gif", &out)) {
+      r = 1;
+    }
+  }
+  // RGB API without a copy of the frame before
+  if(!r && createRGB(CGIF_GEN_LOW_MEMORY) != CGIF_OK) {
+    fputs("failed to create RGB GIF in low memory mode\n", stderr);
+    r = 1;
+  }
+  free(ref.pData);
+  free(out.pData);
+  return r;
+}
@@ -0,0 +1,168 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "cgif.h"
+#include "cgif_raw.h"
+#include "test_output.h"
+
+#define WIDTH      160
+#define HEIGHT     120
+#define NUM_FRAMES 16
+
+static const uint8_t aPalette[] = {
+  0xFF, 0xFF, 0xFF, // white
+  0x00, 0x00, 0x00, // black
+  0xFF, 0x00, 0x00, // red
+  0x00, 0x00, 0xFF, // blue
+  0x00, 0xFF, 0x00, // green
+};
+
+/* create the animation (a square moving over stripes, every 4th frame with a local color table):
+   to memory (pWriteFn == NULL) or via pWriteFn. returns the result of cgif_take_output resp. cgif_close */
+static cgif_result createGIF(uint32_t genFlags, uint32_t sizeOutputHint, cgif_write_fn* pWriteFn, ByteBuffer* pOut) {
+  CGIF*            pGIF;
+  CGIF_Config      gConfig;
+  CGIF_FrameConfig fConfig;
+  uint8_t          aImageData[WIDTH * HEIGHT];
+  uint8_t          aLCT[sizeof(aPalette)];
+  cgif_result      r;
+
+  memset(&gConfig, 0, sizeof(CGIF_Config));
+  gConfig.width                   = WIDTH;
+  gConfig.height                  = HEIGHT;
+  gConfig.pGlobalPalette          = (uint8_t*)aPalette;
+  gConfig.numGlobalPaletteEntries = sizeof(aPalette) / 3;
+  gConfig.attrFlags               = CGIF_ATTR_IS_ANIMATED;
+  gConfig.genFlags                = genFlags | ((pWriteFn) ? 0 : CGIF_GEN_MEMORY_OUTPUT);
+  gConfig.sizeOutputHint          = sizeOutputHint;
+  gConfig.pWriteFn                = pWriteFn;
+  gConfig.pContext                = pOut;
+  pGIF = cgif_newgif(&gConfig);
+  if(pGIF == NULL) {
+    return CGIF_ERROR;
+  }
+  for(int i = 0; i < (int)sizeof(aLCT); ++i) {
+    aLCT[i] = 255 - aPalette[i];
+  }
+  for(int f = 0; f < NUM_FRAMES; ++f) {
+    for(int y = 0; y < HEIGHT; ++y) {
+      for(int x = 0; x < WIDTH; ++x) {
+        aImageData[y * WIDTH + x] = (x >= 8 * f && x < 8 * f + 16 && y >= 40 && y < 60) ? 2 + f % 3 : (x / 6 + y / 10) % 2;
+      }
+    }
+    memset(&fConfig, 0, sizeof(CGIF_FrameConfig));
+    fConfig.pImageData = aImageData;
+    fConfig.delay      = 5;
+    fConfig.genFlags   = CGIF_FRAME_GEN_USE_TRANSPARENCY | CGIF_FRAME_GEN_USE_DIFF_WINDOW;
+    if(f % 4 == 3) {
+      fConfig.attrFlags              = CGIF_FRAME_ATTR_USE_LOCAL_TABLE;
+      fConfig.pLocalPalette          = aLCT;
+      fConfig.numLocalPaletteEntries = sizeof(aLCT) / 3;
+    }
+    cgif_addframe(pGIF, &fConfig);
+  }
+  if(pWriteFn) {
+    return cgif_close(pGIF);
+  }
+  r = cgif_take_output(pGIF, &pOut->pData, &pOut->sizeData);
+  // no more frames after the output is handed over
+  if(cgif_addframe(pGIF, &fConfig) != CGIF_ERROR) {
+    r = CGIF_ERROR;
+  }
+  if(cgif_close(pGIF) != r) {
+    r = CGIF_ERROR;
+  }
+  return r;
+}
+
+/* raw API: one frame to memory or via pWriteFn (returns the result of cgif_raw_close) */
+static cgif_result createRawGIF(int isMemory, ByteBuffer* pOut) {
+  CGIFRaw*            pGIF;
+  CGIFRaw_Config      gConfig;
+  CGIFRaw_FrameConfig fConfig;
+  uint8_t             aImageData[WIDTH * HEIGHT];
+  cgif_result         r = CGIF_OK;
+
+  memset(&gConfig, 0, sizeof(gConfig));
+  gConfig.attrFlags      = (isMemory) ? CGIF_RAW_ATTR_MEMORY_OUTPUT : 0;
+  gConfig.sizeOutputHint = (isMemory) ? 100 : 0; // smaller than the GIF: grows
+  gConfig.pWriteFn       = (isMemory) ? NULL : writeFn;
+  gConfig.pContext       = pOut;
+  gConfig.pGCT           = (uint8_t*)aPalette;
+  gConfig.sizeGCT        = sizeof(aPalette) / 3;
+  gConfig.width          = WIDTH;
+  gConfig.height         = HEIGHT;
+  pGIF = cgif_raw_newgif(&gConfig);
+  if(pGIF == NULL) {
+    return CGIF_ERROR;
+  }
+  for(int i = 0; i < WIDTH * HEIGHT; ++i) {
+    aImageData[i] = (i / 7) % 5;
+  }
+  memset(&fConfig, 0, sizeof(fConfig));
+  fConfig.pImageData = aImageData;
+  fConfig.width      = WIDTH;
+  fConfig.height     = HEIGHT;
+  cgif_raw_addframe(pGIF, &fConfig);
+  if(isMemory) {
+    r = cgif_raw_takeoutput(pGIF, &pOut->pData, &pOut->sizeData);
+  }
+  return (cgif_raw_close(pGIF) == CGIF_OK) ? r : CGIF_ERROR;
+}
+
+int main(void) {
+  ByteBuffer  ref = {NULL, 0};
+  ByteBuffer  out = {NULL, 0};
+  CGIF_Config gConfig;
+  int         r = 0;
+
+  if(createGIF(0, 0, writeFn, &ref) != CGIF_OK) {
+    fputs("failed to create GIF\n", stderr);
+    r = 1;
+  }
+  // default size, a size hint smaller than the GIF (grows) and larger than the GIF, with the encoder thread: same bytes as via pWriteFn
+  for(int mode = 0; !r && mode < 4; ++mode) {
+    const uint32_t sizeOutputHint = (mode == 1) ? 1 : (mode == 2) ? 1000000 : 0;
+    const uint32_t genFlags       = (mode == 3) ? CGIF_GEN_ASYNC_ENCODING : 0;
+    free(out.pData);
+    memset(&out, 0, sizeof(out));
+    if(createGIF(genFlags, sizeOutputHint, NULL, &out) != CGIF_OK || !isEqual(&out, &ref)) {
+      fprintf(stderr, "unexpected memory output (size hint: %d, flags: %d)\n", (int)sizeOutputHint, (int)genFlags);
+      r = 1;
+    }
+  }
+  if(!r && !writeFile("memory_output.gif", &out)) {
+    r = 1;
+  }
+  // raw API
+  for(int i = 0; !r && i < 2; ++i) {
+    ByteBuffer* pBuf = (i == 0) ? &ref : &out;
+    free(pBuf->pData);
+    memset(pBuf, 0, sizeof(ByteBuffer));
+    if(createRawGIF(i, pBuf) != CGIF_OK) {
+      fputs("failed to create raw GIF\n", stderr);
+      r = 1;
+    }
+  }
+  if(!r && !isEqual(&out, &ref)) {
+    fputs("unexpected memory output of the raw API\n", stderr);
+    r = 1;
+  }
+  // memory output and a write callback at the same time
+  memset(&gConfig, 0, sizeof(CGIF_Config));
+  gConfig.width                   = WIDTH;
+  gConfig.height                  = HEIGHT;
+  gConfig.pGlobalPalette          = (uint8_t*)aPalette;
+  gConfig.numGlobalPaletteEntries = sizeof(aPalette) / 3;
+  gConfig.genFlags                = CGIF_GEN_MEMORY_OUTPUT;
+  gConfig.pWriteFn                = writeFn;
+  if(!r && cgif_newgif(&gConfig) != NULL) {
+    fputs("memory output with pWriteFn not rejected\n", stderr);
+    r = 1;
+  }
+  free(ref.pData);
+  free(out.pData);
+  return r;
+}
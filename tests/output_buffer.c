@@ -0,0 +1,95 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "cgif.h"
+#include "test_output.h"
+
+#define WIDTH      200
+#define HEIGHT     150
+#define NUM_FRAMES 20
+
+static const uint8_t aPalette[] = {
+  0xFF, 0xFF, 0xFF, // white
+  0x00, 0x00, 0x00, // black
+  0xFF, 0x00, 0x00, // red
+  0x00, 0xFF, 0x00, // green
+};
+
+/* create the animation (a square moving over noise) at path */
+static cgif_result createGIF(const char* path, uint32_t sizeOutputBuffer, uint32_t genFlags) {
+  CGIF*            pGIF;
+  CGIF_Config      gConfig;
+  CGIF_FrameConfig fConfig;
+  uint8_t          aImageData[WIDTH * HEIGHT];
+  uint32_t         seed = 5;
+
+  memset(&gConfig, 0, sizeof(CGIF_Config));
+  gConfig.width                   = WIDTH;
+  gConfig.height                  = HEIGHT;
+  gConfig.pGlobalPalette          = (uint8_t*)aPalette;
+  gConfig.numGlobalPaletteEntries = sizeof(aPalette) / 3;
+  gConfig.attrFlags               = CGIF_ATTR_IS_ANIMATED;
+  gConfig.genFlags                = genFlags;
+  gConfig.sizeOutputBuffer        = sizeOutputBuffer;
+  gConfig.path                    = path;
+  pGIF = cgif_newgif(&gConfig);
+  if(pGIF == NULL) {
+    return CGIF_ERROR;
+  }
+  for(int f = 0; f < NUM_FRAMES; ++f) {
+    for(int i = 0; i < WIDTH * HEIGHT; ++i) {
+      const int x = i % WIDTH, y = i / WIDTH;
+      seed = seed * 1103515245 + 12345;
+      aImageData[i] = (x >= 8 * f && x < 8 * f + 20 && y >= 60 && y < 80) ? 2 : (f % 4 == 0) ? (seed >> 16) % 2 : aImageData[i];
+    }
+    memset(&fConfig, 0, sizeof(CGIF_FrameConfig));
+    fConfig.pImageData = aImageData;
+    fConfig.delay      = 5;
+    fConfig.genFlags   = CGIF_FRAME_GEN_USE_TRANSPARENCY | CGIF_FRAME_GEN_USE_DIFF_WINDOW;
+    cgif_addframe(pGIF, &fConfig);
+  }
+  return cgif_close(pGIF);
+}
+
+int main(void) {
+  ByteBuffer ref = {NULL, 0};
+  ByteBuffer out = {NULL, 0};
+  FILE*      pFull;
+  int        r = 0;
+
+  // reference: written through stdio
+  if(createGIF("output_buffer_ref.gif", 0, CGIF_GEN_NO_OUTPUT_BUFFER) != CGIF_OK || !readFile("output_buffer_ref.gif", &ref)) {
+    fputs("failed to create GIF without output buffer\n", stderr);
+    r = 1;
+  }
+  // default buffer, a buffer smaller than most pieces of data (written directly), page cache hints, the encoder thread and the writer thread
+  // (default buffers, buffers smaller than most pieces of data (split up in order), with the encoder thread): same bytes
+  for(int mode = 0; !r && mode < 8; ++mode) {
+    static const uint32_t aSize[]  = {0, 64, 4096, 0, 0, 64, 1024, 0};
+    static const uint32_t aFlags[] = {0, 0, CGIF_GEN_OUTPUT_HINTS, CGIF_GEN_ASYNC_ENCODING,
+                                      CGIF_GEN_ASYNC_OUTPUT, CGIF_GEN_ASYNC_OUTPUT, CGIF_GEN_ASYNC_OUTPUT, CGIF_GEN_ASYNC_OUTPUT | CGIF_GEN_ASYNC_ENCODING};
+    free(out.pData);
+    memset(&out, 0, sizeof(out));
+    if(createGIF("output_buffer.gif", aSize[mode], aFlags[mode]) != CGIF_OK || !readFile("output_buffer.gif", &out) || !isEqual(&out, &ref)) {
+      fprintf(stderr, "unexpected output with output buffer of %d bytes (flags: %d)\n", (int)aSize[mode], (int)aFlags[mode]);
+      r = 1;
+    }
+  }
+  remove("output_buffer_ref.gif");
+  // the error of the last write (cgif_close) is reported as well, errors of the writer thread by cgif_addframe / cgif_close
+  pFull = fopen("/dev/full", "wb");
+  for(int mode = 0; !r && pFull && mode < 3; ++mode) {
+    if(createGIF("/dev/full", (mode == 2) ? 64 : 0, (mode == 0) ? 0 : CGIF_GEN_ASYNC_OUTPUT) != CGIF_EWRITE) {
+      fputs("CGIF_EWRITE expected as result code\n", stderr);
+      r = 1;
+    }
+  }
+  if(pFull) {
+    fclose(pFull);
+  }
+  free(ref.pData);
+  free(out.pData);
+  return r;
+}
@@ -0,0 +1,132 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "cgif_raw.h"
+#include "test_output.h"
+
+#define WIDTH    300
+#define HEIGHT   260 // > EST_MAX_FULL_PIXEL: the size estimation samples row stripes
+#define NUM_RUNS 200
+
+/* compile the source directly to compare the pixel source with the same image data given as buffer */
+#include "../src/cgif_raw.c"
+
+static uint32_t nextRand(uint32_t* pSeed) {
+  *pSeed = *pSeed * 1103515245 + 12345;
+  return (*pSeed >> 16) & 0x7FFF;
+}
+
+/* reference: crop the area of the frame out of the image and mark the unchanged pixels transparent (as cgif did before encoding) */
+static void cropRef(const CGIFRaw_FrameConfig* pConfig, const CGIFRaw_PixelSrc* pSrc, uint8_t* pOut) {
+  for(int y = 0; y < pConfig->height; ++y) {
+    for(int x = 0; x < pConfig->width; ++x) {
+      const uint32_t i     = (pConfig->top + y) * pSrc->stride + pConfig->left + x;
+      const uint8_t  iCur  = pSrc->pImageData[i];
+      uint8_t        color = (pSrc->pMap) ? pSrc->pMap[iCur] : iCur;
+      if(pSrc->pBefImageData && (pSrc->pIDCur[iCur] == pSrc->pIDBef[pSrc->pBefImageData[i]] || pSrc->pIDCur[iCur] == CGIF_RAW_PIXEL_ID_ANY)) {
+        color = pConfig->transIndex;
+      }
+      pOut[y * pConfig->width + x] = color;
+    }
+  }
+}
+
+int main(void) {
+  CGIFRaw*            pGIF;
+  CGIFRaw_Config      gConfig;
+  CGIFRaw_FrameConfig fConfig;
+  CGIFRaw_PixelSrc    src;
+  CGIFRaw_EncFrame    encSrc, encRef;
+  uint8_t*            pCur = malloc(WIDTH * HEIGHT);
+  uint8_t*            pBef = malloc(WIDTH * HEIGHT);
+  uint8_t*            pRef = malloc(WIDTH * HEIGHT);
+  uint8_t             aPalette[16 * 3];
+  uint8_t             aMap[16];
+  uint32_t            aIDCur[256], aIDBef[256];
+  uint32_t            sizeSrc, sizeRef;
+  uint32_t            seed = 42;
+  ByteBuffer          out  = {NULL, 0};
+  int                 r = 0;
+
+  if(pCur == NULL || pBef == NULL || pRef == NULL) {
+    return 1;
+  }
+  memset(aPalette, 0, sizeof(aPalette));
+  memset(&gConfig, 0, sizeof(gConfig));
+  gConfig.pWriteFn  = writeFn;
+  gConfig.pContext  = &out;
+  gConfig.pGCT      = aPalette;
+  gConfig.sizeGCT   = 16;
+  gConfig.attrFlags = CGIF_RAW_ATTR_IS_ANIMATED;
+  gConfig.width     = WIDTH;
+  gConfig.height    = HEIGHT;
+  pGIF = cgif_raw_newgif(&gConfig);
+  if(pGIF == NULL) {
+    return 1;
+  }
+  for(int run = 0; run < NUM_RUNS && !r; ++run) {
+    // frame before + current frame: noise or blocks, partially unchanged
+    const int isNoise = nextRand(&seed) % 2;
+    for(int i = 0; i < WIDTH * HEIGHT; ++i) {
+      pBef[i] = (isNoise) ? (int)(nextRand(&seed) % 15) : ((i % WIDTH) / 20 + (i / WIDTH) / 20) % 15;
+      pCur[i] = (nextRand(&seed) % 4) ? pBef[i] : nextRand(&seed) % 15;
+    }
+    // pixel IDs: color 0 and 1 look the same, color 2 of the current frame is "transparent" (user-provided)
+    for(int c = 0; c < 256; ++c) {
+      aIDCur[c] = (c == 1) ? 0 : c;
+      aIDBef[c] = (c == 1) ? 0 : c;
+    }
+    if(run % 3 == 0) {
+      aIDCur[2] = CGIF_RAW_PIXEL_ID_ANY;
+    }
+    for(int c = 0; c < 16; ++c) {
+      aMap[c] = (c == 15) ? 14 : c;
+    }
+    memset(&src, 0, sizeof(src));
+    src.pImageData    = pCur;
+    src.pBefImageData = (run % 4) ? pBef : NULL;
+    src.pIDCur        = aIDCur;
+    src.pIDBef        = aIDBef;
+    src.pMap          = (run % 5 < 2) ? aMap : NULL;
+    src.stride        = WIDTH;
+    // random area (full frame every now and then)
+    memset(&fConfig, 0, sizeof(fConfig));
+    fConfig.left       = (run % 7) ? nextRand(&seed) % WIDTH : 0;
+    fConfig.top        = (run % 7) ? nextRand(&seed) % HEIGHT : 0;
+    fConfig.width      = (run % 7) ? 1 + nextRand(&seed) % (WIDTH - fConfig.left) : WIDTH;
+    fConfig.height     = (run % 7) ? 1 + nextRand(&seed) % (HEIGHT - fConfig.top) : HEIGHT;
+    fConfig.attrFlags  = CGIF_RAW_FRAME_ATTR_HAS_TRANS | ((run % 2) ? CGIF_RAW_FRAME_ATTR_INTERLACED : 0);
+    fConfig.transIndex = 15;
+    // same result as the cropped image data
+    cropRef(&fConfig, &src, pRef);
+    fConfig.pImageData = pRef;
+    fConfig.pSrc       = NULL;
+    if(cgif_raw_encodeframe(pGIF, &fConfig, &encRef) != CGIF_OK || cgif_raw_estimateframe(pGIF, &fConfig, &sizeRef) != CGIF_OK) {
+      fputs("failed to encode reference\n", stderr);
+      r = 1;
+      break;
+    }
+    fConfig.pImageData = NULL;
+    fConfig.pSrc       = &src;
+    if(cgif_raw_encodeframe(pGIF, &fConfig, &encSrc) != CGIF_OK || cgif_raw_estimateframe(pGIF, &fConfig, &sizeSrc) != CGIF_OK) {
+      fputs("failed to encode pixel source\n", stderr);
+      cgif_raw_freeframe(&encRef);
+      r = 1;
+      break;
+    }
+    if(encSrc.sizeRasterData != encRef.sizeRasterData || memcmp(encSrc.pRasterData, encRef.pRasterData, encRef.sizeRasterData) || sizeSrc != sizeRef) {
+      fprintf(stderr, "pixel source differs (run %d: %dx%d at %d/%d)\n", run, fConfig.width, fConfig.height, fConfig.left, fConfig.top);
+      r = 1;
+    }
+    cgif_raw_freeframe(&encSrc);
+    cgif_raw_freeframe(&encRef);
+  }
+  cgif_raw_close(pGIF);
+  free(out.pData);
+  free(pCur);
+  free(pBef);
+  free(pRef);
+  return r;
+}
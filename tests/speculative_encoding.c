@@ -0,0 +1,121 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "cgif.h"
+#include "test_output.h"
+
+#define WIDTH      64
+#define HEIGHT     64
+#define NUM_FRAMES 6
+
+// pContext of the GIF: the output (first member, for writeFn) and the checks of the per-frame statistics
+typedef struct {
+  ByteBuffer buf;
+  uint32_t   numStats;
+  uint32_t   numNoTransparency;
+  int        statsOK;
+} TestContext;
+
+static void pFrameStatsFn(void* pContext, const CGIF_FrameStats* pStats) {
+  TestContext* pCtx = (TestContext*)pContext;
+
+  // every frame apart from the first one has three variants: full frame, diff window and diff window + transparency
+  if(pStats->frameIndex != pCtx->numStats || pStats->numVariants != ((pStats->frameIndex) ? 3 : 1)) {
+    pCtx->statsOK = 0;
+  }
+  if(pStats->frameIndex && !(pStats->genFlags & CGIF_FRAME_GEN_USE_TRANSPARENCY)) {
+    ++(pCtx->numNoTransparency);
+  }
+  ++(pCtx->numStats);
+}
+
+static uint32_t nextRand(uint32_t* pSeed) {
+  *pSeed = *pSeed * 1103515245 + 12345;
+  return (*pSeed >> 16) & 0x7FFF;
+}
+
+static int encodeGIF(TestContext* pCtx, uint32_t genFlags) {
+  CGIF*            pGIF;
+  CGIF_Config      gConfig;
+  CGIF_FrameConfig fConfig;
+  uint8_t          aImageData[WIDTH * HEIGHT];
+  uint8_t          aPalette[] = {
+    0x00, 0x00, 0x00, // black
+    0xFF, 0x00, 0x00, // red
+    0x00, 0xFF, 0x00, // green
+    0x00, 0x00, 0xFF, // blue
+  };
+  uint32_t         seed = 42;
+  cgif_result      r;
+
+  memset(&gConfig, 0, sizeof(CGIF_Config));
+  gConfig.attrFlags               = CGIF_ATTR_IS_ANIMATED;
+  gConfig.genFlags                = genFlags;
+  gConfig.width                   = WIDTH;
+  gConfig.height                  = HEIGHT;
+  gConfig.pGlobalPalette          = aPalette;
+  gConfig.numGlobalPaletteEntries = 4;
+  gConfig.pWriteFn                = writeFn;
+  gConfig.pFrameStatsFn           = pFrameStatsFn;
+  gConfig.pContext                = pCtx;
+  pGIF = cgif_newgif(&gConfig);
+  if(pGIF == NULL) {
+    fputs("failed to create new GIF via cgif_newgif()\n", stderr);
+    return 1;
+  }
+  memset(aImageData, 0, WIDTH * HEIGHT);
+  memset(&fConfig, 0, sizeof(CGIF_FrameConfig));
+  fConfig.pImageData = aImageData;
+  fConfig.delay      = 10;
+  fConfig.genFlags   = CGIF_FRAME_GEN_USE_TRANSPARENCY | CGIF_FRAME_GEN_USE_DIFF_WINDOW;
+  for(int f = 0; f < NUM_FRAMES; ++f) {
+    if(f % 2) {
+      for(int k = 0; k < 20; ++k) {
+        aImageData[nextRand(&seed) % (WIDTH * HEIGHT)] = nextRand(&seed) % 4;
+      }
+    } else {
+      // shifted diagonal stripes: few pixels match the frame before, transparency just increases the LZW code length
+      for(int i = 0; i < WIDTH * HEIGHT; ++i) {
+        aImageData[i] = ((i % WIDTH + i / WIDTH + f) / 2) % 4;
+      }
+    }
+    r = cgif_addframe(pGIF, &fConfig);
+    if(r != CGIF_OK) {
+      break;
+    }
+  }
+  r = cgif_close(pGIF);
+  if(r != CGIF_OK) {
+    fprintf(stderr, "failed to create GIF. error code: %d\n", r);
+    return 2;
+  }
+  return 0;
+}
+
+int main(void) {
+  TestContext ctxSpec  = {{NULL, 0}, 0, 0, 1};
+  TestContext ctxPlain = {{NULL, 0}, 0, 0, 1};
+  int         r        = 0;
+
+  if(encodeGIF(&ctxSpec, CGIF_GEN_SPECULATIVE_ENCODING)) {
+    r = 2;
+  } else if(encodeGIF(&ctxPlain, 0)) {
+    r = 3;
+  } else if(!ctxSpec.statsOK || ctxSpec.numStats != NUM_FRAMES || ctxSpec.numNoTransparency == 0) {
+    // check that the per-frame statistics were reported
+    fputs("unexpected per-frame statistics\n", stderr);
+    r = 4;
+  } else if(ctxSpec.buf.sizeData > ctxPlain.buf.sizeData) {
+    // the speculative encoding must never be larger than the default one
+    fprintf(stderr, "speculative encoding is larger: %zu > %zu\n", ctxSpec.buf.sizeData, ctxPlain.buf.sizeData);
+    r = 5;
+  } else if(!writeFile("speculative_encoding.gif", &ctxSpec.buf)) {
+    fputs("failed to write output file\n", stderr);
+    r = 1;
+  }
+  free(ctxSpec.buf.pData);
+  free(ctxPlain.buf.pData);
+  return r;
+}
@@ -0,0 +1,234 @@
+/* output helpers shared by the tests: collect the GIF in memory (pWriteFn), compare it, write it to a file (checked by tests.sha256) and decode it */
+#ifndef CGIF_TEST_OUTPUT_H
+#define CGIF_TEST_OUTPUT_H
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+
+// output data collected by writeFn (or read by readFile)
+typedef struct {
+  uint8_t* pData;
+  size_t   sizeData;
+} ByteBuffer;
+
+/* pWriteFn: append the data to the ByteBuffer passed as pContext */
+static inline int writeFn(void* pContext, const uint8_t* pData, const size_t numBytes) {
+  ByteBuffer* pBuf = (ByteBuffer*)pContext;
+  uint8_t*    pNew = realloc(pBuf->pData, pBuf->sizeData + numBytes);
+  if(pNew == NULL) {
+    return -1;
+  }
+  memcpy(pNew + pBuf->sizeData, pData, numBytes);
+  pBuf->pData     = pNew;
+  pBuf->sizeData += numBytes;
+  return 0;
+}
+
+static inline int isEqual(const ByteBuffer* pA, const ByteBuffer* pB) {
+  return pA->sizeData == pB->sizeData && !memcmp(pA->pData, pB->pData, pA->sizeData);
+}
+
+/* write the data to the file at path. returns 0 on error */
+static inline int writeFile(const char* path, const ByteBuffer* pBuf) {
+  FILE* pFile = fopen(path, "wb");
+  int   r;
+
+  if(pFile == NULL) {
+    return 0;
+  }
+  r = (fwrite(pBuf->pData, pBuf->sizeData, 1, pFile) == 1);
+  return (fclose(pFile) == 0) && r;
+}
+
+/* read the file at path. returns 0 on error */
+static inline int readFile(const char* path, ByteBuffer* pOut) {
+  FILE* pFile = fopen(path, "rb");
+  long  size;
+  int   r = 0;
+
+  if(pFile == NULL) {
+    return 0;
+  }
+  if(!fseek(pFile, 0, SEEK_END) && (size = ftell(pFile)) > 0 && !fseek(pFile, 0, SEEK_SET)) {
+    pOut->pData    = malloc(size);
+    pOut->sizeData = size;
+    r = pOut->pData && fread(pOut->pData, size, 1, pFile) == 1;
+  }
+  fclose(pFile);
+  return r;
+}
+
+#define TEST_PIXEL_NONE 0xFF000000uL // transparent pixel of a decoded canvas (background)
+
+/* called by decodeGIF with the canvas of each displayed frame (RGB value or TEST_PIXEL_NONE per pixel). returns 0 to continue */
+typedef int decode_frame_fn(void* pContext, const uint32_t* aCanvas, int iFrame);
+
+/* reference decoder: decode the GIF (not interlaced) and composite its frames (frames with delay 0 are not displayed on their own).
+   returns the number of displayed frames or -1 on error */
+static inline int decodeGIF(const ByteBuffer* pGIF, decode_frame_fn* pFrameFn, void* pContext) {
+  const uint8_t* p    = pGIF->pData;
+  const uint8_t* pEnd = pGIF->pData + pGIF->sizeData;
+  const uint8_t* pGCT = NULL;
+  uint32_t*      pCanvas = NULL;
+  uint32_t*      pSaved  = NULL;
+  uint8_t*       pPixels = NULL;
+  uint8_t*       pRaster = NULL;
+  uint16_t       aPrefix[4096];
+  uint8_t        aSuffix[4096], aStack[4097];
+  int            width, height, disposal = 0, hasTrans = 0, transIndex = 0, delay = 0;
+  int            numFrames = 0, r = 0;
+
+  if(pGIF->sizeData < 13 || memcmp(p, "GIF89a", 6)) {
+    return -1;
+  }
+  width  = p[6] | (p[7] << 8);
+  height = p[8] | (p[9] << 8);
+  if(p[10] & 0x80) {
+    pGCT = p + 13;
+  }
+  p += 13 + ((p[10] & 0x80) ? 3 * (2 << (p[10] & 7)) : 0); // skip header and global color table
+  pCanvas = malloc(width * height * sizeof(uint32_t));
+  pSaved  = malloc(width * height * sizeof(uint32_t));
+  pPixels = malloc(width * height);
+  pRaster = malloc(pGIF->sizeData);
+  if(pCanvas == NULL || pSaved == NULL || pPixels == NULL || pRaster == NULL) {
+    r = -1;
+  } else {
+    for(int i = 0; i < width * height; ++i) {
+      pCanvas[i] = TEST_PIXEL_NONE;
+    }
+  }
+  while(!r && p < pEnd && *p != ';') {
+    if(p[0] == '!') {
+      if(p[1] == 0xF9) { // graphic control extension
+        disposal   = (p[3] >> 2) & 7;
+        hasTrans   = p[3] & 1;
+        delay      = p[4] | (p[5] << 8);
+        transIndex = p[6];
+      }
+      p += 2;
+      while(p < pEnd && *p) {
+        p += *p + 1;
+      }
+      ++p;
+    } else if(p[0] == ',') {
+      const int      left = p[1] | (p[2] << 8), top = p[3] | (p[4] << 8), w = p[5] | (p[6] << 8), h = p[7] | (p[8] << 8);
+      const int      flags = p[9];
+      const uint8_t* pCT   = (flags & 0x80) ? p + 10 : pGCT;
+      const int      sizeCT = (flags & 0x80) ? (2 << (flags & 7)) : (pGCT) ? (2 << (pGIF->pData[10] & 7)) : 0;
+      int            codeSize, codeLen, clearCode, nextCode, prevCode = -1, firstChar = 0, numPixel = 0;
+      size_t         sizeRaster = 0, bitPos = 0;
+
+      if(left + w > width || top + h > height || (flags & 0x40)) {
+        r = -1; // out of bounds or interlaced
+        break;
+      }
+      p += 10 + ((flags & 0x80) ? 3 * sizeCT : 0);
+      codeSize = *p++;
+      // collect the sub-blocks
+      while(p < pEnd && *p) {
+        memcpy(pRaster + sizeRaster, p + 1, *p);
+        sizeRaster += *p;
+        p          += *p + 1;
+      }
+      ++p;
+      // LZW decoding
+      clearCode = 1 << codeSize;
+      codeLen   = codeSize + 1;
+      nextCode  = clearCode + 2;
+      while(bitPos + codeLen <= sizeRaster * 8 && numPixel < w * h) {
+        int code = 0, inCode, numStack = 0;
+        for(int b = 0; b < codeLen; ++b, ++bitPos) {
+          code |= ((pRaster[bitPos >> 3] >> (bitPos & 7)) & 1) << b;
+        }
+        if(code == clearCode) {
+          codeLen  = codeSize + 1;
+          nextCode = clearCode + 2;
+          prevCode = -1;
+          continue;
+        }
+        if(code == clearCode + 1) {
+          break; // end code
+        }
+        if(prevCode < 0) {
+          if(code >= clearCode) {
+            break; // invalid first code
+          }
+          pPixels[numPixel++] = firstChar = code;
+          prevCode = code;
+          continue;
+        }
+        if(code > nextCode) {
+          break; // invalid code
+        }
+        inCode = code;
+        if(code == nextCode) {
+          aStack[numStack++] = firstChar; // code is not in the dictionary yet (KwKwK)
+          code = prevCode;
+        }
+        while(code >= clearCode) {
+          aStack[numStack++] = aSuffix[code];
+          code               = aPrefix[code];
+        }
+        firstChar          = code;
+        aStack[numStack++] = firstChar;
+        if(nextCode < 4096) {
+          aPrefix[nextCode] = prevCode;
+          aSuffix[nextCode] = firstChar;
+          ++nextCode;
+          if(nextCode == (1 << codeLen) && codeLen < 12) {
+            ++codeLen;
+          }
+        }
+        while(numStack && numPixel < w * h) {
+          pPixels[numPixel++] = aStack[--numStack];
+        }
+        prevCode = inCode;
+      }
+      if(numPixel != w * h) {
+        r = -1;
+        break;
+      }
+      // draw the frame
+      memcpy(pSaved, pCanvas, width * height * sizeof(uint32_t));
+      for(int y = 0; y < h; ++y) {
+        for(int x = 0; x < w; ++x) {
+          const uint8_t c = pPixels[y * w + x];
+          if(!hasTrans || c != transIndex) {
+            if(c >= sizeCT) {
+              r = -1; // index out of the color table
+              break;
+            }
+            pCanvas[(top + y) * width + left + x] = ((uint32_t)pCT[3 * c] << 16) | ((uint32_t)pCT[3 * c + 1] << 8) | pCT[3 * c + 2];
+          }
+        }
+      }
+      if(!r && delay) {
+        r = (pFrameFn(pContext, pCanvas, numFrames) == 0) ? 0 : -1;
+        ++numFrames;
+      }
+      // dispose the frame
+      if(disposal == 2) {
+        for(int y = 0; y < h; ++y) {
+          for(int x = 0; x < w; ++x) {
+            pCanvas[(top + y) * width + left + x] = TEST_PIXEL_NONE;
+          }
+        }
+      } else if(disposal == 3) {
+        memcpy(pCanvas, pSaved, width * height * sizeof(uint32_t));
+      }
+      disposal = hasTrans = delay = 0;
+    } else {
+      r = -1;
+    }
+  }
+  free(pCanvas);
+  free(pSaved);
+  free(pPixels);
+  free(pRaster);
+  return (r) ? -1 : numFrames;
+}
+
+#endif
@@ -0,0 +1,127 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "cgif.h"
+#include "test_output.h"
+
+#define WIDTH       300 // not a multiple of CGIF_TILE_SIZE: smaller tiles at the right/bottom edge
+#define HEIGHT      200
+#define NUM_FRAMES  40
+#define NUM_TILES_X ((WIDTH + CGIF_TILE_SIZE - 1) / CGIF_TILE_SIZE)
+#define NUM_TILES   (NUM_TILES_X * ((HEIGHT + CGIF_TILE_SIZE - 1) / CGIF_TILE_SIZE))
+
+static const uint8_t aPalette[] = {
+  0xFF, 0xFF, 0xFF, // white
+  0x00, 0x00, 0x00, // black
+  0xC0, 0xC0, 0xC0, // grey
+  0xFF, 0x00, 0x00, // red
+  0x00, 0x00, 0xFF, // blue
+};
+
+/* render frame f: a cursor moving over stripes (across tile borders), a blinking dot at the bottom right corner (transient overlay),
+   every 6th frame is repeated */
+static void renderFrame(uint8_t* pImageData, int f) {
+  f -= f / 6;
+  for(int y = 0; y < HEIGHT; ++y) {
+    for(int x = 0; x < WIDTH; ++x) {
+      pImageData[y * WIDTH + x] = (x / 10) % 2 * 2;
+    }
+  }
+  for(int y = 60; y < 70; ++y) {
+    for(int x = 7 * f; x < 7 * f + 4; ++x) {
+      pImageData[y * WIDTH + x] = 3 + f % 2;
+    }
+  }
+  if(f % 4 == 1) {
+    pImageData[(HEIGHT - 1) * WIDTH + WIDTH - 2] = 1;
+  }
+}
+
+/* mark the tiles that differ from the frame before (plus some unchanged ones, dirty tiles are allowed to be unchanged) */
+static void getDirtyTiles(const uint8_t* pCur, const uint8_t* pBef, int f, uint8_t* aDirty) {
+  for(int t = 0; t < NUM_TILES; ++t) {
+    aDirty[t] = (t % 7 == f % 7);
+  }
+  for(int y = 0; y < HEIGHT; ++y) {
+    for(int x = 0; x < WIDTH; ++x) {
+      if(pCur[y * WIDTH + x] != pBef[y * WIDTH + x]) {
+        aDirty[(y / CGIF_TILE_SIZE) * NUM_TILES_X + x / CGIF_TILE_SIZE] = 1;
+      }
+    }
+  }
+}
+
+/* create the animation: with dirty tiles (useDirtyTiles) or without. frame 20 has a local color table (no tile tags) */
+static cgif_result createGIF(uint32_t genFlags, int useDirtyTiles, ByteBuffer* pOut) {
+  CGIF*            pGIF;
+  CGIF_Config      gConfig;
+  CGIF_FrameConfig fConfig;
+  uint8_t          aImageData[WIDTH * HEIGHT];
+  uint8_t          aBefore[WIDTH * HEIGHT];
+  uint8_t          aDirty[NUM_TILES];
+
+  memset(&gConfig, 0, sizeof(CGIF_Config));
+  gConfig.width                   = WIDTH;
+  gConfig.height                  = HEIGHT;
+  gConfig.pGlobalPalette          = (uint8_t*)aPalette;
+  gConfig.numGlobalPaletteEntries = sizeof(aPalette) / 3;
+  gConfig.attrFlags               = CGIF_ATTR_IS_ANIMATED;
+  gConfig.genFlags                = genFlags | CGIF_GEN_OPTIM_DISPOSAL;
+  gConfig.pWriteFn                = writeFn;
+  gConfig.pContext                = pOut;
+  pGIF = cgif_newgif(&gConfig);
+  if(pGIF == NULL) {
+    return CGIF_ERROR;
+  }
+  memset(aBefore, 0, sizeof(aBefore));
+  for(int f = 0; f < NUM_FRAMES; ++f) {
+    renderFrame(aImageData, f);
+    memset(&fConfig, 0, sizeof(CGIF_FrameConfig));
+    fConfig.pImageData = aImageData;
+    fConfig.delay      = 5;
+    fConfig.genFlags   = CGIF_FRAME_GEN_USE_TRANSPARENCY | CGIF_FRAME_GEN_USE_DIFF_WINDOW;
+    if(f == 20) {
+      fConfig.attrFlags              = CGIF_FRAME_ATTR_USE_LOCAL_TABLE;
+      fConfig.pLocalPalette          = (uint8_t*)aPalette;
+      fConfig.numLocalPaletteEntries = sizeof(aPalette) / 3;
+    }
+    if(useDirtyTiles) {
+      getDirtyTiles(aImageData, aBefore, f, aDirty);
+      cgif_addframe_tiles(pGIF, &fConfig, aDirty);
+    } else {
+      cgif_addframe(pGIF, &fConfig);
+    }
+    memcpy(aBefore, aImageData, sizeof(aBefore));
+  }
+  return cgif_close(pGIF);
+}
+
+int main(void) {
+  ByteBuffer ref = {NULL, 0};
+  ByteBuffer out = {NULL, 0};
+  int        r = 0;
+
+  if(createGIF(0, 0, &ref) != CGIF_OK) {
+    fputs("failed to create GIF\n", stderr);
+    r = 1;
+  }
+  // tile hashes and/or dirty tiles: same output as comparing the full frames (synchronous and with the encoder thread)
+  for(int mode = 0; !r && mode < 6; ++mode) {
+    const uint32_t genFlags = ((mode % 3 != 1) ? CGIF_GEN_TILE_HASH : 0) | ((mode >= 3) ? CGIF_GEN_ASYNC_ENCODING : 0);
+    free(out.pData);
+    out.pData    = NULL;
+    out.sizeData = 0;
+    if(createGIF(genFlags, mode % 3 != 0, &out) != CGIF_OK || !isEqual(&out, &ref)) {
+      fprintf(stderr, "unexpected output with tiles (hash: %d, dirty tiles: %d, async: %d)\n", mode % 3 != 1, mode % 3 != 0, mode >= 3);
+      r = 1;
+    }
+  }
+  if(!r && !writeFile("tile_hash.gif", &out)) {
+    r = 1;
+  }
+  free(ref.pData);
+  free(out.pData);
+  return r;
+}
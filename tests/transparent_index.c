@@ -0,0 +1,219 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "cgif.h"
+#include "test_output.h"
+
+#define WIDTH      64
+#define HEIGHT     48
+#define NUM_FRAMES 12
+
+static uint8_t aPalette[256 * 3];
+
+/* alpha animation: every third frame has an alpha channel (a moving box of transparent pixels) */
+static int isAlphaFrame(int f) {
+  return (f % 3 == 1);
+}
+
+/* transparent index of the alpha frames: the last color of a full table (a color of the other frames), after the table otherwise */
+static uint8_t getAlphaIndex(uint16_t numColors) {
+  return (numColors == 256) ? 255 : numColors;
+}
+
+/* render frame f of the alpha animation: the box is opaque (index of the alpha frames, if possible) in the other frames */
+static void renderAlphaFrame(uint8_t* pImageData, int f, uint16_t numColors) {
+  const uint8_t iBox = isAlphaFrame(f) ? getAlphaIndex(numColors) : (numColors == 256) ? 255 : 3;
+
+  for(int y = 0; y < HEIGHT; ++y) {
+    for(int x = 0; x < WIDTH; ++x) {
+      pImageData[y * WIDTH + x] = (x >= 10 + 2 * f && x < 26 + 2 * f && y >= 8 && y < 24) ? iBox : ((x + y) % (numColors - 1));
+    }
+  }
+}
+
+/* decodeGIF callback: compare the canvas with the rendered frame (pixels of the alpha channel are transparent) */
+static int checkAlphaFrame(void* pContext, const uint32_t* aCanvas, int iFrame) {
+  const uint16_t numColors = *(const uint16_t*)pContext;
+  uint8_t        aImageData[WIDTH * HEIGHT];
+
+  if(iFrame >= NUM_FRAMES) {
+    return -1;
+  }
+  renderAlphaFrame(aImageData, iFrame, numColors);
+  for(int i = 0; i < WIDTH * HEIGHT; ++i) {
+    const uint8_t  c        = aImageData[i];
+    const uint32_t expected = (isAlphaFrame(iFrame) && c == getAlphaIndex(numColors)) ? TEST_PIXEL_NONE : ((uint32_t)aPalette[3 * c] << 16) | ((uint32_t)aPalette[3 * c + 1] << 8) | aPalette[3 * c + 2];
+    if(aCanvas[i] != expected) {
+      fprintf(stderr, "alpha animation (%d colors): pixel %d of frame %d does not match\n", numColors, i, iFrame);
+      return -1;
+    }
+  }
+  return 0;
+}
+
+/* render frame f of the dot animation (full color table): dots in a moving box, every other dot keeps its color.
+   the dots that change use the colors after the first 16 several times. the dots that keep their color use the first 16 colors:
+   in the two columns the box moves on to, each color twice, but one color (merged first) once and the next color three times */
+static void renderDotFrame(uint8_t* pImageData, int f) {
+  for(int y = 0; y < HEIGHT; ++y) {
+    for(int x = 0; x < WIDTH; ++x) {
+      const int isDot = (x >= 2 * f && x < 2 * f + 48 && y >= 8 && y < 40);
+      const int iDot  = (x - 2 * f) + 48 * (y - 8);
+      uint8_t   c     = (y / 2) % 16;
+      if((x % 2) && c == (x / 2) % 16) {
+        c = (c + 1) % 16;
+      }
+      pImageData[y * WIDTH + x] = (!isDot) ? 16 + (y * WIDTH + x) / 4 % 240 : ((x + y) % 2) ? 16 + (iDot / 2 + f * 31) % 240 : c;
+    }
+  }
+}
+
+/* nearest other color of the table (see findTransIndex) */
+static uint8_t getNearestColor(uint8_t c) {
+  uint32_t dist = UINT32_MAX;
+  uint8_t  iNearest = 0;
+
+  for(int j = 0; j < 256; ++j) {
+    const int      dR = (int)aPalette[c * 3] - aPalette[j * 3], dG = (int)aPalette[c * 3 + 1] - aPalette[j * 3 + 1], dB = (int)aPalette[c * 3 + 2] - aPalette[j * 3 + 2];
+    const uint32_t d  = (uint32_t)(dR * dR + dG * dG + dB * dB);
+    if(j != c && d < dist) {
+      dist     = d;
+      iNearest = j;
+    }
+  }
+  return iNearest;
+}
+
+/* decodeGIF callback: compare the canvas with the rendered frame.
+   pixels of one color of the frame may show its nearest color instead (lossy transparency), wrong pixels of earlier frames must not stay */
+static int checkDotFrame(void* pContext, const uint32_t* aCanvas, int iFrame) {
+  uint8_t aImageData[WIDTH * HEIGHT];
+  int     iMerged = -1;
+
+  if(iFrame >= NUM_FRAMES) {
+    return -1;
+  }
+  renderDotFrame(aImageData, iFrame);
+  for(int i = 0; i < WIDTH * HEIGHT; ++i) {
+    const uint8_t c = aImageData[i];
+    const uint8_t n = getNearestColor(c);
+    if(aCanvas[i] == (((uint32_t)aPalette[3 * c] << 16) | ((uint32_t)aPalette[3 * c + 1] << 8) | aPalette[3 * c + 2])) {
+      continue;
+    }
+    if((iMerged >= 0 && c != iMerged) || aCanvas[i] != (((uint32_t)aPalette[3 * n] << 16) | ((uint32_t)aPalette[3 * n + 1] << 8) | aPalette[3 * n + 2])) {
+      fprintf(stderr, "dot animation: pixel %d of frame %d does not match\n", i, iFrame);
+      return -1;
+    }
+    iMerged = c;
+  }
+  return 0;
+}
+
+/* create the dot animation with lossy transparency */
+static cgif_result createDotGIF(ByteBuffer* pOut) {
+  CGIF*            pGIF;
+  CGIF_Config      gConfig;
+  CGIF_FrameConfig fConfig;
+  uint8_t          aImageData[WIDTH * HEIGHT];
+
+  memset(&gConfig, 0, sizeof(CGIF_Config));
+  gConfig.width                   = WIDTH;
+  gConfig.height                  = HEIGHT;
+  gConfig.pGlobalPalette          = aPalette;
+  gConfig.numGlobalPaletteEntries = 256;
+  gConfig.attrFlags               = CGIF_ATTR_IS_ANIMATED;
+  gConfig.pWriteFn                = writeFn;
+  gConfig.pContext                = pOut;
+  pGIF = cgif_newgif(&gConfig);
+  if(pGIF == NULL) {
+    return CGIF_ERROR;
+  }
+  for(int f = 0; f < NUM_FRAMES; ++f) {
+    renderDotFrame(aImageData, f);
+    memset(&fConfig, 0, sizeof(CGIF_FrameConfig));
+    fConfig.pImageData = aImageData;
+    fConfig.delay      = 10;
+    fConfig.genFlags   = CGIF_FRAME_GEN_USE_TRANSPARENCY | CGIF_FRAME_GEN_USE_DIFF_WINDOW | CGIF_FRAME_GEN_USE_LOSSY_TRANSPARENCY;
+    cgif_addframe(pGIF, &fConfig);
+  }
+  return cgif_close(pGIF);
+}
+
+/* create the alpha animation with transparency optimization */
+static cgif_result createAlphaGIF(uint16_t numColors, ByteBuffer* pOut) {
+  CGIF*            pGIF;
+  CGIF_Config      gConfig;
+  CGIF_FrameConfig fConfig;
+  uint8_t          aImageData[WIDTH * HEIGHT];
+
+  memset(&gConfig, 0, sizeof(CGIF_Config));
+  gConfig.width                   = WIDTH;
+  gConfig.height                  = HEIGHT;
+  gConfig.pGlobalPalette          = aPalette;
+  gConfig.numGlobalPaletteEntries = numColors;
+  gConfig.attrFlags               = CGIF_ATTR_IS_ANIMATED;
+  gConfig.pWriteFn                = writeFn;
+  gConfig.pContext                = pOut;
+  pGIF = cgif_newgif(&gConfig);
+  if(pGIF == NULL) {
+    return CGIF_ERROR;
+  }
+  for(int f = 0; f < NUM_FRAMES; ++f) {
+    renderAlphaFrame(aImageData, f, numColors);
+    memset(&fConfig, 0, sizeof(CGIF_FrameConfig));
+    fConfig.pImageData = aImageData;
+    fConfig.delay      = 10;
+    fConfig.genFlags   = CGIF_FRAME_GEN_USE_TRANSPARENCY | CGIF_FRAME_GEN_USE_DIFF_WINDOW;
+    if(isAlphaFrame(f)) {
+      fConfig.attrFlags  = CGIF_FRAME_ATTR_HAS_ALPHA;
+      fConfig.transIndex = getAlphaIndex(numColors);
+    }
+    cgif_addframe(pGIF, &fConfig);
+  }
+  return cgif_close(pGIF);
+}
+
+int main(void) {
+  ByteBuffer out = {NULL, 0};
+  int        r   = 0;
+
+  // gradient: similar neighbouring colors
+  for(int i = 0; i < 256; ++i) {
+    aPalette[i * 3]     = i;
+    aPalette[i * 3 + 1] = 255 - i;
+    aPalette[i * 3 + 2] = (i * 3) & 0xFF;
+  }
+  // alpha channel with a full color table (transparent index in the table) and with a table that fills the LZW code size:
+  // the transparent pixels of the canvas must not stay after the alpha frames
+  for(int i = 0; !r && i < 2; ++i) {
+    uint16_t numColors = (i == 0) ? 256 : 16;
+    free(out.pData);
+    memset(&out, 0, sizeof(out));
+    if(createAlphaGIF(numColors, &out) != CGIF_OK) {
+      fputs("failed to create GIF\n", stderr);
+      r = 1;
+    } else if(decodeGIF(&out, checkAlphaFrame, &numColors) != NUM_FRAMES) {
+      fprintf(stderr, "reference decoder: alpha animation with %d colors does not match\n", numColors);
+      r = 1;
+    }
+  }
+  // lossy transparency: the pixels of the merged color are repainted by the next frame
+  if(!r) {
+    free(out.pData);
+    memset(&out, 0, sizeof(out));
+    if(createDotGIF(&out) != CGIF_OK) {
+      fputs("failed to create GIF\n", stderr);
+      r = 1;
+    } else if(decodeGIF(&out, checkDotFrame, NULL) != NUM_FRAMES) {
+      fputs("reference decoder: dot animation does not match\n", stderr);
+      r = 1;
+    }
+  }
+  if(!r && !writeFile("transparent_index.gif", &out)) {
+    r = 1;
+  }
+  free(out.pData);
+  return r;
+}